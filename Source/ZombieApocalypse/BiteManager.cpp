@@ -1,6 +1,6 @@
 #include "BiteManager.h"
 #include "Engine/World.h"
-#include "EngineUtils.h"
+#include "PopulationRegistry.h"
 
 // Sets default values
 ABiteManager::ABiteManager() {
@@ -71,7 +71,7 @@ void ABiteManager::SchedulePendingTransformations() {
     if (!SimulationController)
         return;
 
-    int32 CurrentDay = SimulationController->TimeStepsFinished;
+    int32 CurrentDay = SimulationController->GetSnapshot().TimeStepsFinished;
     
     // Only start processing transformations after day 15 (when simulation allows it)
     if (CurrentDay < 15) {
@@ -109,7 +109,7 @@ void ABiteManager::CheckForTransformations() {
     if (!SimulationController)
         return;
 
-    int32 CurrentDay = SimulationController->TimeStepsFinished;
+    int32 CurrentDay = SimulationController->GetSnapshot().TimeStepsFinished;
     
     // Don't process any transformations before day 15
     if (CurrentDay < 15) {
@@ -118,7 +118,7 @@ void ABiteManager::CheckForTransformations() {
 
     if (bSyncWithSimulationController) {
         // Calculate how many actors should transform based on simulation controller's conveyor outflow
-        float SimulationBitten = SimulationController->Bitten;
+        float SimulationBitten = SimulationController->GetSnapshot().Bitten;
         float PreviousSimulationBitten = LastKnownSimulationBitten; // You'll need to track this
         
         // If simulation bitten population decreased, it means some transformed to zombies
@@ -144,13 +144,9 @@ int32 ABiteManager::GetActiveBiteCount() const {
 
 void ABiteManager::FindSimulationController() {
 
-	if (UWorld* World = GetWorld()) {
+	if (UPopulationRegistry* Registry = GetWorld()->GetSubsystem<UPopulationRegistry>()) {
 
-		for (TActorIterator<ASimulationController> ActorIterator(World); ActorIterator; ++ActorIterator) {
-
-			SimulationController = *ActorIterator;
-			break;
-		}
+		SimulationController = Registry->GetSimulationController();
 
 		if (!SimulationController) {
 
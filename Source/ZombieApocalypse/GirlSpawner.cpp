@@ -122,7 +122,7 @@ void AGirlSpawner::ConfigureSpawnedGirl(APopulationMeshActor* SpawnedGirl) {
 	if (!SpawnedGirl) return;
 
 	// Set population type to Susceptible for girls
-	SpawnedGirl->PopulationType = EPopulationType::Susceptible;
+	SpawnedGirl->SetPopulationType(EPopulationType::Susceptible);
 
 	// Assign the mesh assets
 	SpawnedGirl->SusceptibleMesh = GirlMesh;
@@ -5,8 +5,9 @@
 #include "Kismet/KismetMathLibrary.h"
 #include "Engine/Engine.h"
 #include "DrawDebugHelpers.h"
-#include "Kismet/GameplayStatics.h"
 #include "SimulationController.h"
+#include "PopulationSpatialHash.h"
+#include "PopulationRegistry.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "Animation/AnimBlueprint.h"
@@ -17,8 +18,8 @@ bool APopulationMeshActor::bGlobalBiteInProgress = false;
 // Sets default values
 APopulationMeshActor::APopulationMeshActor() {
 
-	// Set this actor to call Tick() every frame. turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	// The registry updates every agent in one loop per population type instead of a tick function per actor
+	PrimaryActorTick.bCanEverTick = false;
 
 	// Create the Root Component
 	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("RootComponent"));
@@ -36,7 +37,6 @@ APopulationMeshActor::APopulationMeshActor() {
 	ScaleMultiplier = 1.0f;
 	bUseSkeletalMesh = true;
 	bAutoFindSimulationController = true;
-	PreviousPopulationValue = 0.0f;
 	PreviousPopulationType = EPopulationType::Susceptible;
 
 	// Bite Management System Defaults
@@ -100,6 +100,12 @@ void APopulationMeshActor::BeginPlay() {
 
 	Super::BeginPlay();
 
+	Registry = GetWorld()->GetSubsystem<UPopulationRegistry>();
+	if (Registry) {
+
+		Registry->Register(this);
+	}
+
 	// AutoFind Simulation Controller if Enabled
 	if (bAutoFindSimulationController && !SimulationController) {
 
@@ -110,14 +116,54 @@ void APopulationMeshActor::BeginPlay() {
 	SetupMeshComponent();
 	UpdateMeshBasedOnPopulation();
 
+	// Transformations are checked when a day has passed instead of every frame
+	if (SimulationController) {
+
+		SimulationController->OnStepCompleted.AddDynamic(this, &APopulationMeshActor::HandleStepCompleted);
+	}
+
 	// Store initial location for wandering and as last valid position
 	InitialLocation = GetActorLocation();
 	LastValidPosition = InitialLocation;
 
+	SpatialHash = GetWorld()->GetSubsystem<UPopulationSpatialHash>();
+	if (SpatialHash) {
+
+		SpatialHash->Add(this);
+	}
+
 	// Calculate world boundaries
 	CalculateWorldBoundaries();
 }
 
+void APopulationMeshActor::EndPlay(const EEndPlayReason::Type EndPlayReason) {
+
+	if (SimulationController) {
+
+		SimulationController->OnStepCompleted.RemoveDynamic(this, &APopulationMeshActor::HandleStepCompleted);
+	}
+
+	if (SpatialHash) {
+
+		SpatialHash->Remove(this);
+	}
+
+	if (Registry) {
+
+		Registry->Unregister(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void APopulationMeshActor::HandleStepCompleted(const FZombieStepDelta& Delta) {
+
+	if (bIsBitten && PopulationType != EPopulationType::Zombie && ShouldTransformToZombie(static_cast<float>(Delta.Step.TimeStepsFinished))) {
+
+		TransformToZombie();
+	}
+}
+
 void APopulationMeshActor::CalculateWorldBoundaries() {
 
 	if (bUseCustomBoundaries) {
@@ -284,59 +330,28 @@ FVector APopulationMeshActor::GetMovementBoundaries(bool& bOutMinBoundary, FVect
 	return (WorldBoundaryMin + WorldBoundaryMax) * 0.5f;
 }
 
-// Called every frame
-void APopulationMeshActor::Tick(float DeltaTime) {
+void APopulationMeshActor::TickSusceptible(float DeltaTime) {
 
-	Super::Tick(DeltaTime);
+	if (bShouldWander) {
 
-	// Updates if there is a Simulation Controller
-	if (!SimulationController) {
-
-		return;
-	}
-
-	if (bIsBitten && PopulationType != EPopulationType::Zombie) {
-
-		CheckForTransformation();
-	}
-
-	// Checks if Population values/type has changed
-	float CurrentPopulationValue = GetCurrentPopulationValue();
-	if (CurrentPopulationValue != PreviousPopulationValue || PopulationType != PreviousPopulationType) {
-
-		UpdateMeshBasedOnPopulation();
-		PreviousPopulationValue = CurrentPopulationValue;
-		PreviousPopulationType = PopulationType;
-	}
-
-	// Bitten Characters remain stationary until they transform
-	if (PopulationType == EPopulationType::Bitten) {
-		// Bitten characters don't move - they remain stationary until transformation
-		return;
+		GirlsHandleWanderingMovement(DeltaTime);
 	}
+}
 
-	// Handle zombie behavior - choose between teleportation or traditional movement/biting
-	if (PopulationType == EPopulationType::Zombie) {
-
-		if (bEnableTeleportation) {
-
-			// Use teleportation behavior like ZombieGirlActor
-			HandleZombieTeleportation(DeltaTime);
-		}
-	}
+void APopulationMeshActor::TickZombie(float DeltaTime) {
 
-	// Handle movement behavior for non-zombie types (only susceptible now, since bitten are excluded above)
-	if (bShouldWander && PopulationType == EPopulationType::Susceptible) {
+	// Choose between teleportation or traditional movement/biting
+	if (bEnableTeleportation) {
 
-		GirlsHandleWanderingMovement(DeltaTime);
+		HandleZombieTeleportation(DeltaTime);
 	}
 
-	else if (PopulationType == EPopulationType::Zombie && !bEnableTeleportation && CurrentTarget && IsValid(CurrentTarget)) {
+	else if (CurrentTarget && IsValid(CurrentTarget)) {
 
 		HandleZombieTargetedMovement(DeltaTime);
 	}
 
-	else if (PopulationType == EPopulationType::Zombie && !bEnableTeleportation && bShouldWander) {
+	else if (bShouldWander) {
 
 		GirlsHandleWanderingMovement(DeltaTime);
 	}
@@ -355,8 +370,38 @@ void APopulationMeshActor::SetupMeshComponent() {
 	}
 }
 
+void APopulationMeshActor::SetPopulationType(EPopulationType NewType) {
+
+	PopulationType = NewType;
+	if (PopulationType != PreviousPopulationType) {
+
+		HandlePopulationTypeChanged();
+	}
+}
+
+void APopulationMeshActor::HandlePopulationTypeChanged() {
+
+	UpdateMeshBasedOnPopulation();
+	UpdateSpatialHash();
+
+	if (Registry) {
+
+		Registry->UpdateType(this);
+	}
+}
+
+void APopulationMeshActor::UpdateSpatialHash() {
+
+	if (SpatialHash) {
+
+		SpatialHash->Update(this);
+	}
+}
+
 void APopulationMeshActor::UpdateMeshBasedOnPopulation() {
 
+	PreviousPopulationType = PopulationType;
+
 	if (!bUseSkeletalMesh) {
 
 		return;
@@ -397,40 +442,12 @@ void APopulationMeshActor::UpdateMeshBasedOnPopulation() {
 	}
 }
 
-float APopulationMeshActor::GetCurrentPopulationValue() const {
-
-	if (!SimulationController) {
-
-		return 0.0f;
-	}
-
-	// Switch Case for returning Correct Stock based on Population Type
-switch (PopulationType) {
-
-		case EPopulationType::Susceptible:
-			return SimulationController->Susceptible;
-
-		case EPopulationType::Bitten:
-			return SimulationController->Bitten;
-
-		case EPopulationType::Zombie:
-			return SimulationController->Zombies;
-
-		default:
-			return 0.0f;
-	}
-}
-
 void APopulationMeshActor::FindSimulationController() {
 
-	// Find the first Simulation Controller in the world
-	if (UWorld* World = GetWorld()) {
+	// The registry caches the world's Simulation Controller
+	if (Registry) {
 
-		for (TActorIterator<ASimulationController> ActorIterator(World); ActorIterator; ++ActorIterator) {
-
-			SimulationController = *ActorIterator;
-			break;
-		}
+		SimulationController = Registry->GetSimulationController();
 
 		if (!SimulationController) {
 
@@ -453,8 +470,13 @@ void APopulationMeshActor::GetBitten(float CurrentSimulationTime) {
 	BittenTimestamp = CurrentSimulationTime;
 	bCanBeBitten = false;
 
-	PopulationType = EPopulationType::Bitten;
-	UpdateMeshBasedOnPopulation();
+	// Remember which conveyor cohort the model puts this bite in
+	if (SimulationController) {
+
+		ConveyorCohort = SimulationController->GetIncomingConveyorCohort();
+	}
+
+	SetPopulationType(EPopulationType::Bitten);
 
 	UE_LOG(LogTemp, Warning, TEXT("PopulationMeshActor: Actor %s has been bitten at simulation time %f "),
 		* GetName(), CurrentSimulationTime);
@@ -475,8 +497,7 @@ void APopulationMeshActor::TransformToZombie() {
 	if (PopulationType == EPopulationType::Zombie)
 		return;
 
-	PopulationType = EPopulationType::Zombie;
-	UpdateMeshBasedOnPopulation();
+	SetPopulationType(EPopulationType::Zombie);
 
 	// Reset teleportation timer when transforming to zombie
 	TeleportTimer = 0.0f;
@@ -495,19 +516,6 @@ bool APopulationMeshActor::IsValidBiteTarget() const {
 	return PopulationType == EPopulationType::Susceptible && CanBeBitten();
 }
 
-void APopulationMeshActor::CheckForTransformation() {
-
-	if (!SimulationController)
-		return;
-
-	float CurrentSimulationTime = static_cast<float>(SimulationController->TimeStepsFinished);
-
-	if (ShouldTransformToZombie(CurrentSimulationTime)) {
-
-		TransformToZombie();
-	}
-}
-
 // Static function to reset global bite tracking
 void APopulationMeshActor::ResetGlobalBiteTracking() {
 	bGlobalBiteInProgress = false;
@@ -576,35 +584,8 @@ void APopulationMeshActor::HandleZombieTeleportation(float DeltaTime) {
 
 APopulationMeshActor* APopulationMeshActor::FindRandomBiteTarget() {
 
-	UWorld* World = GetWorld();
-	if (!World)
-		return nullptr;
-
-	// Collect all valid bite targets
-	TArray<APopulationMeshActor*> ValidTargets;
-
-	for (TActorIterator<APopulationMeshActor> ActorIterator(World); ActorIterator; ++ActorIterator) {
-
-		APopulationMeshActor* PotentialTarget = *ActorIterator;
-
-		if (!PotentialTarget || PotentialTarget == this)
-			continue;
-
-		// Check if this is a valid bite target (susceptible girls)
-		if (PotentialTarget->IsValidBiteTarget()) {
-
-			ValidTargets.Add(PotentialTarget);
-		}
-	}
-
-	// Return a random target from valid targets
-	if (ValidTargets.Num() > 0) {
-
-		int32 RandomIndex = FMath::RandRange(0, ValidTargets.Num() - 1);
-		return ValidTargets[RandomIndex];
-	}
-
-	return nullptr;
+	// A zombie is never susceptible, so it cannot draw itself
+	return Registry ? Registry->GetRandomBiteTarget() : nullptr;
 }
 
 void APopulationMeshActor::TeleportToTarget(APopulationMeshActor* Target) {
@@ -659,6 +640,7 @@ void APopulationMeshActor::TeleportToTarget(APopulationMeshActor* Target) {
 	
 	// Teleport to the calculated position
 	SetActorLocation(TeleportLocation);
+	UpdateSpatialHash();
 	
 	// Face the target
 	FVector DirectionToTarget = (TargetLocation - TeleportLocation).GetSafeNormal();
@@ -745,6 +727,7 @@ void APopulationMeshActor::HandleZombieTargetedMovement(float DeltaTime) {
 		FVector NewLocation = MyLocation + (DirectionToTarget * MovementSpeed * DeltaTime);
 
 		SetActorLocation(NewLocation);
+		UpdateSpatialHash();
 
 		// Face the target
 		FRotator NewRotation = DirectionToTarget.Rotation();
@@ -772,92 +755,43 @@ void APopulationMeshActor::TryToBiteNearbyTargets() {
 	if (!bGuaranteeBites && LastBiteTime < BiteCooldown)
 		return;
 
-	// Find all potential targets in bite range
-	UWorld* World = GetWorld();
-	if (!World)
+	// Any valid target in bite range, or anywhere for guaranteed bites
+	APopulationMeshActor* PotentialTarget = SpatialHash ? SpatialHash->FindAnyBiteTarget(GetActorLocation(), bGuaranteeBites ? UE_BIG_NUMBER : BiteRange, this) : nullptr;
+	if (!PotentialTarget)
 		return;
 
-	FVector MyLocation = GetActorLocation();
-
-	for (TActorIterator<APopulationMeshActor> ActorIterator(World); ActorIterator; ++ActorIterator) {
-
-		APopulationMeshActor* PotentialTarget = *ActorIterator;
-
-		if (!PotentialTarget || PotentialTarget == this)
-			continue;
-
-		if (!CanBiteTarget(PotentialTarget))
-			continue;
-
-		float Distance = FVector::Dist2D(MyLocation, PotentialTarget->GetActorLocation());
-
-		// Check distance
-		if (!bGuaranteeBites && Distance > BiteRange)
-			continue;
-
-		// Mark that a bite is in progress
-		if (bOnlyOneBiteAtATime) {
-			bGlobalBiteInProgress = true;
-		}
+	// Mark that a bite is in progress
+	if (bOnlyOneBiteAtATime) {
+		bGlobalBiteInProgress = true;
+	}
 
-		// Get current simulation time
-		float CurrentSimulationTime = static_cast<float>(SimulationController->TimeStepsFinished);
+	// Get current simulation time
+	float CurrentSimulationTime = static_cast<float>(SimulationController->TimeStepsFinished);
 
-		// Bite the target
-		PotentialTarget->GetBitten(CurrentSimulationTime);
+	// Bite the target
+	PotentialTarget->GetBitten(CurrentSimulationTime);
 
-		// Reset bite timer
-		LastBiteTime = 0.0f;
-
-		// Clear current target so we can find a new one
-		CurrentTarget = nullptr;
+	// Reset bite timer
+	LastBiteTime = 0.0f;
 
-		UE_LOG(LogTemp, Warning, TEXT("PopulationMeshActor Zombie: %s %s bit %s at simulation time %f"),
-			*GetName(), bGuaranteeBites ? TEXT("GUARANTEED") : TEXT("successfully"), *PotentialTarget->GetName(), CurrentSimulationTime);
+	// Clear current target so we can find a new one
+	CurrentTarget = nullptr;
 
-		// Reset global bite tracking after bite
-		if (bOnlyOneBiteAtATime) {
-			bGlobalBiteInProgress = false;
-		}
+	UE_LOG(LogTemp, Warning, TEXT("PopulationMeshActor Zombie: %s %s bit %s at simulation time %f"),
+		*GetName(), bGuaranteeBites ? TEXT("GUARANTEED") : TEXT("successfully"), *PotentialTarget->GetName(), CurrentSimulationTime);
 
-		// Only bite one target per attempt
-		break;
+	// Reset global bite tracking after bite
+	if (bOnlyOneBiteAtATime) {
+		bGlobalBiteInProgress = false;
 	}
 }
 
 APopulationMeshActor* APopulationMeshActor::FindNearestBiteTarget() {
 
-	if (PopulationType != EPopulationType::Zombie)
+	if (PopulationType != EPopulationType::Zombie || !SpatialHash)
 		return nullptr;
 
-	UWorld* World = GetWorld();
-	if (!World)
-		return nullptr;
-
-	FVector MyLocation = GetActorLocation();
-	APopulationMeshActor* NearestTarget = nullptr;
-	float NearestDistance = BiteSearchRadius;
-
-	for (TActorIterator<APopulationMeshActor> ActorIterator(World); ActorIterator; ++ActorIterator) {
-
-		APopulationMeshActor* PotentialTarget = *ActorIterator;
-
-		if (!PotentialTarget || PotentialTarget == this)
-			continue;
-
-		if (!CanBiteTarget(PotentialTarget))
-			continue;
-
-		float Distance = FVector::Dist2D(MyLocation, PotentialTarget->GetActorLocation());
-
-		if (Distance < NearestDistance) {
-
-			NearestDistance = Distance;
-			NearestTarget = PotentialTarget;
-		}
-	}
-
-	return NearestTarget;
+	return SpatialHash->FindNearestBiteTarget(GetActorLocation(), BiteSearchRadius, this);
 }
 
 bool APopulationMeshActor::CanBiteTarget(APopulationMeshActor* Target) const {
@@ -940,6 +874,7 @@ void APopulationMeshActor::GirlsHandleWanderingMovement(float DeltaTime) {
 
 	// Apply movement
 	SetActorLocation(NewLocation);
+	UpdateSpatialHash();
 	LastValidPosition = NewLocation;
 
 	// Rotate to face movement direction
@@ -954,36 +889,27 @@ void APopulationMeshActor::GirlsHandleWanderingMovement(float DeltaTime) {
 }
 
 void APopulationMeshActor::OnDeath() const {
-	TArray < AActor* > mSimControllers;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), ASimulationController::StaticClass(), mSimControllers);
 
-	
+	ASimulationController* SimController = SimulationController;
+	if (!SimController && Registry) {
 
-	AActor* mSimController = mSimControllers[0];
+		SimController = Registry->GetSimulationController();
+	}
 
-	ASimulationController* SimController = Cast <ASimulationController>(mSimController);
+	// Queued for the start of the next step instead of changing the stocks under the model.
+	// The death site lets the spatial grid take the person from the cell they died in.
 	if (SimController != NULL) {
+		const FVector DeathSite = GetActorLocation();
 		if (PopulationType == EPopulationType::Zombie) {
-			SimController->Zombies--;
+			SimController->EnqueueStockDelta({ EZombieStock::Zombies, -1.f, INDEX_NONE, DeathSite });
 		}
 		if (PopulationType == EPopulationType::Susceptible) {
-			SimController->Susceptible--;
+			SimController->EnqueueStockDelta({ EZombieStock::Susceptible, -1.f, INDEX_NONE, DeathSite });
 		}
 		if (PopulationType == EPopulationType::Bitten) {
-			SimController->Bitten--;
-			
-			float CurrentSimulationTime = static_cast<float>(SimulationController->TimeStepsFinished);
-			int ThisDaysLeft = CurrentSimulationTime - BittenTimestamp;
-
-			for (auto& b : SimController->conveyor) {
-				if (static_cast<int>(b.remainingDays) == static_cast<int>(ThisDaysLeft)) {
-					b.amountOfPeople--;
-				}
-			}
 
+			// O(1) removal from the cohort this actor was bitten into
+			SimController->EnqueueStockDelta({ EZombieStock::Bitten, -1.f, ConveyorCohort, DeathSite });
 		}
 	}
-
-	
-
 }
\ No newline at end of file
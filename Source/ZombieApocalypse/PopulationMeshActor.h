@@ -13,6 +13,9 @@
 #include "SimulationController.h"
 #include "PopulationMeshActor.generated.h"
 
+class UPopulationSpatialHash;
+class UPopulationRegistry;
+
 
 UENUM(BlueprintType)
 enum class EPopulationType : uint8 {
@@ -34,11 +37,9 @@ public:
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
 	// Skibidi Components
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components)
 	USkeletalMeshComponent* SkeletalMeshComponent;
@@ -63,6 +64,11 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Population Settings")
 	EPopulationType PopulationType;
 
+	// Changes PopulationType and updates the mesh and the spatial hash right away. Writing PopulationType
+	// directly is only picked up on the agent's next update.
+	UFUNCTION(BlueprintCallable, Category = "Population Settings")
+	void SetPopulationType(EPopulationType NewType);
+
 	// Simulation Controller Reference
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation")
 	ASimulationController* SimulationController;
@@ -162,6 +168,10 @@ public:
 	UPROPERTY(BlueprintReadWrite, Category = "Bite Management System")
 	bool bCanBeBitten = true;
 
+	// Conveyor cohort this actor's bite was counted in, INDEX_NONE until bitten
+	UPROPERTY(BlueprintReadOnly, Category = "Bite Management System")
+	int32 ConveyorCohort = INDEX_NONE;
+
 	UFUNCTION(BlueprintCallable, Category = "Bite Management System")
 	bool CanBeBitten() const;
 
@@ -217,8 +227,21 @@ public:
 private:
 
 	void UpdateMeshBasedOnPopulation();
-	float GetCurrentPopulationValue() const;
 	void SetupMeshComponent();
+
+	// Mesh, spatial hash and registry follow a new PopulationType
+	void HandlePopulationTypeChanged();
+
+	// Call after moving the actor
+	void UpdateSpatialHash();
+
+	// Per frame behaviour, called by the registry for the agents of one type. Bitten agents stand still.
+	void TickSusceptible(float DeltaTime);
+	void TickZombie(float DeltaTime);
+
+	// Bound to SimulationController->OnStepCompleted, a bitten actor only needs to check once a day
+	UFUNCTION()
+	void HandleStepCompleted(const FZombieStepDelta& Delta);
 	void FindSimulationController();
 	void GirlsHandleWanderingMovement(float DeltaTime);
 
@@ -257,15 +280,28 @@ private:
 	bool bTurningAroundFromBoundary = false;
 	float BoundaryTurnTimer = 0.0f;
 
-	// Detecting changes
-	float PreviousPopulationValue;
+	// Detecting changes made to PopulationType from Blueprints
 	EPopulationType PreviousPopulationType;
 
+	// Bite target queries go through the world's spatial hash instead of iterating every actor
+	UPROPERTY()
+	UPopulationSpatialHash* SpatialHash = nullptr;
+
+	// Counts, random picks and the controller lookup go through the world's registry
+	UPROPERTY()
+	UPopulationRegistry* Registry = nullptr;
+
+	// Position in the registry's array for RegisteredType, so moving between arrays is a swap
+	friend class UPopulationRegistry;
+	int32 RegistryIndex = INDEX_NONE;
+	EPopulationType RegisteredType = EPopulationType::Susceptible;
+
+	// World time of the last update, agents updated every few frames get the time since then
+	double LastUpdateTime = 0.0;
+
 
 public:
 	UPROPERTY(BlueprintReadWrite, Category = "Collision")
 	UCapsuleComponent* WeaponCollider;
 
-private:
-	void CheckForTransformation();
 };
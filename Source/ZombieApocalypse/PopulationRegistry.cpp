@@ -0,0 +1,174 @@
+#include "PopulationRegistry.h"
+#include "SimulationController.h"
+#include "EngineUtils.h"
+
+void UPopulationRegistry::Register(APopulationMeshActor* Actor) {
+
+	if (!Actor || Actor->RegistryIndex != INDEX_NONE)
+		return;
+
+	Actor->LastUpdateTime = GetWorld()->GetTimeSeconds();
+	AddToType(Actor, Actor->PopulationType);
+}
+
+void UPopulationRegistry::Unregister(APopulationMeshActor* Actor) {
+
+	if (!Actor || Actor->RegistryIndex == INDEX_NONE)
+		return;
+
+	RemoveFromType(Actor);
+}
+
+void UPopulationRegistry::UpdateType(APopulationMeshActor* Actor) {
+
+	if (!Actor || Actor->RegistryIndex == INDEX_NONE || Actor->RegisteredType == Actor->PopulationType)
+		return;
+
+	RemoveFromType(Actor);
+	AddToType(Actor, Actor->PopulationType);
+}
+
+void UPopulationRegistry::AddToType(APopulationMeshActor* Actor, EPopulationType Type) {
+
+	Actor->RegisteredType = Type;
+	Actor->RegistryIndex = Actors[static_cast<int32>(Type)].Add(Actor);
+}
+
+void UPopulationRegistry::RemoveFromType(APopulationMeshActor* Actor) {
+
+	TArray<APopulationMeshActor*>& TypeActors = Actors[static_cast<int32>(Actor->RegisteredType)];
+	const int32 Index = Actor->RegistryIndex;
+
+	TypeActors.RemoveAtSwap(Index, EAllowShrinking::No);
+	if (Index < TypeActors.Num()) {
+
+		TypeActors[Index]->RegistryIndex = Index;
+	}
+	Actor->RegistryIndex = INDEX_NONE;
+}
+
+void UPopulationRegistry::Tick(float DeltaTime) {
+
+	Super::Tick(DeltaTime);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	TickType(EPopulationType::Susceptible, Now, [](APopulationMeshActor* Actor, float ActorDeltaTime) { Actor->TickSusceptible(ActorDeltaTime); });
+
+	// Bitten actors stand still until HandleStepCompleted turns them, the loop only picks up type changes
+	TickType(EPopulationType::Bitten, Now, [](APopulationMeshActor*, float) {});
+
+	TickType(EPopulationType::Zombie, Now, [](APopulationMeshActor* Actor, float ActorDeltaTime) { Actor->TickZombie(ActorDeltaTime); });
+}
+
+template <typename UpdateFunction>
+void UPopulationRegistry::TickType(EPopulationType Type, double Now, UpdateFunction Update) {
+
+	const int32 TypeIndex = static_cast<int32>(Type);
+	TArray<APopulationMeshActor*>& TypeActors = Actors[TypeIndex];
+	int32& Next = NextToUpdate[TypeIndex];
+
+	const int32 SliceSize = FMath::DivideAndRoundUp(TypeActors.Num(), FramesPerUpdate[TypeIndex]);
+	for (int32 Updated = 0; Updated < SliceSize && TypeActors.Num() > 0; ++Updated) {
+
+		if (Next >= TypeActors.Num()) {
+
+			Next = 0;
+		}
+
+		APopulationMeshActor* Actor = TypeActors[Next];
+		const float ActorDeltaTime = static_cast<float>(Now - Actor->LastUpdateTime);
+		Actor->LastUpdateTime = Now;
+
+		// A type written directly from Blueprints moves the actor to another array, the last actor of this
+		// type takes its place and is updated next
+		if (Actor->PopulationType != Type) {
+
+			Actor->HandlePopulationTypeChanged();
+			continue;
+		}
+
+		// Updates if there is a Simulation Controller
+		if (Actor->SimulationController) {
+
+			Update(Actor, ActorDeltaTime);
+		}
+
+		// If the update took this actor out of the array, its slot already holds the next one
+		if (TypeActors.IsValidIndex(Next) && TypeActors[Next] == Actor) {
+
+			++Next;
+		}
+	}
+}
+
+TStatId UPopulationRegistry::GetStatId() const {
+
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPopulationRegistry, STATGROUP_Tickables);
+}
+
+void UPopulationRegistry::SetFramesPerUpdate(EPopulationType Type, int32 NewFramesPerUpdate) {
+
+	FramesPerUpdate[static_cast<int32>(Type)] = FMath::Max(NewFramesPerUpdate, 1);
+}
+
+APopulationMeshActor* UPopulationRegistry::GetRandom(EPopulationType Type) const {
+
+	const TArray<APopulationMeshActor*>& TypeActors = Actors[static_cast<int32>(Type)];
+	return TypeActors.Num() > 0 ? TypeActors[FMath::RandRange(0, TypeActors.Num() - 1)] : nullptr;
+}
+
+APopulationMeshActor* UPopulationRegistry::GetRandomBiteTarget() const {
+
+	const TArray<APopulationMeshActor*>& Susceptible = Actors[static_cast<int32>(EPopulationType::Susceptible)];
+	if (Susceptible.Num() == 0)
+		return nullptr;
+
+	// Nearly every susceptible actor can be bitten, so a few draws almost always find one. A rejected draw
+	// is simply drawn again, which keeps the pick uniform over the valid targets.
+	for (int32 Attempt = 0; Attempt < 4; ++Attempt) {
+
+		APopulationMeshActor* Candidate = Susceptible[FMath::RandRange(0, Susceptible.Num() - 1)];
+		if (Candidate->IsValidBiteTarget())
+			return Candidate;
+	}
+
+	// Mostly not biteable (e.g. bCanBeBitten turned off), sample the valid ones in one pass
+	APopulationMeshActor* Chosen = nullptr;
+	int32 NumValid = 0;
+	for (APopulationMeshActor* Candidate : Susceptible) {
+
+		if (Candidate->IsValidBiteTarget() && FMath::RandRange(0, NumValid++) == 0) {
+
+			Chosen = Candidate;
+		}
+	}
+	return Chosen;
+}
+
+ASimulationController* UPopulationRegistry::GetSimulationController() {
+
+	if (!SimulationController) {
+
+		for (TActorIterator<ASimulationController> ActorIterator(GetWorld()); ActorIterator; ++ActorIterator) {
+
+			SimulationController = *ActorIterator;
+			break;
+		}
+	}
+
+	return SimulationController;
+}
+
+void UPopulationRegistry::RegisterSimulationController(ASimulationController* Controller) {
+
+	SimulationController = Controller;
+}
+
+void UPopulationRegistry::UnregisterSimulationController(ASimulationController* Controller) {
+
+	if (SimulationController == Controller) {
+
+		SimulationController = nullptr;
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PopulationMeshActor.h"
+#include "PopulationRegistry.generated.h"
+
+class ASimulationController;
+
+/**
+ * Every population actor of a world in one dense array per EPopulationType, plus the world's simulation
+ * controller, so counts, random picks and the controller lookup never iterate the world.
+ * Actors register on BeginPlay and move between the arrays when their type changes; each one remembers its
+ * index, so moving and removing is a swap with the last element.
+ * The registry also ticks the actors, one loop per type over its array, in place of a tick function per actor.
+ */
+UCLASS()
+class ZOMBIEAPOCALYPSE_API UPopulationRegistry : public UTickableWorldSubsystem {
+
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Updates the actors of a type every FramesPerUpdate frames, a slice of them each frame in turn.
+	// Each one moves by the time since its last update, so a lower rate changes how smooth, not how fast.
+	UFUNCTION(BlueprintCallable, Category = "Population")
+	void SetFramesPerUpdate(EPopulationType Type, int32 NewFramesPerUpdate);
+
+	UFUNCTION(BlueprintCallable, Category = "Population")
+	int32 GetFramesPerUpdate(EPopulationType Type) const { return FramesPerUpdate[static_cast<int32>(Type)]; }
+
+	void Register(APopulationMeshActor* Actor);
+	void Unregister(APopulationMeshActor* Actor);
+
+	// Moves the actor to the array of its current PopulationType
+	void UpdateType(APopulationMeshActor* Actor);
+
+	UFUNCTION(BlueprintCallable, Category = "Population")
+	int32 GetCount(EPopulationType Type) const { return Actors[static_cast<int32>(Type)].Num(); }
+
+	const TArray<APopulationMeshActor*>& GetActors(EPopulationType Type) const { return Actors[static_cast<int32>(Type)]; }
+
+	// Uniformly random actor of a type, nullptr if there is none
+	UFUNCTION(BlueprintCallable, Category = "Population")
+	APopulationMeshActor* GetRandom(EPopulationType Type) const;
+
+	// Uniformly random actor that IsValidBiteTarget, nullptr if there is none
+	UFUNCTION(BlueprintCallable, Category = "Population")
+	APopulationMeshActor* GetRandomBiteTarget() const;
+
+	// The controller registered itself on BeginPlay. Before that the world is searched once.
+	UFUNCTION(BlueprintCallable, Category = "Simulation")
+	ASimulationController* GetSimulationController();
+
+	void RegisterSimulationController(ASimulationController* Controller);
+	void UnregisterSimulationController(ASimulationController* Controller);
+
+private:
+	static constexpr int32 NumTypes = 3;
+
+	TArray<APopulationMeshActor*> Actors[NumTypes];
+
+	int32 FramesPerUpdate[NumTypes] = { 1, 1, 1 };
+
+	// Index the next slice of every type starts at
+	int32 NextToUpdate[NumTypes] = {};
+
+	UPROPERTY()
+	ASimulationController* SimulationController = nullptr;
+
+	void AddToType(APopulationMeshActor* Actor, EPopulationType Type);
+	void RemoveFromType(APopulationMeshActor* Actor);
+
+	// Calls Update for this frame's slice of a type
+	template <typename UpdateFunction>
+	void TickType(EPopulationType Type, double Now, UpdateFunction Update);
+};
@@ -0,0 +1,251 @@
+#include "PopulationSpatialHash.h"
+
+void UPopulationSpatialHash::Add(APopulationMeshActor* Actor) {
+
+	if (!Actor || Entries.Contains(Actor))
+		return;
+
+	if (CellSize <= 0.0f) {
+
+		CellSize = FMath::Max(Actor->BiteSearchRadius, 1.0f);
+		InvCellSize = 1.0f / CellSize;
+	}
+
+	FEntry& Entry = Entries.Add(Actor, { GetCell(Actor->GetActorLocation()), Actor->PopulationType, INDEX_NONE });
+	AddToCell(Actor, Entry);
+}
+
+void UPopulationSpatialHash::Remove(APopulationMeshActor* Actor) {
+
+	if (const FEntry* Entry = Entries.Find(Actor)) {
+
+		RemoveFromCell(*Entry);
+		Entries.Remove(Actor);
+	}
+}
+
+void UPopulationSpatialHash::Update(APopulationMeshActor* Actor) {
+
+	FEntry* Entry = Entries.Find(Actor);
+	if (!Entry)
+		return;
+
+	const FIntPoint Cell = GetCell(Actor->GetActorLocation());
+	if (Cell == Entry->Cell && Actor->PopulationType == Entry->Type)
+		return;
+
+	RemoveFromCell(*Entry);
+	Entry->Cell = Cell;
+	Entry->Type = Actor->PopulationType;
+	AddToCell(Actor, *Entry);
+}
+
+FIntPoint UPopulationSpatialHash::GetCell(const FVector& Location) const {
+
+	return FIntPoint(FMath::FloorToInt32(Location.X * InvCellSize), FMath::FloorToInt32(Location.Y * InvCellSize));
+}
+
+void UPopulationSpatialHash::AddToCell(APopulationMeshActor* Actor, FEntry& Entry) {
+
+	Entry.Index = Cells[static_cast<int32>(Entry.Type)].FindOrAdd(Entry.Cell).Add(Actor);
+}
+
+void UPopulationSpatialHash::RemoveFromCell(const FEntry& Entry) {
+
+	TArray<APopulationMeshActor*>* Cell = Cells[static_cast<int32>(Entry.Type)].Find(Entry.Cell);
+	if (!Cell)
+		return;
+
+	// Empty cells are kept, agents wander back and forth over the same ground
+	Cell->RemoveAtSwap(Entry.Index, EAllowShrinking::No);
+	if (Entry.Index < Cell->Num()) {
+
+		Entries[(*Cell)[Entry.Index]].Index = Entry.Index;
+	}
+}
+
+void UPopulationSpatialHash::ForEachCell(const FVector& Center, float Radius, EPopulationType Type, TFunctionRef<bool(const TArray<APopulationMeshActor*>&)> Visit) const {
+
+	const TMap<FIntPoint, TArray<APopulationMeshActor*>>& TypeCells = Cells[static_cast<int32>(Type)];
+	if (TypeCells.Num() == 0)
+		return;
+
+	// A square wider than there are cells (e.g. guaranteed bites, which search everywhere) is cheaper to
+	// cover by visiting every cell once
+	const double Side = 2.0 * Radius * InvCellSize + 1.0;
+	if (Side * Side > TypeCells.Num()) {
+
+		for (const TPair<FIntPoint, TArray<APopulationMeshActor*>>& Pair : TypeCells) {
+
+			if (!Visit(Pair.Value))
+				return;
+		}
+		return;
+	}
+
+	const FIntPoint Min = GetCell(Center - FVector(Radius, Radius, 0.0f));
+	const FIntPoint Max = GetCell(Center + FVector(Radius, Radius, 0.0f));
+	for (int32 Y = Min.Y; Y <= Max.Y; ++Y) {
+
+		for (int32 X = Min.X; X <= Max.X; ++X) {
+
+			const TArray<APopulationMeshActor*>* Cell = TypeCells.Find(FIntPoint(X, Y));
+			if (Cell && !Visit(*Cell))
+				return;
+		}
+	}
+}
+
+void UPopulationSpatialHash::FindInRadius(const FVector& Center, float Radius, EPopulationType Type, TArray<APopulationMeshActor*>& OutActors) const {
+
+	OutActors.Reset();
+
+	const double RadiusSquared = FMath::Square(static_cast<double>(Radius));
+	ForEachCell(Center, Radius, Type, [&](const TArray<APopulationMeshActor*>& Cell) {
+
+		for (APopulationMeshActor* Actor : Cell) {
+
+			if (FVector::DistSquared2D(Center, Actor->GetActorLocation()) <= RadiusSquared) {
+
+				OutActors.Add(Actor);
+			}
+		}
+		return true;
+	});
+}
+
+void UPopulationSpatialHash::FindNearest(const FVector& Center, float MaxRadius, EPopulationType Type, int32 Count, TArray<APopulationMeshActor*>& OutActors) const {
+
+	FindNearestFiltered(Center, MaxRadius, Type, Count, [](const APopulationMeshActor*) { return true; }, OutActors);
+}
+
+void UPopulationSpatialHash::FindNearestFiltered(const FVector& Center, float MaxRadius, EPopulationType Type, int32 Count,
+	TFunctionRef<bool(const APopulationMeshActor*)> Filter, TArray<APopulationMeshActor*>& OutActors) const {
+
+	OutActors.Reset();
+
+	const TMap<FIntPoint, TArray<APopulationMeshActor*>>& TypeCells = Cells[static_cast<int32>(Type)];
+	if (Count <= 0 || TypeCells.Num() == 0)
+		return;
+
+	const double MaxRadiusSquared = FMath::Square(static_cast<double>(MaxRadius));
+	TArray<TPair<double, APopulationMeshActor*>, TInlineAllocator<16>> Candidates;
+
+	auto VisitCell = [&](const TArray<APopulationMeshActor*>& Cell) {
+
+		for (APopulationMeshActor* Actor : Cell) {
+
+			const double DistanceSquared = FVector::DistSquared2D(Center, Actor->GetActorLocation());
+			if (DistanceSquared <= MaxRadiusSquared && Filter(Actor)) {
+
+				Candidates.Emplace(DistanceSquared, Actor);
+			}
+		}
+	};
+
+	// Rings of cells around the centre, until Count candidates are closer than anything in the next ring can
+	// be. Once that has visited more cells than are occupied, one pass over the occupied cells is cheaper.
+	const FIntPoint Origin = GetCell(Center);
+	const int32 MaxRing = static_cast<int32>(FMath::Min(static_cast<double>(MaxRadius) * InvCellSize + 1.0, static_cast<double>(MAX_int16)));
+	int32 CellsVisited = 0;
+	for (int32 Ring = 0; Ring <= MaxRing; ++Ring) {
+
+		auto VisitAt = [&](int32 X, int32 Y) {
+
+			if (const TArray<APopulationMeshActor*>* Cell = TypeCells.Find(FIntPoint(Origin.X + X, Origin.Y + Y))) {
+
+				VisitCell(*Cell);
+			}
+			++CellsVisited;
+		};
+
+		if (Ring == 0) {
+
+			VisitAt(0, 0);
+		}
+
+		else {
+
+			for (int32 Step = -Ring; Step <= Ring; ++Step) {
+
+				VisitAt(Step, -Ring);
+				VisitAt(Step, Ring);
+				if (Step > -Ring && Step < Ring) {
+
+					VisitAt(-Ring, Step);
+					VisitAt(Ring, Step);
+				}
+			}
+		}
+
+		if (Candidates.Num() >= Count) {
+
+			// Anything in a later ring is at least Ring cells away
+			const double ReachSquared = FMath::Square(Ring * static_cast<double>(CellSize));
+			int32 NumWithinReach = 0;
+			for (const TPair<double, APopulationMeshActor*>& Candidate : Candidates) {
+
+				NumWithinReach += Candidate.Key <= ReachSquared ? 1 : 0;
+			}
+			if (NumWithinReach >= Count)
+				break;
+		}
+
+		if (CellsVisited > TypeCells.Num() && Ring < MaxRing) {
+
+			Candidates.Reset();
+			for (const TPair<FIntPoint, TArray<APopulationMeshActor*>>& Pair : TypeCells) {
+
+				VisitCell(Pair.Value);
+			}
+			break;
+		}
+	}
+
+	Candidates.Sort([](const TPair<double, APopulationMeshActor*>& A, const TPair<double, APopulationMeshActor*>& B) { return A.Key < B.Key; });
+	for (int32 i = 0; i < FMath::Min(Count, Candidates.Num()); ++i) {
+
+		OutActors.Add(Candidates[i].Value);
+	}
+}
+
+APopulationMeshActor* UPopulationSpatialHash::FindNearestBiteTarget(const FVector& Center, float Radius, const APopulationMeshActor* Ignore) const {
+
+	APopulationMeshActor* Nearest = nullptr;
+	double NearestDistanceSquared = FMath::Square(static_cast<double>(Radius));
+	ForEachCell(Center, Radius, EPopulationType::Susceptible, [&](const TArray<APopulationMeshActor*>& Cell) {
+
+		for (APopulationMeshActor* Actor : Cell) {
+
+			const double DistanceSquared = FVector::DistSquared2D(Center, Actor->GetActorLocation());
+			if (DistanceSquared < NearestDistanceSquared && Actor != Ignore && Actor->IsValidBiteTarget()) {
+
+				NearestDistanceSquared = DistanceSquared;
+				Nearest = Actor;
+			}
+		}
+		return true;
+	});
+
+	return Nearest;
+}
+
+APopulationMeshActor* UPopulationSpatialHash::FindAnyBiteTarget(const FVector& Center, float Radius, const APopulationMeshActor* Ignore) const {
+
+	APopulationMeshActor* Found = nullptr;
+	const double RadiusSquared = FMath::Square(static_cast<double>(Radius));
+	ForEachCell(Center, Radius, EPopulationType::Susceptible, [&](const TArray<APopulationMeshActor*>& Cell) {
+
+		for (APopulationMeshActor* Actor : Cell) {
+
+			if (Actor != Ignore && Actor->IsValidBiteTarget() && FVector::DistSquared2D(Center, Actor->GetActorLocation()) <= RadiusSquared) {
+
+				Found = Actor;
+				return false;
+			}
+		}
+		return true;
+	});
+
+	return Found;
+}
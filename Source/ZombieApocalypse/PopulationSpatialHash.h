@@ -0,0 +1,74 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PopulationMeshActor.h"
+#include "PopulationSpatialHash.generated.h"
+
+/**
+ * Uniform 2D grid over the population actors of a world, one per EPopulationType, so bite queries only
+ * look at the cells around the zombie instead of iterating every actor.
+ * Actors add themselves on BeginPlay and update their entry when they move or change type; an update that
+ * stays in the same cell and type is a map lookup.
+ */
+UCLASS()
+class ZOMBIEAPOCALYPSE_API UPopulationSpatialHash : public UWorldSubsystem {
+
+	GENERATED_BODY()
+
+public:
+	void Add(APopulationMeshActor* Actor);
+	void Remove(APopulationMeshActor* Actor);
+
+	// Moves the actor to the cell of its current location and the bucket of its current PopulationType
+	void Update(APopulationMeshActor* Actor);
+
+	// Every actor of a type within Radius of Center (2D)
+	UFUNCTION(BlueprintCallable, Category = "Population")
+	void FindInRadius(const FVector& Center, float Radius, EPopulationType Type, TArray<APopulationMeshActor*>& OutActors) const;
+
+	// Up to Count actors of a type within MaxRadius of Center (2D), nearest first
+	UFUNCTION(BlueprintCallable, Category = "Population")
+	void FindNearest(const FVector& Center, float MaxRadius, EPopulationType Type, int32 Count, TArray<APopulationMeshActor*>& OutActors) const;
+
+	// Nearest actor that IsValidBiteTarget within Radius, nullptr if there is none
+	APopulationMeshActor* FindNearestBiteTarget(const FVector& Center, float Radius, const APopulationMeshActor* Ignore = nullptr) const;
+
+	// Any actor that IsValidBiteTarget within Radius, whichever is found first
+	APopulationMeshActor* FindAnyBiteTarget(const FVector& Center, float Radius, const APopulationMeshActor* Ignore = nullptr) const;
+
+	// Cells are the BiteSearchRadius of the first actor added, so a search radius query covers 3x3 cells
+	float GetCellSize() const { return CellSize; }
+
+private:
+	struct FEntry {
+
+		FIntPoint Cell;
+		EPopulationType Type;
+
+		// Index in the cell's array
+		int32 Index;
+	};
+
+	static constexpr int32 NumTypes = 3;
+
+	// Actors per occupied cell, one map per EPopulationType
+	TMap<FIntPoint, TArray<APopulationMeshActor*>> Cells[NumTypes];
+
+	TMap<const APopulationMeshActor*, FEntry> Entries;
+
+	float CellSize = 0.0f;
+	float InvCellSize = 0.0f;
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	void AddToCell(APopulationMeshActor* Actor, FEntry& Entry);
+	void RemoveFromCell(const FEntry& Entry);
+
+	// Calls Visit for every occupied cell of a type overlapping the square around Center, until it returns false
+	void ForEachCell(const FVector& Center, float Radius, EPopulationType Type, TFunctionRef<bool(const TArray<APopulationMeshActor*>&)> Visit) const;
+
+	// Nearest first, up to Count actors that pass Filter
+	void FindNearestFiltered(const FVector& Center, float MaxRadius, EPopulationType Type, int32 Count,
+		TFunctionRef<bool(const APopulationMeshActor*)> Filter, TArray<APopulationMeshActor*>& OutActors) const;
+};
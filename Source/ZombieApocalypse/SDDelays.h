@@ -0,0 +1,331 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZombieDual.h"
+
+// Stella's delay and smoothing builtins as small state structs. Every one has a fixed size, so it can
+// live in a model state without touching the heap, and costs O(1) per step. Rates are per day and a
+// step covers DT days, like the rest of the stock-and-flow code. Templated on the number type so the
+// sensitivity pass can carry derivatives through the ones the zombie model uses.
+
+// Material delay of order Order (DELAY1, DELAY3): a chain of Order stages that each hold people for
+// DelayTime / Order on average, so the outflow is the inflow spread out over roughly DelayTime.
+template<typename T, int32 Order>
+struct TSDMaterialDelay
+{
+	static_assert(Order > 0, "A material delay needs at least one stage");
+
+	// People in each stage, the last one drains into the outflow
+	T Stages[Order]{};
+
+	// Fills every stage so that an inflow of Inflow per day is already flowing out at the same rate
+	void Initialize(const T& Inflow, const T& DelayTime, float DT)
+	{
+		const T Time = StageTime(DelayTime, DT);
+		for (int32 Stage = 0; Stage < Order; ++Stage)
+			Stages[Stage] = Inflow * Time;
+	}
+
+	// People leaving per day at the start of a step of DT days. A stage never empties faster than one
+	// step, so a step longer than the stage time does not drive it negative.
+	T Outflow(const T& DelayTime, float DT) const
+	{
+		return Stages[Order - 1] / StageTime(DelayTime, DT);
+	}
+
+	// Moves every stage on by DT days with Inflow people per day coming in. All stage outflows are taken
+	// from the stages as they were at the start of the step, like Euler. Returns the outflow per day.
+	T Step(const T& Inflow, const T& DelayTime, float DT)
+	{
+		const T Time = StageTime(DelayTime, DT);
+		T Rate = Inflow;
+		for (int32 Stage = 0; Stage < Order; ++Stage)
+		{
+			const T Out = Stages[Stage] / Time;
+			Stages[Stage] += T(DT) * (Rate - Out);
+			Rate = Out;
+		}
+		return Rate;
+	}
+
+	T Content() const
+	{
+		T Total = Stages[0];
+		for (int32 Stage = 1; Stage < Order; ++Stage)
+			Total += Stages[Stage];
+		return Total;
+	}
+
+	// Removes up to AmountOfPeople, starting with the stage closest to the outflow. Returns how many were removed.
+	T Remove(T AmountOfPeople)
+	{
+		T Removed = T(0.f);
+		for (int32 Stage = Order - 1; Stage >= 0; --Stage)
+		{
+			const T Taken = ZombieMath::Min(ZombieMath::Max(AmountOfPeople - Removed, T(0.f)), Stages[Stage]);
+			Stages[Stage] -= Taken;
+			Removed += Taken;
+		}
+		return Removed;
+	}
+
+	bool operator==(const TSDMaterialDelay& Other) const
+	{
+		for (int32 Stage = 0; Stage < Order; ++Stage)
+		{
+			if (!(Stages[Stage] == Other.Stages[Stage]))
+				return false;
+		}
+		return true;
+	}
+
+	// Days a person spends in each stage on average, never less than a step
+	T StageTime(const T& DelayTime, float DT) const
+	{
+		return ZombieMath::Max(DelayTime / T(static_cast<float>(Order)), T(DT));
+	}
+};
+
+template<typename T>
+using TSDDelay1 = TSDMaterialDelay<T, 1>;
+
+template<typename T>
+using TSDDelay3 = TSDMaterialDelay<T, 3>;
+
+// First-order exponential smoothing (SMTH1): the output moves towards the input by the gap over the
+// smoothing time every day. Starts at the first input unless it is initialized.
+template<typename T>
+struct TSDSmooth1
+{
+	T Value{ 0.f };
+	bool bInitialized{ false };
+
+	void Initialize(const T& InValue)
+	{
+		Value = InValue;
+		bInitialized = true;
+	}
+
+	// The smoothed value at the start of the step, then moves it on by DT days
+	T Step(const T& Input, const T& SmoothingTime, float DT)
+	{
+		if (!bInitialized)
+			Initialize(Input);
+
+		const T Output = Value;
+		Value += T(DT) * (Input - Value) / ZombieMath::Max(SmoothingTime, T(DT));
+		return Output;
+	}
+};
+
+// Conveyor whose content leaks out on the way (Stella's leakage fraction), for people who die or
+// recover before they arrive. A fixed ring of up to MaxSteps cohorts; leakage scales every cohort at
+// once through a shared factor instead of visiting them, so a step stays O(1).
+template<typename T, int32 MaxSteps = 256>
+class TSDLeakyConveyor
+{
+public:
+	static constexpr int32 MaxTransitSteps = MaxSteps;
+
+	TSDLeakyConveyor() = default;
+
+	// Copies the cohorts of a conveyor over another number type
+	template<typename U>
+	explicit TSDLeakyConveyor(const TSDLeakyConveyor<U, MaxSteps>& Other)
+		: TransitSteps(Other.TransitSteps)
+		, Cursor(Other.Cursor)
+		, Scale(Other.Scale)
+		, Total(Other.Total)
+		, LateFraction(Other.LateFraction)
+	{
+		for (int32 Slot = 0; Slot < MaxSteps; ++Slot)
+			Slots[Slot] = T(Other.Slots[Slot]);
+	}
+
+	// Empties the conveyor and sets the steps a cohort spends on it, clamped to 1..MaxSteps
+	void Reset(int32 InTransitSteps)
+	{
+		TransitSteps = FMath::Clamp(InTransitSteps, 1, MaxSteps);
+		for (T& Slot : Slots)
+			Slot = T(0.f);
+		Cursor = 0;
+		Scale = T(1.f);
+		Total = T(0.f);
+		LateFraction = 1.f;
+	}
+
+	// Changes the steps a cohort spends on the conveyor, clamped to 1..MaxSteps, without emptying it. Cohorts in
+	// flight keep the same share of the transit still to go, rounded down, so a new step length keeps their
+	// arrival day. O(MaxSteps), only for when the step length or the transit time changes.
+	// InLateFraction of each inflow stays the whole transit and the rest leaves a step earlier, like
+	// TZombieConveyor does for transit times that are not a whole number of steps.
+	void SetTransitSteps(int32 InTransitSteps, float InLateFraction = 1.f)
+	{
+		const int32 NewTransitSteps = FMath::Clamp(InTransitSteps, 1, MaxSteps);
+		LateFraction = NewTransitSteps > 1 ? InLateFraction : 1.f;
+		if (NewTransitSteps == TransitSteps)
+			return;
+
+		T Resized[MaxSteps]{};
+		for (int32 ArrivalStep = Cursor; ArrivalStep < Cursor + TransitSteps; ++ArrivalStep)
+		{
+			const int32 StepsLeft = (ArrivalStep - Cursor) * NewTransitSteps / TransitSteps;
+			Resized[(Cursor + StepsLeft) % NewTransitSteps] += Slots[ArrivalStep % TransitSteps] * Scale;
+		}
+		for (int32 Slot = 0; Slot < MaxSteps; ++Slot)
+			Slots[Slot] = Resized[Slot];
+		TransitSteps = NewTransitSteps;
+		Scale = T(1.f);
+	}
+
+	// Empties the cohort arriving this step and returns how many people it held
+	T TakeOutflow()
+	{
+		T& Slot = Slots[Cursor % TransitSteps];
+		const T Outflow = Slot * Scale;
+		Slot = T(0.f);
+		Total = ZombieMath::Max(T(0.f), Total - Outflow);
+		return Outflow;
+	}
+
+	// Takes Fraction of every cohort still in flight. Returns how many people leaked.
+	T Leak(const T& Fraction)
+	{
+		const T Keep = T(1.f) - ZombieMath::Min(ZombieMath::Max(Fraction, T(0.f)), T(1.f));
+		const T Leaked = Total - Total * Keep;
+		Total = Total * Keep;
+		Scale = Scale * Keep;
+
+		// Fold the factor back into the cohorts before it underflows; rare, so still O(1) per step on average
+		if (ZombieMath::Value(Scale) < 1.e-6f)
+		{
+			for (T& Slot : Slots)
+				Slot = Slot * Scale;
+			Scale = T(1.f);
+		}
+		return Leaked;
+	}
+
+	// Puts people in the cohort entering this step and moves on to the next step
+	void AddInflowAndAdvance(const T& AmountOfPeople)
+	{
+		// The slot just emptied by TakeOutflow is the one that arrives TransitSteps from now
+		if (LateFraction < 1.f)
+		{
+			const T Early = AmountOfPeople * T(1.f - LateFraction);
+			Slots[(Cursor + TransitSteps - 1) % TransitSteps] += Early / Scale;
+			Slots[Cursor % TransitSteps] += (AmountOfPeople - Early) / Scale;
+		}
+		else
+		{
+			Slots[Cursor % TransitSteps] += AmountOfPeople / Scale;
+		}
+		Total += AmountOfPeople;
+		Cursor++;
+	}
+
+	// Removes up to AmountOfPeople, the same share from every cohort. Returns how many were removed.
+	T Remove(const T& AmountOfPeople)
+	{
+		if (!(ZombieMath::Value(Total) > 0.f))
+			return T(0.f);
+		return Leak(ZombieMath::Max(AmountOfPeople, T(0.f)) / Total);
+	}
+
+	const T& Content() const { return Total; }
+	int32 GetTransitSteps() const { return TransitSteps; }
+
+	bool operator==(const TSDLeakyConveyor& Other) const
+	{
+		if (!(TransitSteps == Other.TransitSteps && Cursor == Other.Cursor && Scale == Other.Scale && Total == Other.Total
+			&& LateFraction == Other.LateFraction))
+			return false;
+		for (int32 Slot = 0; Slot < MaxSteps; ++Slot)
+		{
+			if (!(Slots[Slot] == Other.Slots[Slot]))
+				return false;
+		}
+		return true;
+	}
+
+private:
+	template<typename U, int32 OtherMaxSteps>
+	friend class TSDLeakyConveyor;
+
+	// People per cohort divided by Scale, slot = arrival step % TransitSteps
+	T Slots[MaxSteps]{};
+	int32 TransitSteps{ 1 };
+	int32 Cursor{ 0 };
+	T Scale{ 1.f };
+	T Total{ 0.f };
+
+	// Share of each inflow that stays the whole TransitSteps, see SetTransitSteps
+	float LateFraction{ 1.f };
+};
+
+// First-in first-out queue of arrival batches, one per step, drained from the front at a limited rate.
+// The ring holds MaxBatches; when it is full, new arrivals join the newest batch. Every batch is added
+// and removed once, so a step is O(1) on average.
+template<typename T, int32 MaxBatches = 64>
+class TSDQueue
+{
+public:
+	// Adds the people arriving on Step as a batch at the back
+	void Add(const T& AmountOfPeople, int32 Step)
+	{
+		if (ZombieMath::Value(AmountOfPeople) <= 0.f)
+			return;
+
+		Total += AmountOfPeople;
+		if (Count == MaxBatches)
+		{
+			Batches[(Front + Count - 1) % MaxBatches].People += AmountOfPeople;
+			return;
+		}
+		Batches[(Front + Count) % MaxBatches] = { AmountOfPeople, Step };
+		Count++;
+	}
+
+	// Removes up to MaxAmount from the front, oldest batch first. Returns how many left.
+	T Take(const T& MaxAmount)
+	{
+		T Taken = T(0.f);
+		while (Count > 0 && Taken < MaxAmount)
+		{
+			FBatch& Batch = Batches[Front];
+			const T FromBatch = ZombieMath::Min(Batch.People, MaxAmount - Taken);
+			Batch.People -= FromBatch;
+			Taken += FromBatch;
+			if (ZombieMath::Value(Batch.People) > 0.f)
+				break;
+
+			Front = (Front + 1) % MaxBatches;
+			Count--;
+		}
+		Total = Count > 0 ? ZombieMath::Max(T(0.f), Total - Taken) : T(0.f);
+		return Taken;
+	}
+
+	const T& Content() const { return Total; }
+
+	// Step the person at the front arrived on, INDEX_NONE when the queue is empty
+	int32 GetOldestArrival() const { return Count > 0 ? Batches[Front].Arrival : INDEX_NONE; }
+
+private:
+	struct FBatch
+	{
+		T People;
+		int32 Arrival;
+	};
+
+	FBatch Batches[MaxBatches]{};
+	int32 Front{ 0 };
+	int32 Count{ 0 };
+	T Total{ 0.f };
+};
+
+using FSDDelay1 = TSDDelay1<float>;
+using FSDDelay3 = TSDDelay3<float>;
+using FSDSmooth1 = TSDSmooth1<float>;
+using FSDLeakyConveyor = TSDLeakyConveyor<float>;
+using FSDQueue = TSDQueue<float>;
@@ -0,0 +1,988 @@
+#include "SDModel.h"
+
+// Turns a description into the slots, tape and stock updates of an FSDModel
+class FSDCompiler
+{
+public:
+    explicit FSDCompiler(FSDModel& InModel) : Model(InModel) {}
+
+    bool Compile(const FSDModelDescription& Description);
+
+private:
+    using EOp = FSDModel::EOp;
+
+    // An auxiliary or flow with an equation to compile
+    struct FEquation
+    {
+        const FString* Name;
+        const FString* Text;
+        int32 Slot;
+    };
+
+    FSDModel& Model;
+    TMap<FString, int32> SlotsByName;
+    TMap<FString, int32> GraphsByName;
+    TMap<FString, int32> EquationsByName;
+    std::vector<uint8> bLiteral;
+
+    // Parser state for the equation being compiled
+    const FString* Text{ nullptr };
+    const FString* Owner{ nullptr };
+    int32 Pos{ 0 };
+    bool bFailed{ false };
+
+    int32 AddSlot(const FString& Name, float Value, bool bWritable);
+    bool Fail(const FString& Message);
+
+    // Names of model quantities referenced by an equation, graph calls excluded
+    void CollectNames(const FString& Equation, TArray<FString>& OutNames) const;
+
+    // Each returns the slot holding the result
+    int32 ParseComparison();
+    int32 ParseAdditive();
+    int32 ParseMultiplicative();
+    int32 ParseUnary();
+    int32 ParsePower();
+    int32 ParsePrimary();
+    int32 ParseCall(const FString& Name);
+
+    void SkipSpaces();
+    bool Match(const TCHAR* Token);
+    int32 Literal(float Value);
+    int32 Emit(EOp Op, int32 A, int32 B = INDEX_NONE, int32 C = INDEX_NONE);
+
+    // The last instruction if it computed Slot with Op into a temporary, which only the caller reads
+    FSDModel::FInstruction* FindFusable(int32 Slot, EOp Op);
+
+    // Puts taking the outflow of every conveyor on the tape, fused into the first multiply that reads it
+    void EmitConveyorOutflows();
+
+    // Appends what the queues let out and the stock updates to the tape
+    void EmitStockUpdates();
+};
+
+FORCEINLINE float FSDModel::Evaluate(EOp Op, float A, float B, float C)
+{
+    switch (Op)
+    {
+    case EOp::Copy:         return A;
+    case EOp::Add:          return A + B;
+    case EOp::Subtract:     return A - B;
+    case EOp::Multiply:     return A * B;
+    case EOp::Divide:       return A / B;
+    case EOp::Power:        return FMath::Pow(A, B);
+    case EOp::Negate:       return -A;
+    case EOp::Less:         return A < B ? 1.f : 0.f;
+    case EOp::LessEqual:    return A <= B ? 1.f : 0.f;
+    case EOp::Greater:      return A > B ? 1.f : 0.f;
+    case EOp::GreaterEqual: return A >= B ? 1.f : 0.f;
+    case EOp::Equal:        return A == B ? 1.f : 0.f;
+    case EOp::NotEqual:     return A != B ? 1.f : 0.f;
+    case EOp::Min:          return FMath::Min(A, B);
+    case EOp::Max:          return FMath::Max(A, B);
+    case EOp::Round:        return FMath::RoundToFloat(A);
+    case EOp::Floor:        return FMath::Floor(A);
+    case EOp::Ceil:         return FMath::CeilToFloat(A);
+    case EOp::Abs:          return FMath::Abs(A);
+    case EOp::Exp:          return FMath::Exp(A);
+    case EOp::Ln:           return FMath::Loge(A);
+    case EOp::Sqrt:         return FMath::Sqrt(A);
+    case EOp::Select:       return A != 0.f ? B : C;
+    default:                return 0.f;
+    }
+}
+
+bool FSDModel::Compile(const FSDModelDescription& Description)
+{
+    *this = FSDModel();
+    FSDCompiler Compiler(*this);
+    if (!Compiler.Compile(Description))
+    {
+        *this = FSDModel();
+        return false;
+    }
+    return true;
+}
+
+// Capacity check for new inflow, a negative capacity is no limit
+static FORCEINLINE float ConveyorInflow(float Inflow, float Capacity, float Content)
+{
+    if (Capacity >= 0.f)
+        Inflow = FMath::Min(Inflow, FMath::Max(0.f, Capacity - Content));
+    return FMath::Max(0.f, Inflow);
+}
+
+template<typename DelayType>
+float FSDModel::StepDelay(TDelayCall<DelayType>& Call, float Input, float DelayTime)
+{
+    if (!Call.bInitialized)
+    {
+        Call.State.Initialize(Call.InitialSlot == INDEX_NONE ? Input : Values[Call.InitialSlot], DelayTime, DT);
+        Call.bInitialized = true;
+    }
+    return Call.State.Step(Input, DelayTime, DT);
+}
+
+float FSDModel::StepSmooth(TDelayCall<FSDSmooth1>& Call, float Input, float SmoothingTime)
+{
+    if (!Call.bInitialized)
+    {
+        Call.State.Initialize(Call.InitialSlot == INDEX_NONE ? Input : Values[Call.InitialSlot]);
+        Call.bInitialized = true;
+    }
+    return Call.State.Step(Input, SmoothingTime, DT);
+}
+
+void FSDModel::Step()
+{
+    // Whatever reaches the end of a conveyor leaves it this step. For the plain conveyors that is an
+    // instruction on the tape, see FSDCompiler::EmitConveyorOutflows.
+    for (FLeakyConveyorState& State : LeakyConveyors)
+    {
+        Values[State.OutflowSlot] = State.Conveyor.TakeOutflow() / DT;
+        Values[State.LeakageSlot] = State.Conveyor.Leak(State.LeakFraction * DT) / DT;
+    }
+
+    // Most instructions read the result of the one before, so it is kept in a register rather than
+    // waiting on the store. The common, fused and stock operations are dispatched here, the rest go
+    // through Evaluate. Flows are all evaluated from the old stocks before the first stock is updated.
+    float* RESTRICT V = Values.data();
+    float Last = 0.f;
+    int32 LastSlot = INDEX_NONE;
+    for (const FInstruction& Instruction : Tape)
+    {
+        const float A = Instruction.A == LastSlot ? Last : V[Instruction.A];
+        const float B = Instruction.B == LastSlot ? Last : V[Instruction.B];
+        switch (Instruction.Op)
+        {
+        case EOp::Add:      Last = A + B; break;
+        case EOp::Subtract: Last = A - B; break;
+        case EOp::Multiply: Last = A * B; break;
+        case EOp::Divide:   Last = A / B; break;
+        case EOp::Min:      Last = FMath::Min(A, B); break;
+        case EOp::Max:      Last = FMath::Max(A, B); break;
+        case EOp::Round:    Last = FMath::RoundToFloat(A); break;
+        case EOp::Floor:    Last = FMath::Floor(A); break;
+        case EOp::Lookup:   Last = Graphs[Instruction.C].graph_lookup(A); break;
+        case EOp::Delay1:   Last = StepDelay(Delay1Calls[Instruction.C], A, B); break;
+        case EOp::Delay3:   Last = StepDelay(Delay3Calls[Instruction.C], A, B); break;
+        case EOp::Smooth1:  Last = StepSmooth(Smooth1Calls[Instruction.C], A, B); break;
+        case EOp::MultiplyRound:    Last = FMath::RoundToFloat(A * B); break;
+        case EOp::MinFloor:         Last = FMath::Min(A, FMath::Floor(B)); break;
+        case EOp::DivideMax:        Last = A / FMath::Max(B, V[Instruction.C]); break;
+        case EOp::DivideLookup:     Last = Graphs[Instruction.C].graph_lookup(A / B); break;
+        case EOp::ConveyorOutflow:  Last = Conveyors[Instruction.C].Get().TakeOutflow() / DT; break;
+        case EOp::ConveyorOutflowMultiply:
+            V[Instruction.A] = Conveyors[Instruction.C].Get().TakeOutflow() / DT;
+            Last = V[Instruction.A] * B;
+            break;
+        case EOp::QueueOutflow:
+            // A queue lets out what its outflow asks for, as far as it has people
+            Last = Queues[Instruction.C].Queue.Take(FMath::Max(0.f, A) * DT) / DT;
+            break;
+        case EOp::ReservoirInflow:
+            Last = A + DT * B;
+            Last = Instruction.C ? FMath::Max(0.f, Last) : Last;
+            break;
+        case EOp::ReservoirOutflow:
+            Last = A - DT * B;
+            Last = Instruction.C ? FMath::Max(0.f, Last) : Last;
+            break;
+        case EOp::ConveyorInflow:
+        {
+            FConveyorState& State = Conveyors[Instruction.C];
+            FZombieConveyor& Conveyor = State.Get();
+            Conveyor.AddInflowAndAdvance(ConveyorInflow(DT * B, State.Capacity, Conveyor.Content()));
+            Last = Conveyor.Content();
+            break;
+        }
+        case EOp::UpdateStock:
+            Last = UpdateStockValue(Stocks[Instruction.C]);
+            break;
+        default:            Last = Evaluate(Instruction.Op, A, B, V[Instruction.C]); break;
+        }
+        V[Instruction.Dest] = Last;
+        LastSlot = Instruction.Dest;
+    }
+
+    StepsFinished++;
+}
+
+float FSDModel::UpdateStockValue(const FStockUpdate& Stock)
+{
+    float Net = 0.f;
+    for (int32 i = Stock.FirstInflow; i < Stock.FirstInflow + Stock.NumInflows; ++i)
+        Net += Values[FlowSlots[i]];
+    for (int32 i = Stock.FirstOutflow; i < Stock.FirstOutflow + Stock.NumOutflows; ++i)
+        Net -= Values[FlowSlots[i]];
+
+    switch (Stock.Kind)
+    {
+    case EStockKind::Reservoir:
+    {
+        const float NewValue = Values[Stock.Slot] + DT * Net;
+        return Stock.bNonNegative ? FMath::Max(0.f, NewValue) : NewValue;
+    }
+    case EStockKind::Conveyor:
+    {
+        FConveyorState& State = Conveyors[Stock.Index];
+        FZombieConveyor& Conveyor = State.Get();
+        Conveyor.AddInflowAndAdvance(ConveyorInflow(DT * Net, State.Capacity, Conveyor.Content()));
+        return Conveyor.Content();
+    }
+    case EStockKind::LeakyConveyor:
+    {
+        FLeakyConveyorState& State = LeakyConveyors[Stock.Index];
+        State.Conveyor.AddInflowAndAdvance(ConveyorInflow(DT * Net, State.Capacity, State.Conveyor.Content()));
+        return State.Conveyor.Content();
+    }
+    default:
+    {
+        FQueueState& State = Queues[Stock.Index];
+        State.Queue.Add(FMath::Max(0.f, DT * Net), StepsFinished);
+        return State.Queue.Content();
+    }
+    }
+}
+
+int32 FSDModel::FindSlot(const FString& Name) const
+{
+    for (int32 Slot = 0; Slot < static_cast<int32>(SlotNames.size()); ++Slot)
+    {
+        if (SlotNames[Slot] == Name)
+            return Slot;
+    }
+    return INDEX_NONE;
+}
+
+void FSDModel::SetValue(int32 Slot, float Value)
+{
+    if (Values.size() > static_cast<size_t>(Slot) && bWritable[Slot])
+        Values[Slot] = Value;
+}
+
+bool FSDModel::ReplaceGraph(const FString& Name, const FZombieGraph& Graph)
+{
+    for (size_t Index = 0; Index < GraphNames.size(); ++Index)
+    {
+        if (GraphNames[Index] == Name)
+        {
+            Graphs[Index] = Graph;
+            return true;
+        }
+    }
+    return false;
+}
+
+FZombieConveyor* FSDModel::GetConveyor(int32 Slot)
+{
+    return const_cast<FZombieConveyor*>(static_cast<const FSDModel*>(this)->GetConveyor(Slot));
+}
+
+const FZombieConveyor* FSDModel::GetConveyor(int32 Slot) const
+{
+    for (const FStockUpdate& Stock : Stocks)
+    {
+        if (Stock.Slot == Slot && Stock.Kind == EStockKind::Conveyor)
+            return &Conveyors[Stock.Index].Get();
+    }
+    return nullptr;
+}
+
+void FSDModel::RefreshConveyorValue(int32 Slot)
+{
+    if (const FZombieConveyor* Conveyor = GetConveyor(Slot))
+        Values[Slot] = Conveyor->Content();
+}
+
+void FSDModel::LendConveyor(int32 Slot, FZombieConveyor* Conveyor)
+{
+    for (const FStockUpdate& Stock : Stocks)
+    {
+        if (Stock.Slot == Slot && Stock.Kind == EStockKind::Conveyor)
+            Conveyors[Stock.Index].Lent = Conveyor;
+    }
+}
+
+int32 FSDCompiler::AddSlot(const FString& Name, float Value, bool bWritable)
+{
+    const int32 Slot = static_cast<int32>(Model.Values.size());
+    Model.Values.push_back(Value);
+    Model.SlotNames.push_back(Name);
+    Model.bWritable.push_back(bWritable ? 1 : 0);
+    bLiteral.push_back(0);
+    if (!Name.IsEmpty())
+        SlotsByName.Add(Name, Slot);
+    return Slot;
+}
+
+bool FSDCompiler::Fail(const FString& Message)
+{
+    if (!bFailed)
+    {
+        if (Owner)
+            UE_LOG(LogTemp, Error, TEXT("SDModel: %s: %s"), **Owner, *Message);
+        else
+            UE_LOG(LogTemp, Error, TEXT("SDModel: %s"), *Message);
+    }
+    bFailed = true;
+    return false;
+}
+
+bool FSDCompiler::Compile(const FSDModelDescription& Description)
+{
+    Model.DT = FMath::Max(Description.DT, UE_KINDA_SMALL_NUMBER);
+
+    auto CheckName = [this](const FString& Name)
+    {
+        if (Name.IsEmpty())
+            return Fail(TEXT("Every constant, stock, auxiliary, flow and graph needs a name"));
+        if (SlotsByName.Contains(Name) || GraphsByName.Contains(Name))
+            return Fail(FString::Printf(TEXT("%s is defined more than once"), *Name));
+        return true;
+    };
+
+    // ---- Slots for everything with a name ----
+    for (const FSDStock& Stock : Description.Stocks)
+    {
+        if (!CheckName(Stock.Name))
+            return false;
+        AddSlot(Stock.Name, Stock.InitialValue, Stock.Type == ESDStockType::Reservoir);
+    }
+    for (const FSDConstant& Constant : Description.Constants)
+    {
+        if (!CheckName(Constant.Name))
+            return false;
+        AddSlot(Constant.Name, Constant.Value, true);
+    }
+    for (const FSDGraph& GraphDescription : Description.Graphs)
+    {
+        if (!CheckName(GraphDescription.Name))
+            return false;
+
+        FZombieGraph& Graph = Model.Graphs.emplace_back();
+        for (const FVector2D& Point : GraphDescription.Points)
+            Graph.graphPts.emplace_back(static_cast<float>(Point.X), static_cast<float>(Point.Y));
+        if (GraphDescription.BakeResolution > 0)
+            Graph.Bake(GraphDescription.BakeResolution);
+        Model.GraphNames.push_back(GraphDescription.Name);
+        GraphsByName.Add(GraphDescription.Name, static_cast<int32>(Model.Graphs.size()) - 1);
+    }
+
+    TArray<FEquation> Equations;
+    for (const FSDAuxiliary& Auxiliary : Description.Auxiliaries)
+    {
+        if (!CheckName(Auxiliary.Name))
+            return false;
+        Equations.Add({ &Auxiliary.Name, &Auxiliary.Equation, AddSlot(Auxiliary.Name, 0.f, false) });
+    }
+
+    // Conveyor outflows are filled by the conveyor, everything else is an equation. The equation of a queue
+    // outflow is the most that may leave and goes to a slot of its own, the queue fills in what did.
+    TArray<int32> FlowSlots;
+    TArray<int32> LimitSlots;
+    for (const FSDFlow& Flow : Description.Flows)
+    {
+        if (!CheckName(Flow.Name))
+            return false;
+        FlowSlots.Add(AddSlot(Flow.Name, 0.f, false));
+
+        const FSDStock* From = Description.Stocks.FindByPredicate([&Flow](const FSDStock& Stock) { return Stock.Name == Flow.From; });
+        const FSDStock* To = Description.Stocks.FindByPredicate([&Flow](const FSDStock& Stock) { return Stock.Name == Flow.To; });
+        if ((!Flow.From.IsEmpty() && !From) || (!Flow.To.IsEmpty() && !To))
+            return Fail(FString::Printf(TEXT("Flow %s connects to a stock that does not exist"), *Flow.Name));
+
+        if (Flow.bLeakage && (!From || From->Type != ESDStockType::Conveyor))
+            return Fail(FString::Printf(TEXT("Leakage flow %s has to drain a conveyor"), *Flow.Name));
+
+        LimitSlots.Add(From && From->Type == ESDStockType::Queue ? AddSlot(FString(), 0.f, false) : FlowSlots.Last());
+        if (!From || From->Type != ESDStockType::Conveyor)
+            Equations.Add({ &Flow.Name, &Flow.Equation, LimitSlots.Last() });
+    }
+
+    // ---- Dependency order ----
+    for (int32 Index = 0; Index < Equations.Num(); ++Index)
+        EquationsByName.Add(*Equations[Index].Name, Index);
+
+    TArray<int32> NumPending;
+    TArray<TArray<int32>> Dependents;
+    NumPending.SetNumZeroed(Equations.Num());
+    Dependents.SetNum(Equations.Num());
+
+    for (int32 Index = 0; Index < Equations.Num(); ++Index)
+    {
+        TArray<FString> Names;
+        CollectNames(*Equations[Index].Text, Names);
+        for (const FString& Name : Names)
+        {
+            if (const int32* Dependency = EquationsByName.Find(Name))
+            {
+                if (Dependents[*Dependency].Contains(Index))
+                    continue;
+                Dependents[*Dependency].Add(Index);
+                NumPending[Index]++;
+            }
+        }
+    }
+
+    // Kahn's algorithm, depth first so that an equation tends to come right after the one it reads. Equations
+    // that read no other and that no other reads go first, so they do not sit between a chain and the stock
+    // update at the end of it.
+    TArray<int32> Order;
+    TArray<int32> Ready;
+    for (int32 Index = Equations.Num() - 1; Index >= 0; --Index)
+    {
+        if (NumPending[Index] == 0 && Dependents[Index].Num() > 0)
+            Ready.Add(Index);
+    }
+    for (int32 Index = Equations.Num() - 1; Index >= 0; --Index)
+    {
+        if (NumPending[Index] == 0 && Dependents[Index].Num() == 0)
+            Ready.Add(Index);
+    }
+    while (Ready.Num() > 0)
+    {
+        const int32 Index = Ready.Pop();
+        Order.Add(Index);
+        for (int32 i = Dependents[Index].Num() - 1; i >= 0; --i)
+        {
+            if (--NumPending[Dependents[Index][i]] == 0)
+                Ready.Add(Dependents[Index][i]);
+        }
+    }
+
+    if (Order.Num() != Equations.Num())
+    {
+        FString Cycle;
+        for (int32 Index = 0; Index < Equations.Num(); ++Index)
+        {
+            if (NumPending[Index] > 0)
+                Cycle += (Cycle.IsEmpty() ? TEXT("") : TEXT(", ")) + *Equations[Index].Name;
+        }
+        return Fail(FString::Printf(TEXT("Circular definition between %s"), *Cycle));
+    }
+
+    // ---- Tape ----
+    for (const int32 Index : Order)
+    {
+        const FEquation& Equation = Equations[Index];
+        Text = Equation.Text;
+        Owner = Equation.Name;
+        Pos = 0;
+
+        const size_t TapeBefore = Model.Tape.size();
+        const int32 Result = ParseComparison();
+        SkipSpaces();
+        if (!bFailed && Pos < Text->Len())
+            Fail(FString::Printf(TEXT("Unexpected '%s'"), *Text->Mid(Pos)));
+        if (bFailed)
+            return false;
+
+        // Write the last instruction straight into the named slot instead of copying its temporary
+        if (Model.Tape.size() > TapeBefore && Model.Tape.back().Dest == Result)
+            Model.Tape.back().Dest = Equation.Slot;
+        else if (bLiteral[Result])
+            Model.Values[Equation.Slot] = Model.Values[Result];
+        else
+            Model.Tape.push_back({ EOp::Copy, Equation.Slot, Result, Result, Result });
+    }
+    Owner = nullptr;
+
+    // ---- Stock updates ----
+    for (int32 StockIndex = 0; StockIndex < Description.Stocks.Num(); ++StockIndex)
+    {
+        const FSDStock& Stock = Description.Stocks[StockIndex];
+
+        FSDModel::FStockUpdate Update;
+        Update.Slot = SlotsByName[Stock.Name];
+        Update.bNonNegative = Stock.bNonNegative;
+        Update.Kind = FSDModel::EStockKind::Reservoir;
+        Update.Index = INDEX_NONE;
+
+        Update.FirstInflow = static_cast<int32>(Model.FlowSlots.size());
+        for (int32 FlowIndex = 0; FlowIndex < Description.Flows.Num(); ++FlowIndex)
+        {
+            if (Description.Flows[FlowIndex].To == Stock.Name)
+                Model.FlowSlots.push_back(FlowSlots[FlowIndex]);
+        }
+        Update.NumInflows = static_cast<int32>(Model.FlowSlots.size()) - Update.FirstInflow;
+
+        // Conveyors and queues let people out themselves, a reservoir subtracts its outflows
+        Update.FirstOutflow = static_cast<int32>(Model.FlowSlots.size());
+        int32 Outflow = INDEX_NONE;
+        int32 Leakage = INDEX_NONE;
+        for (int32 FlowIndex = 0; FlowIndex < Description.Flows.Num(); ++FlowIndex)
+        {
+            const FSDFlow& Flow = Description.Flows[FlowIndex];
+            if (Flow.From != Stock.Name)
+                continue;
+
+            if (Stock.Type == ESDStockType::Reservoir)
+                Model.FlowSlots.push_back(FlowSlots[FlowIndex]);
+            else if (Flow.bLeakage && Leakage == INDEX_NONE)
+                Leakage = FlowSlots[FlowIndex];
+            else if (!Flow.bLeakage && Outflow == INDEX_NONE)
+                Outflow = FlowIndex;
+            else
+                return Fail(FString::Printf(TEXT("%s can only have one outflow and one leakage flow"), *Stock.Name));
+        }
+        Update.NumOutflows = static_cast<int32>(Model.FlowSlots.size()) - Update.FirstOutflow;
+
+        if (Stock.Type != ESDStockType::Reservoir && Outflow == INDEX_NONE)
+            return Fail(FString::Printf(TEXT("%s needs an outflow"), *Stock.Name));
+
+        const int32 TransitSteps = FZombieConveyor::TransitStepsFor(Stock.TransitTime, Model.DT);
+        const float Capacity = Stock.bLimitCapacity ? FMath::Max(0.f, Stock.Capacity) : -1.f;
+
+        if (Stock.Type == ESDStockType::Conveyor && Leakage == INDEX_NONE)
+        {
+            FSDModel::FConveyorState& State = Model.Conveyors.emplace_back();
+            State.Capacity = Capacity;
+            State.OutflowSlot = FlowSlots[Outflow];
+            State.Conveyor.Assign(0, std::vector<float>(TransitSteps, Stock.InitialValue / TransitSteps), Model.DT);
+
+            Model.Values[Update.Slot] = State.Conveyor.Content();
+            Update.Kind = FSDModel::EStockKind::Conveyor;
+            Update.Index = static_cast<int32>(Model.Conveyors.size()) - 1;
+        }
+        else if (Stock.Type == ESDStockType::Conveyor)
+        {
+            if (TransitSteps > FSDLeakyConveyor::MaxTransitSteps)
+            {
+                return Fail(FString::Printf(TEXT("%s leaks and takes %d steps, at most %d are supported"),
+                    *Stock.Name, TransitSteps, FSDLeakyConveyor::MaxTransitSteps));
+            }
+
+            FSDModel::FLeakyConveyorState& State = Model.LeakyConveyors.emplace_back();
+            State.Capacity = Capacity;
+            State.LeakFraction = Stock.LeakFraction;
+            State.OutflowSlot = FlowSlots[Outflow];
+            State.LeakageSlot = Leakage;
+            State.Conveyor.Reset(TransitSteps);
+            for (int32 Step = 0; Step < TransitSteps; ++Step)
+                State.Conveyor.AddInflowAndAdvance(Stock.InitialValue / TransitSteps);
+
+            Model.Values[Update.Slot] = State.Conveyor.Content();
+            Update.Kind = FSDModel::EStockKind::LeakyConveyor;
+            Update.Index = static_cast<int32>(Model.LeakyConveyors.size()) - 1;
+        }
+        else if (Stock.Type == ESDStockType::Queue)
+        {
+            FSDModel::FQueueState& State = Model.Queues.emplace_back();
+            State.OutflowSlot = FlowSlots[Outflow];
+            State.LimitSlot = LimitSlots[Outflow];
+            State.Queue.Add(Stock.InitialValue, 0);
+
+            Model.Values[Update.Slot] = State.Queue.Content();
+            Update.Kind = FSDModel::EStockKind::Queue;
+            Update.Index = static_cast<int32>(Model.Queues.size()) - 1;
+        }
+
+        Model.Stocks.push_back(Update);
+    }
+
+    EmitConveyorOutflows();
+    EmitStockUpdates();
+    return true;
+}
+
+void FSDCompiler::CollectNames(const FString& Equation, TArray<FString>& OutNames) const
+{
+    int32 i = 0;
+    while (i < Equation.Len())
+    {
+        const TCHAR Char = Equation[i];
+        if (FChar::IsDigit(Char) || Char == TEXT('.'))
+        {
+            // Skip numbers whole, so the e of 1e-3 is not taken for a name
+            while (i < Equation.Len() && (FChar::IsDigit(Equation[i]) || Equation[i] == TEXT('.')))
+                ++i;
+            if (i < Equation.Len() && (Equation[i] == TEXT('e') || Equation[i] == TEXT('E')))
+            {
+                ++i;
+                if (i < Equation.Len() && (Equation[i] == TEXT('+') || Equation[i] == TEXT('-')))
+                    ++i;
+                while (i < Equation.Len() && FChar::IsDigit(Equation[i]))
+                    ++i;
+            }
+        }
+        else if (FChar::IsAlpha(Char) || Char == TEXT('_'))
+        {
+            const int32 Start = i;
+            while (i < Equation.Len() && (FChar::IsAlnum(Equation[i]) || Equation[i] == TEXT('_')))
+                ++i;
+
+            int32 Next = i;
+            while (Next < Equation.Len() && FChar::IsWhitespace(Equation[Next]))
+                ++Next;
+            if (Next >= Equation.Len() || Equation[Next] != TEXT('('))
+                OutNames.Add(Equation.Mid(Start, i - Start));
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+void FSDCompiler::SkipSpaces()
+{
+    while (Pos < Text->Len() && FChar::IsWhitespace((*Text)[Pos]))
+        ++Pos;
+}
+
+bool FSDCompiler::Match(const TCHAR* Token)
+{
+    SkipSpaces();
+    const int32 Length = FCString::Strlen(Token);
+    if (FCString::Strncmp(**Text + Pos, Token, Length) != 0)
+        return false;
+    Pos += Length;
+    return true;
+}
+
+int32 FSDCompiler::Literal(float Value)
+{
+    for (int32 Slot = 0; Slot < static_cast<int32>(Model.Values.size()); ++Slot)
+    {
+        if (bLiteral[Slot] && Model.Values[Slot] == Value)
+            return Slot;
+    }
+    const int32 Slot = AddSlot(FString(), Value, false);
+    bLiteral[Slot] = 1;
+    return Slot;
+}
+
+FSDModel::FInstruction* FSDCompiler::FindFusable(int32 Slot, EOp Op)
+{
+    if (Model.Tape.empty())
+        return nullptr;
+
+    FSDModel::FInstruction& Last = Model.Tape.back();
+    if (Last.Op != Op || Last.Dest != Slot || bLiteral[Slot] || !Model.SlotNames[Slot].IsEmpty())
+        return nullptr;
+    return &Last;
+}
+
+int32 FSDCompiler::Emit(EOp Op, int32 A, int32 B, int32 C)
+{
+    if (bFailed)
+        return 0;
+
+    B = B == INDEX_NONE ? A : B;
+    C = C == INDEX_NONE ? A : C;
+
+    // Constant folding: only literals fold, named constants can still change through SetValue.
+    // Lookups and delays have operands that are not slots, and delays have state.
+    if (Op < EOp::Lookup && bLiteral[A] && bLiteral[B] && bLiteral[C])
+        return Literal(FSDModel::Evaluate(Op, Model.Values[A], Model.Values[B], Model.Values[C]));
+
+    // Fusing into the instruction that made the operand saves a dispatch and a store
+    if (Op == EOp::Round)
+    {
+        if (FSDModel::FInstruction* Product = FindFusable(A, EOp::Multiply))
+        {
+            Product->Op = EOp::MultiplyRound;
+            return Product->Dest;
+        }
+    }
+    else if (Op == EOp::Lookup)
+    {
+        if (FSDModel::FInstruction* Quotient = FindFusable(A, EOp::Divide))
+        {
+            Quotient->Op = EOp::DivideLookup;
+            Quotient->C = C;
+            return Quotient->Dest;
+        }
+    }
+    else if (Op == EOp::Divide && A != B)
+    {
+        if (FSDModel::FInstruction* Divisor = FindFusable(B, EOp::Max))
+        {
+            Divisor->Op = EOp::DivideMax;
+            Divisor->C = Divisor->B;
+            Divisor->B = Divisor->A;
+            Divisor->A = A;
+            return Divisor->Dest;
+        }
+    }
+    else if (Op == EOp::Min && A != B)
+    {
+        FSDModel::FInstruction* Floor = FindFusable(B, EOp::Floor);
+        const int32 Other = Floor ? A : B;
+        Floor = Floor ? Floor : FindFusable(A, EOp::Floor);
+        if (Floor)
+        {
+            Floor->Op = EOp::MinFloor;
+            Floor->B = Floor->A;
+            Floor->A = Other;
+            Floor->C = Other;
+            return Floor->Dest;
+        }
+    }
+
+    const int32 Dest = AddSlot(FString(), 0.f, false);
+    Model.Tape.push_back({ Op, Dest, A, B, C });
+    return Dest;
+}
+
+void FSDCompiler::EmitConveyorOutflows()
+{
+    for (int32 Index = 0; Index < static_cast<int32>(Model.Conveyors.size()); ++Index)
+    {
+        const int32 Outflow = Model.Conveyors[Index].OutflowSlot;
+
+        // The outflow has to be taken before anything reads it. The initial value of a delay is read
+        // by the delay instruction, so that counts as reading it too.
+        size_t FirstReader = 0;
+        for (; FirstReader < Model.Tape.size(); ++FirstReader)
+        {
+            const FSDModel::FInstruction& Instruction = Model.Tape[FirstReader];
+            if (Instruction.A == Outflow || Instruction.B == Outflow || Instruction.C == Outflow)
+                break;
+
+            const bool bReadsInitial =
+                (Instruction.Op == EOp::Delay1 && Model.Delay1Calls[Instruction.C].InitialSlot == Outflow) ||
+                (Instruction.Op == EOp::Delay3 && Model.Delay3Calls[Instruction.C].InitialSlot == Outflow) ||
+                (Instruction.Op == EOp::Smooth1 && Model.Smooth1Calls[Instruction.C].InitialSlot == Outflow);
+            if (bReadsInitial)
+                break;
+        }
+
+        // Typically outflow * conversion, e.g. bitten people turning into zombies
+        if (FirstReader < Model.Tape.size() && Model.Tape[FirstReader].Op == EOp::Multiply)
+        {
+            FSDModel::FInstruction& Product = Model.Tape[FirstReader];
+            if (Product.A != Product.B)
+            {
+                Product.B = Product.A == Outflow ? Product.B : Product.A;
+                Product.A = Outflow;
+                Product.C = Index;
+                Product.Op = EOp::ConveyorOutflowMultiply;
+                continue;
+            }
+        }
+
+        Model.Tape.insert(Model.Tape.begin(), { EOp::ConveyorOutflow, Outflow, Outflow, Outflow, Index });
+    }
+}
+
+void FSDCompiler::EmitStockUpdates()
+{
+    for (int32 Index = 0; Index < static_cast<int32>(Model.Queues.size()); ++Index)
+    {
+        const FSDModel::FQueueState& State = Model.Queues[Index];
+        Model.Tape.push_back({ EOp::QueueOutflow, State.OutflowSlot, State.LimitSlot, State.LimitSlot, Index });
+    }
+
+    // A stock with a single flow is updated straight from it. Starting from that flow instead of from a
+    // net flow of 0 can only change the sign of a zero.
+    for (int32 Index = 0; Index < static_cast<int32>(Model.Stocks.size()); ++Index)
+    {
+        const FSDModel::FStockUpdate& Stock = Model.Stocks[Index];
+        const bool bSingleInflow = Stock.NumInflows == 1 && Stock.NumOutflows == 0;
+        const bool bSingleOutflow = Stock.NumInflows == 0 && Stock.NumOutflows == 1;
+        const int32 Flow = bSingleInflow ? Model.FlowSlots[Stock.FirstInflow] : bSingleOutflow ? Model.FlowSlots[Stock.FirstOutflow] : INDEX_NONE;
+
+        if (Stock.Kind == FSDModel::EStockKind::Reservoir && Flow != INDEX_NONE)
+            Model.Tape.push_back({ bSingleInflow ? EOp::ReservoirInflow : EOp::ReservoirOutflow, Stock.Slot, Stock.Slot, Flow, Stock.bNonNegative ? 1 : 0 });
+        else if (Stock.Kind == FSDModel::EStockKind::Conveyor && bSingleInflow)
+            Model.Tape.push_back({ EOp::ConveyorInflow, Stock.Slot, Flow, Flow, Stock.Index });
+        else
+            Model.Tape.push_back({ EOp::UpdateStock, Stock.Slot, Stock.Slot, Stock.Slot, Index });
+    }
+}
+
+int32 FSDCompiler::ParseComparison()
+{
+    const int32 Left = ParseAdditive();
+
+    // Two-character operators first
+    static const TPair<const TCHAR*, EOp> Comparisons[] = {
+        { TEXT("<="), EOp::LessEqual }, { TEXT(">="), EOp::GreaterEqual }, { TEXT("<>"), EOp::NotEqual },
+        { TEXT("<"), EOp::Less }, { TEXT(">"), EOp::Greater }, { TEXT("="), EOp::Equal } };
+    for (const TPair<const TCHAR*, EOp>& Comparison : Comparisons)
+    {
+        if (Match(Comparison.Key))
+            return Emit(Comparison.Value, Left, ParseAdditive());
+    }
+    return Left;
+}
+
+int32 FSDCompiler::ParseAdditive()
+{
+    int32 Left = ParseMultiplicative();
+    for (;;)
+    {
+        if (Match(TEXT("+")))
+            Left = Emit(EOp::Add, Left, ParseMultiplicative());
+        else if (Match(TEXT("-")))
+            Left = Emit(EOp::Subtract, Left, ParseMultiplicative());
+        else
+            return Left;
+    }
+}
+
+int32 FSDCompiler::ParseMultiplicative()
+{
+    int32 Left = ParseUnary();
+    for (;;)
+    {
+        if (Match(TEXT("*")))
+            Left = Emit(EOp::Multiply, Left, ParseUnary());
+        else if (Match(TEXT("/")))
+            Left = Emit(EOp::Divide, Left, ParseUnary());
+        else
+            return Left;
+    }
+}
+
+int32 FSDCompiler::ParseUnary()
+{
+    if (Match(TEXT("-")))
+        return Emit(EOp::Negate, ParseUnary());
+    if (Match(TEXT("+")))
+        return ParseUnary();
+    return ParsePower();
+}
+
+int32 FSDCompiler::ParsePower()
+{
+    const int32 Base = ParsePrimary();
+    if (Match(TEXT("^")))
+        return Emit(EOp::Power, Base, ParseUnary());
+    return Base;
+}
+
+int32 FSDCompiler::ParsePrimary()
+{
+    SkipSpaces();
+    if (bFailed || Pos >= Text->Len())
+    {
+        Fail(TEXT("Equation ends early"));
+        return 0;
+    }
+
+    if (Match(TEXT("(")))
+    {
+        const int32 Inner = ParseComparison();
+        if (!Match(TEXT(")")))
+            Fail(TEXT("Missing ')'"));
+        return Inner;
+    }
+
+    const TCHAR Char = (*Text)[Pos];
+    if (FChar::IsDigit(Char) || Char == TEXT('.'))
+    {
+        TCHAR* End = nullptr;
+        const float Value = FCString::Strtod(**Text + Pos, &End);
+        Pos = static_cast<int32>(End - **Text);
+        return Literal(Value);
+    }
+
+    if (FChar::IsAlpha(Char) || Char == TEXT('_'))
+    {
+        const int32 Start = Pos;
+        while (Pos < Text->Len() && (FChar::IsAlnum((*Text)[Pos]) || (*Text)[Pos] == TEXT('_')))
+            ++Pos;
+        const FString Name = Text->Mid(Start, Pos - Start);
+
+        if (Match(TEXT("(")))
+            return ParseCall(Name);
+
+        if (const int32* Slot = SlotsByName.Find(Name))
+            return *Slot;
+
+        Fail(FString::Printf(TEXT("Unknown name %s"), *Name));
+        return 0;
+    }
+
+    Fail(FString::Printf(TEXT("Unexpected '%s'"), *Text->Mid(Pos)));
+    return 0;
+}
+
+int32 FSDCompiler::ParseCall(const FString& Name)
+{
+    TArray<int32, TInlineAllocator<3>> Arguments;
+    if (!Match(TEXT(")")))
+    {
+        do
+        {
+            Arguments.Add(ParseComparison());
+        }
+        while (Match(TEXT(",")));
+
+        if (!Match(TEXT(")")))
+        {
+            Fail(FString::Printf(TEXT("Missing ')' after the arguments of %s"), *Name));
+            return 0;
+        }
+    }
+
+    auto Expect = [this, &Name, &Arguments](int32 Count)
+    {
+        if (Arguments.Num() == Count)
+            return true;
+        return Fail(FString::Printf(TEXT("%s takes %d argument(s), got %d"), *Name, Count, Arguments.Num()));
+    };
+
+    if (const int32* Graph = GraphsByName.Find(Name))
+        return Expect(1) ? Emit(EOp::Lookup, Arguments[0], Arguments[0], *Graph) : 0;
+
+    // MIN and MAX take two or more
+    if (Name.Equals(TEXT("MIN"), ESearchCase::IgnoreCase) || Name.Equals(TEXT("MAX"), ESearchCase::IgnoreCase))
+    {
+        if (Arguments.Num() < 2)
+        {
+            Fail(FString::Printf(TEXT("%s takes at least 2 arguments"), *Name));
+            return 0;
+        }
+
+        const EOp Op = Name.Equals(TEXT("MIN"), ESearchCase::IgnoreCase) ? EOp::Min : EOp::Max;
+        int32 Result = Arguments[0];
+        for (int32 i = 1; i < Arguments.Num(); ++i)
+            Result = Emit(Op, Result, Arguments[i]);
+        return Result;
+    }
+
+    if (Name.Equals(TEXT("IF"), ESearchCase::IgnoreCase))
+        return Expect(3) ? Emit(EOp::Select, Arguments[0], Arguments[1], Arguments[2]) : 0;
+
+    // Input, time and an optional initial value; every call gets its own state
+    const bool bDelay1 = Name.Equals(TEXT("DELAY1"), ESearchCase::IgnoreCase);
+    const bool bDelay3 = Name.Equals(TEXT("DELAY3"), ESearchCase::IgnoreCase);
+    if (bDelay1 || bDelay3 || Name.Equals(TEXT("SMTH1"), ESearchCase::IgnoreCase))
+    {
+        if (Arguments.Num() != 2 && Arguments.Num() != 3)
+        {
+            Fail(FString::Printf(TEXT("%s takes 2 or 3 arguments, got %d"), *Name, Arguments.Num()));
+            return 0;
+        }
+
+        const int32 InitialSlot = Arguments.Num() == 3 ? Arguments[2] : INDEX_NONE;
+        if (bDelay1)
+        {
+            Model.Delay1Calls.push_back({ FSDDelay1(), InitialSlot, false });
+            return Emit(EOp::Delay1, Arguments[0], Arguments[1], static_cast<int32>(Model.Delay1Calls.size()) - 1);
+        }
+        if (bDelay3)
+        {
+            Model.Delay3Calls.push_back({ FSDDelay3(), InitialSlot, false });
+            return Emit(EOp::Delay3, Arguments[0], Arguments[1], static_cast<int32>(Model.Delay3Calls.size()) - 1);
+        }
+        Model.Smooth1Calls.push_back({ FSDSmooth1(), InitialSlot, false });
+        return Emit(EOp::Smooth1, Arguments[0], Arguments[1], static_cast<int32>(Model.Smooth1Calls.size()) - 1);
+    }
+
+    static const TPair<const TCHAR*, EOp> UnaryFunctions[] = {
+        { TEXT("ROUND"), EOp::Round }, { TEXT("FLOOR"), EOp::Floor }, { TEXT("CEIL"), EOp::Ceil }, { TEXT("ABS"), EOp::Abs },
+        { TEXT("EXP"), EOp::Exp }, { TEXT("LN"), EOp::Ln }, { TEXT("SQRT"), EOp::Sqrt } };
+    for (const TPair<const TCHAR*, EOp>& Function : UnaryFunctions)
+    {
+        if (Name.Equals(Function.Key, ESearchCase::IgnoreCase))
+            return Expect(1) ? Emit(Function.Value, Arguments[0]) : 0;
+    }
+
+    Fail(FString::Printf(TEXT("Unknown function %s"), *Name));
+    return 0;
+}
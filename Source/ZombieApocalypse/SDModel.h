@@ -0,0 +1,365 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZombieModel.h"
+#include "SDDelays.h"
+#include <vector>
+#include "SDModel.generated.h"
+
+// Data-driven stock-and-flow models. A model is described by named constants, stocks, flows,
+// auxiliaries and graphical functions, with Stella-like equations, e.g.
+//   getting_bitten = MIN(ROUND(Susceptible / MAX(non_zombie_population, 1) * total_bitten_per_day), FLOOR(Susceptible))
+// FSDModel compiles a description once into a flat tape and steps it with Euler.
+//
+// Equations support + - * / ^, comparisons (< <= > >= = <>, 1 or 0), parentheses, numbers, names of
+// constants, stocks, auxiliaries and flows, and the functions MIN, MAX, ROUND, FLOOR, CEIL, ABS, EXP,
+// LN, SQRT and IF(condition, then, else). A graphical function is called by its name, e.g. effect(x).
+// DELAY1(input, delay time [, initial outflow]), DELAY3(...) and SMTH1(input, smoothing time [, initial])
+// keep state between steps, see SDDelays.h; every call has its own.
+
+UENUM(BlueprintType)
+enum class ESDStockType : uint8
+{
+	// Accumulates its inflows minus its outflows
+	Reservoir,
+
+	// People entering leave TransitTime days later through its outflow, less what leaks out on the way
+	Conveyor,
+
+	// People leave in the order they arrived, at most as many per day as its outflow equation says
+	Queue
+};
+
+USTRUCT(BlueprintType)
+struct FSDConstant
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	FString Name;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	float Value{ 0.f };
+};
+
+USTRUCT(BlueprintType)
+struct FSDStock
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	FString Name;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	float InitialValue{ 0.f };
+
+	// Clamp a reservoir at 0 after every step
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	bool bNonNegative{ true };
+
+	// A conveyor or a queue has exactly one outflow, plus a leakage flow for a leaky conveyor.
+	// The initial value of a conveyor is spread evenly over the transit time.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	ESDStockType Type{ ESDStockType::Reservoir };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model", meta = (EditCondition = "Type == ESDStockType::Conveyor", ClampMin = "0"))
+	float TransitTime{ 1.f };
+
+	// Most a conveyor holds when bLimitCapacity is set, 0 lets nothing in. Inflow that does not fit is lost,
+	// the source stock still drains.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model", meta = (EditCondition = "Type == ESDStockType::Conveyor"))
+	bool bLimitCapacity{ false };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model", meta = (EditCondition = "Type == ESDStockType::Conveyor && bLimitCapacity", ClampMin = "0"))
+	float Capacity{ 0.f };
+
+	// Fraction of the people on a conveyor that leave through its leakage flow per day
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model", meta = (EditCondition = "Type == ESDStockType::Conveyor", ClampMin = "0", ClampMax = "1"))
+	float LeakFraction{ 0.f };
+};
+
+USTRUCT(BlueprintType)
+struct FSDFlow
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	FString Name;
+
+	// Stock drained by the flow, empty for a source outside the model
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	FString From;
+
+	// Stock filled by the flow, empty for a sink outside the model
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	FString To;
+
+	// Rate per day. Ignored for the outflows of a conveyor, which are whatever arrives at its end and
+	// whatever leaks. For the outflow of a queue it is the most that can leave; equations that use the
+	// outflow of a queue see what left in the step before.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	FString Equation;
+
+	// Takes the leakage of the conveyor it drains instead of what reaches its end
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	bool bLeakage{ false };
+};
+
+USTRUCT(BlueprintType)
+struct FSDAuxiliary
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	FString Name;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	FString Equation;
+};
+
+// Piecewise linear function of one input, same as FZombieGraph
+USTRUCT(BlueprintType)
+struct FSDGraph
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	FString Name;
+
+	// x, y points in increasing x
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	TArray<FVector2D> Points;
+
+	// See FZombieGraph::Bake, 0 scans the points on every lookup
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model", meta = (ClampMin = "0"))
+	int32 BakeResolution{ 256 };
+};
+
+USTRUCT(BlueprintType)
+struct FSDModelDescription
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	TArray<FSDConstant> Constants;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	TArray<FSDStock> Stocks;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	TArray<FSDFlow> Flows;
+
+	// In any order, they are sorted by what they depend on when the model is compiled
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	TArray<FSDAuxiliary> Auxiliaries;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model")
+	TArray<FSDGraph> Graphs;
+
+	// Step size in days
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Model", meta = (ClampMin = "0.001"))
+	float DT{ 1.f };
+};
+
+// Compiled stock-and-flow model. Every named quantity and intermediate result has a slot in one float
+// array; auxiliaries and flows are evaluated by a flat tape of three-address instructions in dependency
+// order, so a step is a single switch loop with no virtual calls or allocations.
+class ZOMBIEAPOCALYPSE_API FSDModel
+{
+public:
+	// Compiles Description and sets every stock to its initial value. Logs and returns false on an error
+	// such as an unknown name, a circular definition or an equation that does not parse.
+	bool Compile(const FSDModelDescription& Description);
+
+	// Advances every stock by DT
+	void Step();
+
+	// Slot of a constant, stock, auxiliary or flow, INDEX_NONE if there is none with that name
+	int32 FindSlot(const FString& Name) const;
+
+	// Value after the last step. Auxiliaries and flows are from the evaluation at the start of it.
+	float GetValue(int32 Slot) const { return Values[Slot]; }
+
+	// Changes a constant or a reservoir, e.g. to apply gameplay. Conveyors go through GetConveyor.
+	void SetValue(int32 Slot, float Value);
+
+	// Replaces a graphical function, e.g. with a curve that is already loaded and baked. Returns false if there is none by that name.
+	bool ReplaceGraph(const FString& Name, const FZombieGraph& Graph);
+
+	// Conveyor behind a stock slot, nullptr if the stock is not one or leaks. Call RefreshConveyorValue after changing it.
+	FZombieConveyor* GetConveyor(int32 Slot);
+	const FZombieConveyor* GetConveyor(int32 Slot) const;
+	void RefreshConveyorValue(int32 Slot);
+
+	// Steps Conveyor in place of the conveyor behind a stock slot until lent nullptr, so a caller that keeps its
+	// own cohorts does not have to copy them in and out. Copies of this model step the same Conveyor.
+	void LendConveyor(int32 Slot, FZombieConveyor* Conveyor);
+
+	int32 GetStepsFinished() const { return StepsFinished; }
+	float GetTime() const { return StepsFinished * DT; }
+	float GetDT() const { return DT; }
+
+	int32 GetNumStocks() const { return static_cast<int32>(Stocks.size()); }
+	int32 GetStockSlot(int32 Stock) const { return Stocks[Stock].Slot; }
+	const FString& GetSlotName(int32 Slot) const { return SlotNames[Slot]; }
+
+	// Instructions per step, stock updates included, after constant folding and fusing
+	int32 GetTapeLength() const { return static_cast<int32>(Tape.size()); }
+
+private:
+	enum class EOp : uint8
+	{
+		Copy,
+		Add,
+		Subtract,
+		Multiply,
+		Divide,
+		Power,
+		Negate,
+		Less,
+		LessEqual,
+		Greater,
+		GreaterEqual,
+		Equal,
+		NotEqual,
+		Min,
+		Max,
+		Round,
+		Floor,
+		Ceil,
+		Abs,
+		Exp,
+		Ln,
+		Sqrt,
+		Select,
+		Lookup,
+		Delay1,
+		Delay3,
+		Smooth1,
+
+		// Fused by the compiler from the pattern in the comment, never folded
+		MultiplyRound,			// ROUND(A * B)
+		MinFloor,				// MIN(A, FLOOR(B))
+		DivideMax,				// A / MAX(B, C), e.g. a share of a population that may be empty
+		DivideLookup,			// graph C(A / B)
+		ConveyorOutflow,		// what reaches the end of conveyor C, per day
+		ConveyorOutflowMultiply,	// Values[A] = outflow of conveyor C per day, times B
+
+		// Stock updates, at the end of the tape once every flow is known. Dest is the stock.
+		QueueOutflow,			// what queue C lets out per day, at most A
+		ReservoirInflow,		// A + DT * B, kept at 0 or above if C is 1
+		ReservoirOutflow,		// A - DT * B, kept at 0 or above if C is 1
+		ConveyorInflow,			// content of conveyor C after B per day enters it
+		UpdateStock				// any other stock, entry C of Stocks
+	};
+
+	// Values[Dest] = Op(Values[A], Values[B], Values[C]). Lookup reads graph C; the delays read
+	// input A and time B and keep their state in entry C of their array; the conveyor and queue
+	// ops use entry C of Conveyors or Queues.
+	struct FInstruction
+	{
+		EOp Op;
+		int32 Dest;
+		int32 A;
+		int32 B;
+		int32 C;
+	};
+
+	enum class EStockKind : uint8
+	{
+		Reservoir,
+		Conveyor,
+		LeakyConveyor,
+		Queue
+	};
+
+	struct FStockUpdate
+	{
+		int32 Slot;
+
+		// Ranges of FlowSlots
+		int32 FirstInflow;
+		int32 NumInflows;
+		int32 FirstOutflow;
+		int32 NumOutflows;
+
+		bool bNonNegative;
+
+		// Index into Conveyors, LeakyConveyors or Queues
+		EStockKind Kind;
+		int32 Index;
+	};
+
+	struct FConveyorState
+	{
+		FZombieConveyor Conveyor;
+		float Capacity;
+
+		// Stepped instead of Conveyor while set, see LendConveyor
+		FZombieConveyor* Lent{ nullptr };
+
+		FZombieConveyor& Get() { return Lent ? *Lent : Conveyor; }
+		const FZombieConveyor& Get() const { return Lent ? *Lent : Conveyor; }
+
+		// Flow slot that receives what leaves, as a rate per day
+		int32 OutflowSlot;
+	};
+
+	struct FLeakyConveyorState
+	{
+		FSDLeakyConveyor Conveyor;
+		float Capacity;
+		float LeakFraction;
+		int32 OutflowSlot;
+		int32 LeakageSlot;
+	};
+
+	struct FQueueState
+	{
+		FSDQueue Queue;
+		int32 OutflowSlot;
+
+		// Result of the outflow equation, the most that may leave per day
+		int32 LimitSlot;
+	};
+
+	// State of one DELAY1, DELAY3 or SMTH1 call, initialized on its first evaluation
+	template<typename StateType>
+	struct TDelayCall
+	{
+		StateType State;
+		int32 InitialSlot{ INDEX_NONE };
+		bool bInitialized{ false };
+	};
+
+	static float Evaluate(EOp Op, float A, float B, float C);
+
+	// Adds the net flow of a stock, returns its new value
+	float UpdateStockValue(const FStockUpdate& Stock);
+
+	template<typename DelayType>
+	float StepDelay(TDelayCall<DelayType>& Call, float Input, float DelayTime);
+	float StepSmooth(TDelayCall<FSDSmooth1>& Call, float Input, float SmoothingTime);
+
+	std::vector<float> Values;
+	std::vector<FString> SlotNames;
+	std::vector<FInstruction> Tape;
+	std::vector<FStockUpdate> Stocks;
+	std::vector<int32> FlowSlots;
+	std::vector<FConveyorState> Conveyors;
+	std::vector<FLeakyConveyorState> LeakyConveyors;
+	std::vector<FQueueState> Queues;
+	std::vector<TDelayCall<FSDDelay1>> Delay1Calls;
+	std::vector<TDelayCall<FSDDelay3>> Delay3Calls;
+	std::vector<TDelayCall<FSDSmooth1>> Smooth1Calls;
+	std::vector<FZombieGraph> Graphs;
+	std::vector<FString> GraphNames;
+
+	// Constants and stocks that SetValue may change
+	std::vector<uint8> bWritable;
+
+	float DT{ 1.f };
+	int32 StepsFinished{ 0 };
+
+	friend class FSDCompiler;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "SDModel.h"
+#include "SDModelAsset.generated.h"
+
+/**
+ * A stock-and-flow model edited in the content browser. Compile the description with FSDModel::Compile,
+ * or run it headless with the SDRun commandlet.
+ */
+UCLASS(BlueprintType)
+class ZOMBIEAPOCALYPSE_API USDModelAsset : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Model")
+	FSDModelDescription Description;
+};
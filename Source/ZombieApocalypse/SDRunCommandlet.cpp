@@ -0,0 +1,71 @@
+#include "SDRunCommandlet.h"
+#include "SDModelAsset.h"
+#include "ZombieCommandletHelpers.h"
+#include "ZombieSDModel.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+USDRunCommandlet::USDRunCommandlet()
+{
+    IsClient = false;
+    IsEditor = false;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 USDRunCommandlet::Main(const FString& Params)
+{
+    FSDModel Model;
+
+    FString AssetPath;
+    if (FParse::Value(*Params, TEXT("Asset="), AssetPath))
+    {
+        const USDModelAsset* Asset = LoadObject<USDModelAsset>(nullptr, *AssetPath);
+        if (!Asset)
+        {
+            UE_LOG(LogTemp, Error, TEXT("SDRun: Could not load model asset %s"), *AssetPath);
+            return 1;
+        }
+        if (!Model.Compile(Asset->Description))
+            return 1;
+    }
+    else
+    {
+        FZombieModel ZombieModel;
+        if (!ZombieCommandlets::LoadBaseModel(Params, ZombieModel) || !ZombieSD::Compile(ZombieModel, Model))
+            return 1;
+    }
+
+    float Days = 180.f;
+    FParse::Value(*Params, TEXT("Days="), Days);
+    const int32 NumSteps = FMath::Max(0, FMath::RoundToInt(Days / Model.GetDT()));
+
+    // One row per step: the time, then every stock
+    FString Csv(TEXT("---,Time"));
+    for (int32 Stock = 0; Stock < Model.GetNumStocks(); ++Stock)
+        Csv += TEXT(",") + Model.GetSlotName(Model.GetStockSlot(Stock));
+    Csv += TEXT("\n");
+
+    for (int32 Step = 0; Step < NumSteps; ++Step)
+    {
+        Model.Step();
+
+        Csv += FString::Printf(TEXT("%d, %.3f"), Step + 1, Model.GetTime());
+        for (int32 Stock = 0; Stock < Model.GetNumStocks(); ++Stock)
+            Csv += FString::Printf(TEXT(", %.3f"), Model.GetValue(Model.GetStockSlot(Stock)));
+        Csv += TEXT("\n");
+    }
+
+    FString OutPath = FPaths::ProjectSavedDir() / TEXT("SDRun.csv");
+    FParse::Value(*Params, TEXT("Out="), OutPath);
+
+    if (!FFileHelper::SaveStringToFile(Csv, *OutPath))
+    {
+        UE_LOG(LogTemp, Error, TEXT("SDRun: Could not write %s"), *OutPath);
+        return 1;
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("SDRun: %d stocks, %d instructions per step, %d steps of %.3f days, wrote %s"),
+        Model.GetNumStocks(), Model.GetTapeLength(), NumSteps, Model.GetDT(), *OutPath);
+    return 0;
+}
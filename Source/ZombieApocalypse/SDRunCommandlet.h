@@ -0,0 +1,27 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SDRunCommandlet.generated.h"
+
+/**
+ * Compiles a stock-and-flow model and writes every stock after every step.
+ *
+ * Example:
+ *   UnrealEditor-Cmd ZombieApocalypse.uproject -run=SDRun -Asset=/Game/Models/SIR.SIR -Days=180 -Out=Saved/SDRun.csv
+ *
+ *   -Asset=<object path>  USDModelAsset to run. Without it the zombie model is built from the
+ *                         SimulationController defaults, with the -Controller, -Curve and -Table options.
+ *   -Days=<float>         Days to run (default 180)
+ *   -Out=<file>           CSV to write (default Saved/SDRun.csv)
+ */
+UCLASS()
+class ZOMBIEAPOCALYPSE_API USDRunCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USDRunCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
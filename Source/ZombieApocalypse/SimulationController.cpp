@@ -1,18 +1,38 @@
 #include "SimulationController.h"
+#include "SimulationHistoryComponent.h"
+#include "ZombieCurveAsset.h"
+#include "PopulationRegistry.h"
+#include "Engine/LevelBounds.h"
+#include "HAL/FileManager.h"
 #include  <cmath>
 
 ASimulationController::ASimulationController()
 {
     PrimaryActorTick.bCanEverTick = true;
 
+    HistoryComponent = CreateDefaultSubobject<USimulationHistoryComponent>(TEXT("HistoryComponent"));
+
 }
 
 void ASimulationController::BeginPlay()
 {
     Super::BeginPlay();
 
-    // Checking if the DataTable is assigned
-    if (!PopulationDensityEffectTable)
+    // Agents look the controller up through the registry instead of searching the world
+    if (UPopulationRegistry* Registry = GetWorld()->GetSubsystem<UPopulationRegistry>())
+    {
+        Registry->RegisterSimulationController(this);
+    }
+
+    // The cooked curve comes first, then the DataTable
+    if (PopulationDensityEffectCurve)
+    {
+        Model.Graph = PopulationDensityEffectCurve->MakeGraph();
+#if !UE_BUILD_SHIPPING
+        CurveFileTimeStamp = IFileManager::Get().GetTimeStamp(*PopulationDensityEffectCurve->GetSourceFilePath());
+#endif
+    }
+    else if (!PopulationDensityEffectTable)
     {
           UE_LOG(LogTemp, Error, TEXT("PopulationDensityEffectTable is not assigned!"));
     }
@@ -21,115 +41,567 @@ void ASimulationController::BeginPlay()
        // Table found, read data into vector
        ReadDataFromTableToVectors();
     }
+
+    if (bUseSpatialGrid)
+    {
+        InitializeGrid();
+    }
+
+    WorkerSteps.Reserve(MaxStepsPerFrame);
+    PushStocksToModel();
+    PublishStocks();
+    LastReportedStep = Snapshots.Read();
+}
+
+void ASimulationController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    // The tasks use Model and the forecast cache, which go away with this actor
+    StepTask.Wait();
+    ForecastTask.Wait();
+
+    if (UPopulationRegistry* Registry = GetWorld()->GetSubsystem<UPopulationRegistry>())
+    {
+        Registry->UnregisterSimulationController(this);
+    }
+
+    Super::EndPlay(EndPlayReason);
 }
 
 void ASimulationController::Tick(float DeltaTime)
 {
     Super::Tick(DeltaTime);
 
-    AccumulatedTime += DeltaTime;
+    UpdateForecastTask();
+
+#if !UE_BUILD_SHIPPING
+    ReloadCurveIfChanged(DeltaTime);
+#endif
+
+    // Fixed step: leftover time is carried to the next frame so the day counter does not drift
+    const float StepTime = FMath::Max(SimulationStepTime, UE_KINDA_SMALL_NUMBER);
+    AccumulatedTime += DeltaTime * TimeScale;
+
+    int32 StepsThisFrame = 0;
+    while (AccumulatedTime >= StepTime && StepsThisFrame < MaxStepsPerFrame)
+    {
+        AccumulatedTime -= StepTime;
+        StepsThisFrame++;
+    }
+
+    // Over the per-frame cap, keep only the partial step
+    if (AccumulatedTime >= StepTime)
+    {
+        AccumulatedTime = FMath::Fmod(AccumulatedTime, StepTime);
+    }
+
+    if (!bRunModelOnWorkerThread)
+    {
+        for (int32 Step = 0; Step < StepsThisFrame; ++Step)
+        {
+            RunSimulationStep();
+        }
+        return;
+    }
+
+    if (StepTask.IsValid() && StepTask.IsCompleted())
+    {
+        FinishWorkerSteps();
+    }
 
-    if (AccumulatedTime >= SimulationStepTime)
+    // Steps owed while the worker was busy are capped the same way as a single frame
+    PendingSteps = FMath::Min(PendingSteps + StepsThisFrame, MaxStepsPerFrame);
+    if (PendingSteps > 0 && !StepTask.IsValid())
+    {
+        LaunchWorkerSteps(PendingSteps);
+        PendingSteps = 0;
+    }
+}
+
+void ASimulationController::RunToDay(int32 Day)
+{
+    while (TimeStepsFinished < Day)
     {
-        AccumulatedTime = 0.f;
         RunSimulationStep();
-        TimeStepsFinished++;
-    }  
+    }
 }
 
-void ASimulationController::RunSimulationStep()
+void ASimulationController::SetGraph(TSharedPtr<const FZombieGraph> NewGraph)
+{
+    PendingGraph = MoveTemp(NewGraph);
+}
+
+#if !UE_BUILD_SHIPPING
+void ASimulationController::ReloadCurveIfChanged(float DeltaTime)
+{
+    if (!PopulationDensityEffectCurve || !bHotReloadCurve)
+        return;
+
+    CurveReloadTime += DeltaTime;
+    if (CurveReloadTime < CurveReloadInterval)
+        return;
+    CurveReloadTime = 0.f;
+
+    // Only the time stamp is read until the file actually changes
+    const FString Path = PopulationDensityEffectCurve->GetSourceFilePath();
+    const FDateTime TimeStamp = IFileManager::Get().GetTimeStamp(*Path);
+    if (TimeStamp == FDateTime::MinValue() || TimeStamp == CurveFileTimeStamp)
+        return;
+    CurveFileTimeStamp = TimeStamp;
+
+    // A file caught half written fails to read and is picked up again once it is saved
+    if (TSharedPtr<FZombieGraph> Graph = PopulationDensityEffectCurve->ReadSourceFile())
+    {
+        UE_LOG(LogTemp, Log, TEXT("SimulationController: Reloaded %d curve points from %s"), static_cast<int32>(Graph->graphPts.size()), *Path);
+        SetGraph(MoveTemp(Graph));
+    }
+    else
+    {
+        CurveFileTimeStamp = FDateTime::MinValue();
+    }
+}
+#endif
+
+void ASimulationController::ApplyStockJournal()
+{
+    // Runs while no step is in flight, so a change with a location can go straight into its grid cell.
+    // PushStocksToModel then only scales the cells for the changes that had no location.
+    FZombieStockDelta Delta;
+    while (StockJournal.Dequeue(Delta))
+    {
+        int32 Cell = INDEX_NONE;
+        if (bUseSpatialGrid && Delta.Location.IsSet())
+        {
+            const FIntPoint GridCell = GetGridCell(Delta.Location.GetValue());
+            Cell = Grid.GetCellIndex(GridCell.X, GridCell.Y);
+        }
+
+        switch (Delta.Stock)
+        {
+        case EZombieStock::Susceptible:
+            Susceptible = FMath::Max(0.f, Susceptible + Delta.Amount);
+            if (Cell != INDEX_NONE)
+                Grid.ChangeCellStocks(Cell, Delta.Amount, 0.f);
+            break;
+        case EZombieStock::Zombies:
+            Zombies = FMath::Max(0.f, Zombies + Delta.Amount);
+            if (Cell != INDEX_NONE)
+                Grid.ChangeCellStocks(Cell, 0.f, Delta.Amount);
+            break;
+        case EZombieStock::Bitten:
+            Bitten = FMath::Max(0.f, Bitten + Delta.Amount);
+            if (Delta.Amount < 0.f && Delta.Cohort != INDEX_NONE)
+            {
+                if (Cell != INDEX_NONE)
+                    Grid.RemoveFromCohort(Delta.Cohort, -Delta.Amount, Cell);
+                else
+                    RemoveFromConveyorCohort(Delta.Cohort, -Delta.Amount);
+            }
+            break;
+        }
+    }
+}
+
+void ASimulationController::PushStocksToModel()
+{
+    // Swap the curve while no task is stepping the model. Forecasts in flight keep their own reference to the old one.
+    if (PendingGraph)
+    {
+        Model.Graph = MoveTemp(PendingGraph);
+        Grid.Graph = Model.Graph;
+    }
+
+    // Copy in anything Blueprints or gameplay changed since the last step
+    Model.Params = GetModelParams();
+    Model.State.Susceptible = Susceptible;
+    Model.State.Zombies = Zombies;
+    Model.State.Bitten = Bitten;
+    Model.State.TimeStepsFinished = TimeStepsFinished;
+
+    if (bUseSpatialGrid)
+    {
+        Grid.Params = Model.Params;
+        Grid.SusceptibleMigrationRate = SusceptibleMigrationRate;
+        Grid.BittenMigrationRate = BittenMigrationRate;
+        Grid.ZombieMigrationRate = ZombieMigrationRate;
+        Grid.bRoundToWholePeople = bGridRoundToWholePeople;
+        Grid.ScaleStocksToTotals(Susceptible, Zombies);
+        Grid.TimeStepsFinished = TimeStepsFinished;
+    }
+}
+
+void ASimulationController::LaunchWorkerSteps(int32 NumSteps)
+{
+    ApplyStockJournal();
+    PushStocksToModel();
+
+    LaunchedSusceptible = Susceptible;
+    LaunchedBitten = Bitten;
+    LaunchedZombies = Zombies;
+    LaunchedIncomingCohort = bUseSpatialGrid ? Grid.GetIncomingCohort() : Model.State.conveyor.GetIncomingCohort();
+
+    // Forecasts fork from this copy until the steps land
+    if (bUseSpatialGrid)
+    {
+        LaunchedFork = FZombieModel();
+        Grid.CollapseInto(LaunchedFork);
+    }
+    else
+    {
+        LaunchedFork = Model;
+    }
+
+    WorkerStepsRequested = NumSteps;
+    WorkerSteps.Reset();
+
+    // Only the task touches Model, Grid and WorkerSteps until it completes
+    StepTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, NumSteps]()
+    {
+        for (int32 Step = 0; Step < NumSteps; ++Step)
+        {
+            WorkerSteps.Add(StepActiveModel());
+            Snapshots.Publish(WorkerSteps.Last());
+        }
+    });
+}
+
+void ASimulationController::FinishWorkerSteps()
+{
+    StepTask.Wait();
+    StepTask = UE::Tasks::FTask();
+
+    // The worker started from the Launched stocks, gameplay may have changed them since
+    const FZombieModelSnapshot& LastStep = WorkerSteps.Last();
+    Susceptible = LastStep.Susceptible + (Susceptible - LaunchedSusceptible);
+    Zombies = LastStep.Zombies + (Zombies - LaunchedZombies);
+    Bitten = LastStep.Bitten + (Bitten - LaunchedBitten);
+    TimeStepsFinished = LastStep.TimeStepsFinished;
+    WorkerStepsRequested = 0;
+
+    for (const TPair<int32, float>& Removal : DeferredConveyorRemovals)
+    {
+        RemoveFromConveyorCohort(Removal.Key, Removal.Value);
+    }
+    DeferredConveyorRemovals.Reset();
+
+    if (bUseSpatialGrid)
+    {
+        UpdateGridView();
+    }
+
+    PublishStocks();
+
+    for (const FZombieModelSnapshot& Step : WorkerSteps)
+    {
+        ReportStep(Step);
+    }
+}
+
+void ASimulationController::PublishStocks()
+{
+    FZombieModelSnapshot Snapshot = WorkerSteps.Num() > 0 ? WorkerSteps.Last() : Snapshots.Read();
+    Snapshot.Susceptible = Susceptible;
+    Snapshot.Bitten = Bitten;
+    Snapshot.Zombies = Zombies;
+    Snapshot.TimeStepsFinished = TimeStepsFinished;
+    Snapshots.Publish(Snapshot);
+}
+
+void ASimulationController::ReportStep(const FZombieModelSnapshot& Step)
 {
-    // Calculate auxiliaries
-    Bitten = conveyor_content();
-    float non_zombie_population = Bitten + Susceptible;
-    float population_density = non_zombie_population / land_area;
-    float x = population_density / normal_population_density;
-    
-    float population_density_effect_on_zombie_bites = graph_lookup(x);
-    float number_of_bites_per_zombie_per_day = normal_number_of_bites * population_density_effect_on_zombie_bites;
-    float total_bitten_per_day = FMath::RoundToFloat(Zombies * number_of_bites_per_zombie_per_day);
-    
-    float denom = FMath::Max(non_zombie_population, 1.f);
-    float number_of_bites_from_total_zombies_on_susceptible = FMath::RoundToFloat((Susceptible / denom) * total_bitten_per_day);
-    
-    // Enforce non-negative susceptible
-    float getting_bitten = FMath::Min(number_of_bites_from_total_zombies_on_susceptible, FMath::Floor(Susceptible));
-    
-    // Conveyor mechanics
-    for (ConveyorBatch &b : conveyor)
-    {
-        b.remainingDays -= 1.f;
-    }
-    
-
-    std::vector<ConveyorBatch> next_conveyor;
-    float raw_outflow_people = 0.f;
-    next_conveyor.reserve(conveyor.size());
-    
-    for (ConveyorBatch &b : conveyor)
-    {
-        if (b.remainingDays <= 0.0)
-            raw_outflow_people += b.amountOfPeople;
-        else
-            next_conveyor.push_back(b);
-    }
-    conveyor.swap(next_conveyor);
-    
-    // Capacity check for new inflow
-    float current_content = conveyor_content();
-    float free_cap = FMath::Max(0.f, Bitten_capacity - current_content);
-    float inflow_people = FMath::Max(0.f, FMath::Min(getting_bitten, free_cap));
-    
-    if (inflow_people > 0.f)
-        conveyor.push_back(ConveyorBatch{inflow_people, days_to_become_infected_from_bite});
-    
-    // Convert outflow to zombies
-    float becoming_infected = raw_outflow_people * CONVERSION_FROM_PEOPLE_TO_ZOMBIES;
-    
-    // Update stocks
-    Susceptible = FMath::Max(0.f, Susceptible - getting_bitten);
-    Zombies = FMath::Max(0.f, Zombies + becoming_infected);
-    Bitten = conveyor_content();
+    if (HistoryComponent)
+        HistoryComponent->Record(Step);
 
+    FZombieStepDelta Delta;
+    Delta.Step = Step;
+    Delta.SusceptibleChange = Step.Susceptible - LastReportedStep.Susceptible;
+    Delta.BittenChange = Step.Bitten - LastReportedStep.Bitten;
+    Delta.ZombiesChange = Step.Zombies - LastReportedStep.Zombies;
+    const bool bLoseStarted = Step.bLose && !LastReportedStep.bLose;
+    const bool bWinStarted = Step.bWin && !LastReportedStep.bWin;
+    LastReportedStep = Step;
+
+    OnStepCompleted.Broadcast(Delta);
+    if (Delta.HasStockChanges())
+        OnStocksChanged.Broadcast(Delta);
+    if (bLoseStarted)
+        OnLose.Broadcast(Step.TimeStepsFinished);
+    if (bWinStarted)
+        OnWin.Broadcast(Step.TimeStepsFinished);
 
     //Check if win or lose.
 
-    if (Susceptible <= 45) {
+    if (Step.bLose) {
         Lose();
     }
-    if (Zombies <= 0 || TimeStepsFinished > 180 ) {
+    if (Step.bWin) {
         Win();
     }
 }
 
-float ASimulationController::conveyor_content()
+FZombieModel ASimulationController::ForkModel()
+{
+    // Model belongs to the task until Tick lands its steps. Landing them here would report the steps from
+    // inside a query, so the fork starts from the copy taken at launch with the stocks the game is showing.
+    if (StepTask.IsValid())
+    {
+        FZombieModel Fork = LaunchedFork;
+        if (PendingGraph)
+            Fork.Graph = PendingGraph;
+
+        // The conveyor was filled for the incubation the task launched with
+        const EZombieIncubation Incubation = Fork.Params.Incubation;
+        Fork.Params = GetModelParams();
+        Fork.Params.Incubation = Incubation;
+
+        Fork.State.Susceptible = Susceptible;
+        Fork.State.Zombies = Zombies;
+        Fork.State.Bitten = Bitten;
+        Fork.State.TimeStepsFinished = TimeStepsFinished;
+        return Fork;
+    }
+
+    PushStocksToModel();
+
+    // The grid is summed into a well-mixed model, so forecasts ignore where people are
+    if (bUseSpatialGrid)
+    {
+        FZombieModel Collapsed;
+        Grid.CollapseInto(Collapsed);
+        return Collapsed;
+    }
+    return Model;
+}
+
+FZombieThresholdResult ASimulationController::FindLoseThreshold(EZombieParameter Parameter, float Min, float Max, int32 Days)
 {
-    float sum = 0.0;
-    for (ConveyorBatch &b : conveyor)
-        sum += b.amountOfPeople;
-    return sum;
+    FZombieThresholdSettings Settings;
+    Settings.Parameter = Parameter;
+    Settings.Min = Min;
+    Settings.Max = Max;
+    Settings.Days = Days;
+    return ZombieThreshold::FindLoseThreshold(ForkModel(), Settings);
 }
 
-float ASimulationController::graph_lookup(float xIn)
+FZombieForecast ASimulationController::Forecast(int32 DaysAhead, const FZombieCounterfactual& Change)
 {
-    if (graphPts.empty()) return 1.0f;
-    
-    if (xIn <= graphPts.front().first)
-        return graphPts.front().second;
-    if (xIn >= graphPts.back().first)
-        return graphPts.back().second;
+    FZombieModel Fork = ForkModel();
+    if (const FZombieForecast* Cached = FindCachedForecast(Fork, DaysAhead, Change))
+        return *Cached;
+
+    FZombieForecastCacheEntry Entry;
+    Entry.Inputs = Fork;
+    Entry.Change = Change;
+    Entry.DaysAhead = DaysAhead;
+
+    Fork.Apply(Change);
+    Fork.Forecast(DaysAhead, Entry.Result);
+    return CacheForecast(MoveTemp(Entry));
+}
 
-    for (size_t i = 1; i < graphPts.size(); ++i)
+void ASimulationController::ForecastAsync(int32 DaysAhead, const FZombieCounterfactual& Change)
+{
+    if (ForecastTask.IsValid())
     {
-        if (xIn <= graphPts[i].first)
-        {
-            float x0 = graphPts[i-1].first, x1 = graphPts[i].first;
-            float y0 = graphPts[i-1].second, y1 = graphPts[i].second;
-            float t = (xIn - x0) / (x1 - x0);
-            return y0 + t*(y1 - y0);
-        }
+        QueuedForecast.Emplace(DaysAhead, Change);
+        return;
+    }
+
+    FZombieModel Fork = ForkModel();
+    if (const FZombieForecast* Cached = FindCachedForecast(Fork, DaysAhead, Change))
+    {
+        ForecastReady(*Cached);
+        return;
+    }
+
+    ForecastTaskKey.Inputs = Fork;
+    ForecastTaskKey.Change = Change;
+    ForecastTaskKey.DaysAhead = DaysAhead;
+
+    ForecastTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Fork = MoveTemp(Fork), DaysAhead, Change]() mutable
+    {
+        FZombieForecast Result;
+        Fork.Apply(Change);
+        Fork.Forecast(DaysAhead, Result);
+        return Result;
+    });
+}
+
+void ASimulationController::UpdateForecastTask()
+{
+    if (!ForecastTask.IsValid() || !ForecastTask.IsCompleted())
+        return;
+
+    ForecastTaskKey.Result = MoveTemp(ForecastTask.GetResult());
+    ForecastTask = UE::Tasks::TTask<FZombieForecast>();
+
+    const FZombieForecast& Result = CacheForecast(MoveTemp(ForecastTaskKey));
+    ForecastReady(Result);
+
+    if (QueuedForecast.IsSet())
+    {
+        const TPair<int32, FZombieCounterfactual> Request = QueuedForecast.GetValue();
+        QueuedForecast.Reset();
+        ForecastAsync(Request.Key, Request.Value);
+    }
+}
+
+const FZombieForecast* ASimulationController::FindCachedForecast(const FZombieModel& Inputs, int32 DaysAhead, const FZombieCounterfactual& Change) const
+{
+    for (const FZombieForecastCacheEntry& Entry : ForecastCache)
+    {
+        if (Entry.DaysAhead == DaysAhead && Entry.Change == Change && Entry.Inputs.HasSameInputs(Inputs))
+            return &Entry.Result;
     }
-    return graphPts.back().second;
+    return nullptr;
+}
+
+const FZombieForecast& ASimulationController::CacheForecast(FZombieForecastCacheEntry&& Entry)
+{
+    // Fixed number of entries, the oldest one is replaced
+    if (ForecastCache.Num() < ForecastCacheSize)
+    {
+        return ForecastCache.Add_GetRef(MoveTemp(Entry)).Result;
+    }
+
+    const int32 Slot = NextForecastCacheSlot % ForecastCache.Num();
+    NextForecastCacheSlot = Slot + 1;
+    ForecastCache[Slot] = MoveTemp(Entry);
+    return ForecastCache[Slot].Result;
+}
+
+int32 ASimulationController::GetIncomingConveyorCohort() const
+{
+    // While the worker runs, a bite lands in the cohort of the first step after its batch
+    if (StepTask.IsValid())
+        return LaunchedIncomingCohort + WorkerStepsRequested;
+
+    return bUseSpatialGrid ? Grid.GetIncomingCohort() : Model.State.conveyor.GetIncomingCohort();
+}
+
+void ASimulationController::RemoveFromConveyorCohort(int32 Cohort, float AmountOfPeople)
+{
+    if (StepTask.IsValid())
+    {
+        DeferredConveyorRemovals.Emplace(Cohort, AmountOfPeople);
+        return;
+    }
+
+    if (bUseSpatialGrid)
+        Grid.RemoveFromCohort(Cohort, AmountOfPeople);
+    else
+        Model.RemoveBitten(Cohort, AmountOfPeople);
+}
+
+FZombieModelSnapshot ASimulationController::StepActiveModel()
+{
+    FZombieModelAuxiliaries Auxiliaries;
+    if (bUseSpatialGrid)
+    {
+        const FZombieStepOutcome Outcome = Grid.RunSimulationStep(&Auxiliaries);
+        return Grid.MakeSnapshot(Auxiliaries, Outcome);
+    }
+
+    const FZombieStepOutcome Outcome = bStepCompiledModel ? CompiledModel.Step(Model, &Auxiliaries) : Model.RunSimulationStep(&Auxiliaries);
+    return Model.MakeSnapshot(Auxiliaries, Outcome);
+}
+
+void ASimulationController::InitializeGrid()
+{
+    const FBox LevelBounds = GridBounds.IsValid ? GridBounds : ALevelBounds::CalculateLevelBounds(GetLevel());
+    GridOrigin = FVector2D(LevelBounds.Min);
+
+    Grid.Params = GetModelParams();
+    Grid.Graph = Model.Graph;
+    Grid.Initialize(GridResolution.X, GridResolution.Y);
+
+    GridCellSize = FVector2D(LevelBounds.GetSize()) / FVector2D(Grid.GetSizeX(), Grid.GetSizeY());
+    GridCellSize = FVector2D::Max(GridCellSize, FVector2D(1.f, 1.f));
+
+    // People start evenly spread, patient zero starts in the controller's cell
+    std::fill(Grid.Susceptible.begin(), Grid.Susceptible.end(), Susceptible / Grid.GetNumCells());
+    const FIntPoint PatientZeroCell = GetGridCell(GetActorLocation());
+    Grid.Zombies[Grid.GetCellIndex(PatientZeroCell.X, PatientZeroCell.Y)] = Zombies;
+    Grid.RecomputeTotals();
+
+    UpdateGridView();
+
+    if (bShouldDebug)
+        UE_LOG(LogTemp, Log, TEXT("SimulationController: %dx%d grid over %s"), Grid.GetSizeX(), Grid.GetSizeY(), *LevelBounds.ToString());
+}
+
+void ASimulationController::UpdateGridView()
+{
+    const int32 NumCells = Grid.GetNumCells();
+    GridSusceptibleView.SetNumUninitialized(NumCells);
+    GridBittenView.SetNumUninitialized(NumCells);
+    GridZombiesView.SetNumUninitialized(NumCells);
+    FMemory::Memcpy(GridSusceptibleView.GetData(), Grid.Susceptible.data(), NumCells * sizeof(float));
+    FMemory::Memcpy(GridBittenView.GetData(), Grid.Bitten.data(), NumCells * sizeof(float));
+    FMemory::Memcpy(GridZombiesView.GetData(), Grid.Zombies.data(), NumCells * sizeof(float));
+}
+
+FIntPoint ASimulationController::GetGridCell(const FVector& Location) const
+{
+    const FVector2D Cell = (FVector2D(Location) - GridOrigin) / GridCellSize;
+    return FIntPoint(
+        FMath::Clamp(FMath::FloorToInt(Cell.X), 0, FMath::Max(1, Grid.GetSizeX()) - 1),
+        FMath::Clamp(FMath::FloorToInt(Cell.Y), 0, FMath::Max(1, Grid.GetSizeY()) - 1));
+}
+
+bool ASimulationController::GetGridStocksAt(const FVector& Location, float& OutSusceptible, float& OutBitten, float& OutZombies) const
+{
+    if (!bUseSpatialGrid || GridZombiesView.Num() == 0)
+        return false;
+
+    const FIntPoint Cell = GetGridCell(Location);
+    const int32 Index = Grid.GetCellIndex(Cell.X, Cell.Y);
+    OutSusceptible = GridSusceptibleView[Index];
+    OutBitten = GridBittenView[Index];
+    OutZombies = GridZombiesView[Index];
+    return true;
+}
+
+FZombieModelParams ASimulationController::GetModelParams() const
+{
+    FZombieModelParams Params;
+    Params.days_to_become_infected_from_bite = days_to_become_infected_from_bite;
+    Params.Bitten_capacity = Bitten_capacity;
+    Params.CONVERSION_FROM_PEOPLE_TO_ZOMBIES = CONVERSION_FROM_PEOPLE_TO_ZOMBIES;
+    Params.normal_number_of_bites = normal_number_of_bites;
+    Params.land_area = land_area;
+    Params.normal_population_density = normal_population_density;
+    Params.Incubation = Incubation;
+    Params.leakage_fraction = leakage_fraction;
+    Params.IntegrationMethod = IntegrationMethod;
+    Params.DT = DT;
+    return Params;
+}
+
+void ASimulationController::RunSimulationStep()
+{
+    // Let an in-flight batch land first so steps stay in order
+    if (StepTask.IsValid())
+    {
+        FinishWorkerSteps();
+    }
+
+    ApplyStockJournal();
+    PushStocksToModel();
+
+    const FZombieModelSnapshot Step = StepActiveModel();
+
+    Susceptible = Step.Susceptible;
+    Zombies = Step.Zombies;
+    Bitten = Step.Bitten;
+    TimeStepsFinished = Step.TimeStepsFinished;
+
+    if (bUseSpatialGrid)
+    {
+        UpdateGridView();
+    }
+
+    Snapshots.Publish(Step);
+    ReportStep(Step);
 }
 
 // Function to read data from Unreal DataTable into the graphPts vector
@@ -138,23 +610,20 @@ void ASimulationController::ReadDataFromTableToVectors()
     if (bShouldDebug)
        UE_LOG(LogTemp, Log, TEXT("Read Data From Table To Vectors"))
 
-    TArray<FName> rowNames = PopulationDensityEffectTable->GetRowNames();
+    TSharedPtr<FZombieGraph> Graph = MakeShared<FZombieGraph>();
+    Graph->ReadFromDataTable(*PopulationDensityEffectTable);
 
-    for (int i{0}; i < rowNames.Num(); i++)
+    if (bShouldDebug)
     {
-       if (bShouldDebug)
-          UE_LOG(LogTemp, Log, TEXT("Reading table row index: %d"), i)
+        for (size_t i = 0; i < Graph->graphPts.size(); ++i)
+        {
+            const std::pair<float, float>& pair = Graph->graphPts[i];
+            UE_LOG(LogTemp, Warning, TEXT("Reading table row: %d, pair: (%f, %f)"), (int)i, pair.first, pair.second);
+        }
+    }
 
-       FPopulationDensityEffect* rowData = PopulationDensityEffectTable->FindRow<FPopulationDensityEffect>(rowNames[i], TEXT(""));
-       if (rowData)
-       {
-           graphPts.emplace_back(rowData->PopulationDensity, rowData->NormalPopulationDensity);
+    if (bBakeLookupTable)
+        Graph->Bake(LookupTableResolution);
 
-           if (bShouldDebug)
-           {
-               std::pair<float, float> lastPair = graphPts.back();
-               UE_LOG(LogTemp, Warning, TEXT("Reading table row: %d, pair: (%f, %f)"), i, lastPair.first, lastPair.second);
-           }
-       }
-    }
-}
\ No newline at end of file
+    Model.Graph = Graph;
+}
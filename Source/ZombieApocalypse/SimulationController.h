@@ -3,27 +3,67 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "Engine/DataTable.h"
-#include <vector>
+#include "Tasks/Task.h"
+#include "Containers/Queue.h"
+#include "ZombieModel.h"
+#include "ZombieSDModel.h"
+#include "ZombieGridModel.h"
+#include "ZombieThreshold.h"
 #include "SimulationController.generated.h"
 
 
-// Struct for the Unreal DataTable
+// Stocks after a step and how much they moved since the step before, including gameplay changes in between
 USTRUCT(BlueprintType)
-struct FPopulationDensityEffect : public FTableRowBase
+struct FZombieStepDelta
 {
 	GENERATED_BODY()
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	float PopulationDensity;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	float NormalPopulationDensity;
+	UPROPERTY(BlueprintReadOnly, Category = "Simulation")
+	FZombieModelSnapshot Step;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Simulation")
+	float SusceptibleChange{ 0.f };
+	UPROPERTY(BlueprintReadOnly, Category = "Simulation")
+	float BittenChange{ 0.f };
+	UPROPERTY(BlueprintReadOnly, Category = "Simulation")
+	float ZombiesChange{ 0.f };
+
+	bool HasStockChanges() const { return SusceptibleChange != 0.f || BittenChange != 0.f || ZombiesChange != 0.f; }
+};
+
+UENUM(BlueprintType)
+enum class EZombieStock : uint8
+{
+	Susceptible,
+	Bitten,
+	Zombies
 };
 
-// Conveyor system for bitten people
-struct ConveyorBatch
+// Change to one stock made by gameplay, e.g. -1 Zombies when the player kills one
+struct FZombieStockDelta
 {
-	float amountOfPeople;
-	float remainingDays;
+	EZombieStock Stock{ EZombieStock::Susceptible };
+	float Amount{ 0.f };
+
+	// For a negative Bitten change, the conveyor cohort the people are taken from. Bitten is recomputed
+	// from the conveyor every step, so a Bitten change without a cohort only lasts until the next step.
+	int32 Cohort{ INDEX_NONE };
+
+	// Where it happened, e.g. where the person died. In grid mode the change goes to the cell there;
+	// without a location it is spread over every cell in proportion to what they hold.
+	TOptional<FVector> Location;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FZombieStepSignature, const FZombieStepDelta&, Delta);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FZombieOutcomeSignature, int32, Day);
+
+// A forecast together with the inputs it was computed from
+struct FZombieForecastCacheEntry
+{
+	FZombieModel Inputs;
+	FZombieCounterfactual Change;
+	int32 DaysAhead{ 0 };
+	FZombieForecast Result;
 };
 
 UCLASS()
@@ -34,7 +74,7 @@ class ZOMBIEAPOCALYPSE_API ASimulationController : public AActor
 public:	
 	ASimulationController();
 
-	// Runs one simulation step each Tick 
+	// Runs one simulation step for every SimulationStepTime of scaled game time
 	virtual void Tick(float DeltaTime) override;
 
 	// Function to read data from Unreal DataTable into the graphPts vector
@@ -47,15 +87,93 @@ public:
 	UFUNCTION(BlueprintImplementableEvent, Category = "EndGameEvents")
 	void Win();
 
+	// Broadcast on the game thread after every step, in step order, steps run on the worker included.
+	// Subscribe instead of polling GetSnapshot every frame.
+	UPROPERTY(BlueprintAssignable, Category = "Simulation|Events")
+	FZombieStepSignature OnStepCompleted;
+
+	// Same as OnStepCompleted, only for steps that changed a stock
+	UPROPERTY(BlueprintAssignable, Category = "Simulation|Events")
+	FZombieStepSignature OnStocksChanged;
+
+	// Broadcast once when the condition becomes true, unlike Lose() and Win() which fire on every step it holds
+	UPROPERTY(BlueprintAssignable, Category = "EndGameEvents")
+	FZombieOutcomeSignature OnLose;
+	UPROPERTY(BlueprintAssignable, Category = "EndGameEvents")
+	FZombieOutcomeSignature OnWin;
+
+
+	// Records every simulated day and streams it to disk
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components)
+	class USimulationHistoryComponent* HistoryComponent{ nullptr };
 
 	// Unreal Lookup table for population density effect
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables")
 	class UDataTable* PopulationDensityEffectTable{ nullptr };
 
+	// Cooked lookup curve, used instead of the table when set. Loads without reading rows or baking.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables")
+	class UZombieCurveAsset* PopulationDensityEffectCurve{ nullptr };
+
+	// Development builds only: reload the curve whenever the source file of PopulationDensityEffectCurve changes
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables", meta = (EditCondition = "PopulationDensityEffectCurve != nullptr"))
+	bool bHotReloadCurve{ true };
+
+	// Seconds between checks of the source file
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables", meta = (ClampMin = "0.1", EditCondition = "bHotReloadCurve"))
+	float CurveReloadInterval{ 1.f };
+
+	// Swaps in a new lookup curve. Takes effect before the next step, steps already running finish on the old one.
+	void SetGraph(TSharedPtr<const FZombieGraph> NewGraph);
+
+	// Bake the lookup table into a uniform table when it is read, instead of scanning it on every lookup
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables")
+	bool bBakeLookupTable{ true };
+
+	// Intervals used when the table points are not evenly spaced and have to be resampled
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables", meta = (ClampMin = "1", EditCondition = "bBakeLookupTable"))
+	int32 LookupTableResolution{ 256 };
+
 	// How long each time step is in Unreal, in seconds
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables")
 	float SimulationStepTime{ 1.f };
 
+	// Scales game time before it is fed to the step accumulator, e.g. 10 runs ten days per SimulationStepTime
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables", meta = (ClampMin = "0"))
+	float TimeScale{ 1.f };
+
+	// Most steps Tick may run in one frame. Time owed beyond that is dropped so a long hitch cannot stall the game.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables", meta = (ClampMin = "1"))
+	int32 MaxStepsPerFrame{ 8 };
+
+	// Advance the model on a worker task; Tick collects the finished steps on a later frame
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables")
+	bool bRunModelOnWorkerThread{ true };
+
+	// Splits the level into a grid of cells, each with its own stocks, instead of one well-mixed population.
+	// The stocks below are then the level totals.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Simulation Variables|Spatial")
+	bool bUseSpatialGrid{ false };
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Simulation Variables|Spatial", meta = (EditCondition = "bUseSpatialGrid", ClampMin = "1", UIMax = "256"))
+	FIntPoint GridResolution{ 64, 64 };
+
+	// Area (XY) covered by the grid, the level bounds when left empty
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Simulation Variables|Spatial", meta = (EditCondition = "bUseSpatialGrid"))
+	FBox GridBounds{ ForceInit };
+
+	// Fraction of a cell's stock that moves to the neighbouring cells per day
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables|Spatial", meta = (EditCondition = "bUseSpatialGrid", ClampMin = "0", ClampMax = "1"))
+	float SusceptibleMigrationRate{ 0.05f };
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables|Spatial", meta = (EditCondition = "bUseSpatialGrid", ClampMin = "0", ClampMax = "1"))
+	float BittenMigrationRate{ 0.05f };
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables|Spatial", meta = (EditCondition = "bUseSpatialGrid", ClampMin = "0", ClampMax = "1"))
+	float ZombieMigrationRate{ 0.1f };
+
+	// Round bites to whole people per cell like the Stella model. Off by default since cells hold fractions of people.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables|Spatial", meta = (EditCondition = "bUseSpatialGrid"))
+	bool bGridRoundToWholePeople{ false };
+
 	// Turn on/off debug printing to the Output Log
 	UPROPERTY(EditAnywhere, Category = "Simulation Variables")
 	bool bShouldDebug{ false };
@@ -94,15 +212,40 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables")
 	float normal_population_density{0.1f};
+
+	// Incubation of the well-mixed model, the spatial grid always uses the conveyor
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables")
+	EZombieIncubation Incubation{ EZombieIncubation::Conveyor };
+
+	// Share of the bitten people who leave a leaky conveyor each day without turning, see FZombieModelParams
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables", meta = (ClampMin = "0", ClampMax = "1"))
+	float leakage_fraction{ 0.f };
+
+	// Integrator of the well-mixed model, the spatial grid always steps Euler over one day
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables|Integration")
+	EZombieIntegrationMethod IntegrationMethod{ EZombieIntegrationMethod::Euler };
+
+	// Step size in days, see FZombieModelParams::DT. Below 1 each step is still one day, made of smaller substeps.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables|Integration", meta = (ClampMin = "0.01"))
+	float DT{ 1.f };
+
+	// Step the well-mixed model on its compiled stock-and-flow description instead of RunSimulationStep.
+	// Same values, but off until ZombieReferenceCheck shows it is no slower on the target machine.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables|Integration")
+	bool bStepCompiledModel{ false };
 	
-	// GRAPH points: population_density_effect_on_zombie_bites
-	// Values read in from Unreal DataTable for more flexibility
-	std::vector<std::pair<float, float>> graphPts;
-		//= {
-		//{0.000f, 0.014f}, {0.200f, 0.041f}, {0.400f, 0.101f}, {0.600f, 0.189f}, {0.800f, 0.433f},
-		//{1.000f, 1.000f}, {1.200f, 1.217f}, {1.400f, 1.282f}, {1.600f, 1.300f}, {1.800f, 1.300f},
-		//{2.000f, 1.300f}
-		//};
+	// Actor-free model stepped by RunSimulationStep. The stocks and constants above are
+	// copied in before each step so Blueprint and gameplay edits still take effect.
+	FZombieModel Model;
+
+	// Steps Model on its compiled stock-and-flow description when bStepCompiledModel is set
+	FZombieSDStepper CompiledModel;
+
+	// Spatial model used instead of Model when bUseSpatialGrid is set
+	FZombieGridModel Grid;
+
+	// Builds the model constants from the Simulation Variables above
+	FZombieModelParams GetModelParams() const;
 
 	// Time accumulator for simulation steps, used in Tick function
 	float AccumulatedTime{ 0.f };
@@ -110,15 +253,146 @@ public:
 	// Number of time steps completed - to keep track and compare to Stella
 	int TimeStepsFinished{ 0 };
 
-	std::vector<ConveyorBatch> conveyor;
-
+	// Runs one day of the model and increments TimeStepsFinished
 	void RunSimulationStep();
 
+	// Runs steps immediately, ignoring SimulationStepTime, until TimeStepsFinished reaches Day
+	UFUNCTION(BlueprintCallable, Category = "Simulation")
+	void RunToDay(int32 Day);
+
+	// Latest published stocks. Lock-free, so it can be read from any thread while the worker steps.
+	UFUNCTION(BlueprintCallable, Category = "Simulation")
+	FZombieModelSnapshot GetSnapshot() const { return Snapshots.Read(); }
+
+	// Changes every time a new snapshot is published
+	UFUNCTION(BlueprintCallable, Category = "Simulation")
+	int64 GetSnapshotGeneration() const { return static_cast<int64>(Snapshots.GetGeneration()); }
+
+	// Copy of the model as it stands now (stocks, conveyor and constants) that can be stepped without affecting the game.
+	// While steps are in flight the conveyor is the one they started from, nothing waits for them.
+	FZombieModel ForkModel();
+
+	// Simulates DaysAhead days from the current state with Change applied first.
+	// Returns the cached result when neither the state, the constants nor the request changed.
+	UFUNCTION(BlueprintCallable, Category = "Simulation|Forecast", meta = (AutoCreateRefTerm = "Change"))
+	FZombieForecast Forecast(int32 DaysAhead, const FZombieCounterfactual& Change);
+
+	// Same as Forecast but simulated on a background task, the result arrives through ForecastReady.
+	// A request made while another one is running replaces any request still waiting.
+	UFUNCTION(BlueprintCallable, Category = "Simulation|Forecast", meta = (AutoCreateRefTerm = "Change"))
+	void ForecastAsync(int32 DaysAhead, const FZombieCounterfactual& Change);
+
+	UFUNCTION(BlueprintImplementableEvent, Category = "Simulation|Forecast")
+	void ForecastReady(const FZombieForecast& Result);
+
+	// How many forecasts are kept, e.g. the advisor's baseline plus a few counterfactuals
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation|Forecast", meta = (ClampMin = "1"))
+	int32 ForecastCacheSize{ 4 };
+
+	// Value of Parameter between Min and Max at which the game, continued from now, starts losing within Days days.
+	// Runs the headless model a handful of times on this thread, meant for tuning widgets and editor utilities.
+	UFUNCTION(BlueprintCallable, Category = "Simulation|Forecast")
+	FZombieThresholdResult FindLoseThreshold(EZombieParameter Parameter, float Min, float Max, int32 Days = 180);
+
+	// Grid cell that contains a world location, clamped to the grid
+	UFUNCTION(BlueprintCallable, Category = "Simulation|Spatial")
+	FIntPoint GetGridCell(const FVector& Location) const;
+
+	// Stocks of the cell at a world location as of the last finished step. False when not in grid mode.
+	UFUNCTION(BlueprintCallable, Category = "Simulation|Spatial")
+	bool GetGridStocksAt(const FVector& Location, float& OutSusceptible, float& OutBitten, float& OutZombies) const;
+
+	// Conveyor cohort that a bite made now ends up in
+	int32 GetIncomingConveyorCohort() const;
+
+	// Takes people out of a conveyor cohort, deferred until the worker is done if a step is in flight
+	void RemoveFromConveyorCohort(int32 Cohort, float AmountOfPeople);
+
+	// Queues a change to the stocks from any thread. Changes are applied in the order they were queued,
+	// all at once at the start of the next step, so gameplay never races the model.
+	void EnqueueStockDelta(const FZombieStockDelta& Delta) { StockJournal.Enqueue(Delta); }
+
+	// EnqueueStockDelta for Blueprints
+	UFUNCTION(BlueprintCallable, Category = "Simulation")
+	void ChangeStock(EZombieStock Stock, float Amount) { EnqueueStockDelta({ Stock, Amount, INDEX_NONE }); }
+
+	// ChangeStock at a world location, e.g. a spawn, which the spatial grid puts in the cell there
+	UFUNCTION(BlueprintCallable, Category = "Simulation")
+	void ChangeStockAt(EZombieStock Stock, float Amount, const FVector& Location) { EnqueueStockDelta({ Stock, Amount, INDEX_NONE, Location }); }
+
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 private:
-	float conveyor_content();
-	float graph_lookup(float xIn);
+	FZombieSnapshotBuffer Snapshots;
+
+	// Steps the worker is running. Model is owned by the task until it completes.
+	UE::Tasks::FTask StepTask;
+	TArray<FZombieModelSnapshot> WorkerSteps;
+	int32 WorkerStepsRequested{ 0 };
+
+	// Steps owed while a task was still in flight
+	int32 PendingSteps{ 0 };
+
+	// Stocks handed to the worker, so gameplay changes made meanwhile can be added back on
+	float LaunchedSusceptible{ 0.f };
+	float LaunchedBitten{ 0.f };
+	float LaunchedZombies{ 0.f };
+	int32 LaunchedIncomingCohort{ 0 };
+
+	// Model as the task got it, collapsed in grid mode, for ForkModel while the task owns Model
+	FZombieModel LaunchedFork;
+
+	TArray<TPair<int32, float>> DeferredConveyorRemovals;
+
+	// Stock changes waiting for the next step, filled from any thread and drained on the game thread
+	TQueue<FZombieStockDelta, EQueueMode::Mpsc> StockJournal;
+
+	// Last step handed to ReportStep, for the deltas and the edges of Lose/Win
+	FZombieModelSnapshot LastReportedStep;
+
+	// Curve waiting for SetGraph to swap it in
+	TSharedPtr<const FZombieGraph> PendingGraph;
+
+#if !UE_BUILD_SHIPPING
+	// Source file of the curve as of the last check
+	FDateTime CurveFileTimeStamp;
+	float CurveReloadTime{ 0.f };
+
+	void ReloadCurveIfChanged(float DeltaTime);
+#endif
+
+	// World XY of the grid's corner and the size of one cell
+	FVector2D GridOrigin{ 0.f, 0.f };
+	FVector2D GridCellSize{ 1.f, 1.f };
+
+	// Game-thread copies of the grid stocks, refreshed when steps land
+	TArray<float> GridSusceptibleView;
+	TArray<float> GridBittenView;
+	TArray<float> GridZombiesView;
+
+	TArray<FZombieForecastCacheEntry> ForecastCache;
+	int32 NextForecastCacheSlot{ 0 };
+
+	// Async forecast in flight, with the inputs it will be cached under
+	UE::Tasks::TTask<FZombieForecast> ForecastTask;
+	FZombieForecastCacheEntry ForecastTaskKey;
+
+	// Latest request made while ForecastTask was busy
+	TOptional<TPair<int32, FZombieCounterfactual>> QueuedForecast;
+
+	const FZombieForecast* FindCachedForecast(const FZombieModel& Inputs, int32 DaysAhead, const FZombieCounterfactual& Change) const;
+	const FZombieForecast& CacheForecast(FZombieForecastCacheEntry&& Entry);
+	void UpdateForecastTask();
 
+	void ApplyStockJournal();
+	void PushStocksToModel();
+	FZombieModelSnapshot StepActiveModel();
+	void InitializeGrid();
+	void UpdateGridView();
+	void LaunchWorkerSteps(int32 NumSteps);
+	void FinishWorkerSteps();
+	void PublishStocks();
+	void ReportStep(const FZombieModelSnapshot& Step);
 };
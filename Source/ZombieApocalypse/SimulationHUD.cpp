@@ -30,11 +30,14 @@ void ASimulationHUD::DrawHUD()
 
     //DrawText(message, textColor, screenPosition.X, screenPosition.Y, nullptr, textScale, true);
 
+    // Published snapshot, so the HUD never sees a half-finished step
+    const FZombieModelSnapshot Snapshot = SimulationController->GetSnapshot();
+
     // Multiple lines for better organization
-    FString stepMessage = FString::Printf(TEXT("Day: %d"), SimulationController->TimeStepsFinished);
-    FString humansMessage = FString::Printf(TEXT("Humans: %d"), (int)SimulationController->Susceptible);
-    FString bittenMessage = FString::Printf(TEXT("Bitten: %d"), (int)SimulationController->Bitten);
-    FString zombiesMessage = FString::Printf(TEXT("Zombies: %d"), (int)SimulationController->Zombies);
+    FString stepMessage = FString::Printf(TEXT("Day: %d"), Snapshot.TimeStepsFinished);
+    FString humansMessage = FString::Printf(TEXT("Humans: %d"), (int)Snapshot.Susceptible);
+    FString bittenMessage = FString::Printf(TEXT("Bitten: %d"), (int)Snapshot.Bitten);
+    FString zombiesMessage = FString::Printf(TEXT("Zombies: %d"), (int)Snapshot.Zombies);
 
     DrawText(stepMessage, textColor, screenPosition.X, screenPosition.Y, nullptr, textScale, true);
     DrawText(humansMessage, textColor, screenPosition.X, screenPosition.Y + 15.0f, nullptr, textScale, true);
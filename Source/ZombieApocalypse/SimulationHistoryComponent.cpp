@@ -0,0 +1,150 @@
+#include "SimulationHistoryComponent.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+namespace ZombieHistory
+{
+    static const TCHAR* ColumnNames[] =
+    {
+        TEXT("Day"),
+        TEXT("Susceptible"),
+        TEXT("Bitten"),
+        TEXT("Zombies"),
+        TEXT("population_density"),
+        TEXT("number_of_bites_per_zombie_per_day"),
+        TEXT("getting_bitten"),
+        TEXT("becoming_infected"),
+    };
+
+    // "ZHST" in the first four bytes of a binary history file
+    static constexpr uint32 BinaryMagic = 0x5453485A;
+    static constexpr uint32 BinaryVersion = 1;
+}
+
+USimulationHistoryComponent::USimulationHistoryComponent()
+{
+    PrimaryComponentTick.bCanEverTick = false;
+}
+
+void USimulationHistoryComponent::BeginPlay()
+{
+    Super::BeginPlay();
+
+    for (TArray<float>& Column : Columns)
+    {
+        Column.Reserve(ReservedDays);
+    }
+}
+
+void USimulationHistoryComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    Flush();
+
+    // Make sure the file is complete before the world goes away
+    PendingFlush.Wait();
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void USimulationHistoryComponent::Record(const FZombieModelSnapshot& Snapshot)
+{
+    if (!bRecordHistory)
+        return;
+
+    Columns[static_cast<int32>(EZombieHistoryColumn::Day)].Add(static_cast<float>(Snapshot.TimeStepsFinished));
+    Columns[static_cast<int32>(EZombieHistoryColumn::Susceptible)].Add(Snapshot.Susceptible);
+    Columns[static_cast<int32>(EZombieHistoryColumn::Bitten)].Add(Snapshot.Bitten);
+    Columns[static_cast<int32>(EZombieHistoryColumn::Zombies)].Add(Snapshot.Zombies);
+    Columns[static_cast<int32>(EZombieHistoryColumn::population_density)].Add(Snapshot.population_density);
+    Columns[static_cast<int32>(EZombieHistoryColumn::number_of_bites_per_zombie_per_day)].Add(Snapshot.number_of_bites_per_zombie_per_day);
+    Columns[static_cast<int32>(EZombieHistoryColumn::getting_bitten)].Add(Snapshot.getting_bitten);
+    Columns[static_cast<int32>(EZombieHistoryColumn::becoming_infected)].Add(Snapshot.becoming_infected);
+
+    if (FlushIntervalDays > 0 && GetNumDays() - FlushedDays >= FlushIntervalDays)
+    {
+        Flush();
+    }
+}
+
+void USimulationHistoryComponent::Flush()
+{
+    const int32 FirstDay = FlushedDays;
+    const int32 NumNewDays = GetNumDays() - FirstDay;
+    if (NumNewDays <= 0)
+        return;
+
+    // Copy the new rows (row-major) so the task never touches the live columns
+    TArray<float> Rows;
+    Rows.SetNumUninitialized(NumNewDays * NumColumns);
+    for (int32 Day = 0; Day < NumNewDays; ++Day)
+    {
+        for (int32 Column = 0; Column < NumColumns; ++Column)
+        {
+            Rows[Day * NumColumns + Column] = Columns[Column][FirstDay + Day];
+        }
+    }
+    FlushedDays = GetNumDays();
+
+    auto WriteRows = [Path = GetOutputPath(), Format = Format, Rows = MoveTemp(Rows), FirstDay, NumNewDays]()
+    {
+        const bool bNewFile = FirstDay == 0;
+        TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Path, bNewFile ? 0 : FILEWRITE_Append));
+        if (!Writer)
+        {
+            UE_LOG(LogTemp, Error, TEXT("SimulationHistory: Could not open %s"), *Path);
+            return;
+        }
+
+        if (Format == EZombieHistoryFormat::Binary)
+        {
+            if (bNewFile)
+            {
+                uint32 Header[] = { ZombieHistory::BinaryMagic, ZombieHistory::BinaryVersion, static_cast<uint32>(NumColumns) };
+                Writer->Serialize(Header, sizeof(Header));
+            }
+            Writer->Serialize(const_cast<float*>(Rows.GetData()), Rows.Num() * sizeof(float));
+            return;
+        }
+
+        FString Csv;
+        if (bNewFile)
+        {
+            Csv += TEXT("---");
+            for (const TCHAR* Name : ZombieHistory::ColumnNames)
+                Csv += FString::Printf(TEXT(",%s"), Name);
+            Csv += TEXT("\n");
+        }
+
+        for (int32 Day = 0; Day < NumNewDays; ++Day)
+        {
+            const float* Row = &Rows[Day * NumColumns];
+            Csv += FString::Printf(TEXT("%d, %d"), FirstDay + Day + 1, static_cast<int32>(Row[0]));
+            for (int32 Column = 1; Column < NumColumns; ++Column)
+                Csv += FString::Printf(TEXT(", %.3f"), Row[Column]);
+            Csv += TEXT("\n");
+        }
+
+        FTCHARToUTF8 Utf8(*Csv);
+        Writer->Serialize(const_cast<ANSICHAR*>(Utf8.Get()), Utf8.Length());
+    };
+
+    // Chain onto the previous flush so appends land in order
+    if (PendingFlush.IsValid())
+        PendingFlush = UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(WriteRows), UE::Tasks::Prerequisites(PendingFlush));
+    else
+        PendingFlush = UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(WriteRows));
+}
+
+void USimulationHistoryComponent::Clear()
+{
+    for (TArray<float>& Column : Columns)
+    {
+        Column.Reset();
+    }
+    FlushedDays = 0;
+}
+
+FString USimulationHistoryComponent::GetOutputPath() const
+{
+    return FPaths::IsRelative(OutputFile) ? FPaths::ProjectSavedDir() / OutputFile : OutputFile;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Tasks/Task.h"
+#include "ZombieModel.h"
+#include "SimulationHistoryComponent.generated.h"
+
+
+UENUM(BlueprintType)
+enum class EZombieHistoryFormat : uint8
+{
+	// Same layout as PopulationDensityEffect.csv, can be imported as a DataTable
+	Csv UMETA(DisplayName = "CSV"),
+	// Header (magic, version, column count) followed by one float32 per column per day
+	Binary UMETA(DisplayName = "Binary")
+};
+
+UENUM(BlueprintType)
+enum class EZombieHistoryColumn : uint8
+{
+	Day,
+	Susceptible,
+	Bitten,
+	Zombies,
+	population_density,
+	number_of_bites_per_zombie_per_day,
+	getting_bitten,
+	becoming_infected,
+	Num UMETA(Hidden)
+};
+
+// Records the stocks and key auxiliaries of every simulated day into preallocated columns
+// and streams new rows to disk on a background task.
+UCLASS(ClassGroup = (Simulation), meta = (BlueprintSpawnableComponent))
+class ZOMBIEAPOCALYPSE_API USimulationHistoryComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	USimulationHistoryComponent();
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "History")
+	bool bRecordHistory{ true };
+
+	// Days reserved up front so recording does not allocate during a normal match
+	UPROPERTY(EditAnywhere, Category = "History", meta = (ClampMin = "1"))
+	int32 ReservedDays{ 365 };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "History|Export")
+	EZombieHistoryFormat Format{ EZombieHistoryFormat::Csv };
+
+	// Relative paths are inside the project's Saved folder
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "History|Export")
+	FString OutputFile{ TEXT("ZombieHistory.csv") };
+
+	// Flush new rows every this many days, 0 only flushes on Flush() and EndPlay
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "History|Export", meta = (ClampMin = "0"))
+	int32 FlushIntervalDays{ 30 };
+
+	// Appends one day. Called by ASimulationController after every step.
+	void Record(const FZombieModelSnapshot& Snapshot);
+
+	// Writes the rows recorded since the last flush on a background task
+	UFUNCTION(BlueprintCallable, Category = "History")
+	void Flush();
+
+	// Forgets recorded days; the next flush starts a new file
+	UFUNCTION(BlueprintCallable, Category = "History")
+	void Clear();
+
+	UFUNCTION(BlueprintCallable, Category = "History")
+	int32 GetNumDays() const { return Columns[0].Num(); }
+
+	UFUNCTION(BlueprintCallable, Category = "History")
+	const TArray<float>& GetColumn(EZombieHistoryColumn Column) const { return Columns[static_cast<int32>(Column)]; }
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	static constexpr int32 NumColumns = static_cast<int32>(EZombieHistoryColumn::Num);
+
+	TArray<float> Columns[NumColumns];
+
+	// Rows before this index are already on disk (or queued to be)
+	int32 FlushedDays{ 0 };
+
+	// Flushes run one after another so appends stay in order
+	UE::Tasks::FTask PendingFlush;
+
+	FString GetOutputPath() const;
+};
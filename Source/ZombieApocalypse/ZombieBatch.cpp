@@ -0,0 +1,197 @@
+#include "ZombieBatch.h"
+
+void FZombieModelBatch::Initialize(const FZombieModel* Models, int32 NumModels)
+{
+    NumLanes = FMath::Max(NumModels, 0);
+    PaddedLanes = (NumLanes + LanesPerVector - 1) / LanesPerVector * LanesPerVector;
+    Graph = NumLanes > 0 ? Models[0].Graph : nullptr;
+
+    // Padding lanes get harmless constants so they never divide by zero
+    Bitten_capacity.assign(PaddedLanes, 0.f);
+    CONVERSION_FROM_PEOPLE_TO_ZOMBIES.assign(PaddedLanes, 0.f);
+    normal_number_of_bites.assign(PaddedLanes, 0.f);
+    land_area.assign(PaddedLanes, 1.f);
+    normal_population_density.assign(PaddedLanes, 1.f);
+    LoseSusceptibleThreshold.assign(PaddedLanes, 0.f);
+    WinDay.assign(PaddedLanes, 0);
+
+    Susceptible.assign(PaddedLanes, 0.f);
+    Zombies.assign(PaddedLanes, 0.f);
+    TimeStepsFinished.assign(PaddedLanes, 0);
+    ConveyorTotal.assign(PaddedLanes, 0.f);
+    TransitSteps.assign(PaddedLanes, 1);
+
+    bLose.assign(PaddedLanes, 0);
+    bWin.assign(PaddedLanes, 0);
+    DensityRatio.assign(PaddedLanes, 0.f);
+    DensityEffect.assign(PaddedLanes, 0.f);
+    Inflow.assign(PaddedLanes, 0.f);
+
+    // The constants never change within a batch, so the transit time is set once here instead of every step
+    MaxTransitSteps = 1;
+    for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+    {
+        TransitSteps[Lane] = FZombieConveyor::TransitStepsFor(Models[Lane].Params.days_to_become_infected_from_bite, 1.f);
+        MaxTransitSteps = FMath::Max(MaxTransitSteps, TransitSteps[Lane]);
+    }
+
+    ConveyorCursor = 0;
+    ConveyorSlots.assign(static_cast<size_t>(MaxTransitSteps) * PaddedLanes, 0.f);
+
+    for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+    {
+        const FZombieModelParams& Params = Models[Lane].Params;
+        const FZombieModelState& State = Models[Lane].State;
+
+        Bitten_capacity[Lane] = Params.Bitten_capacity;
+        CONVERSION_FROM_PEOPLE_TO_ZOMBIES[Lane] = Params.CONVERSION_FROM_PEOPLE_TO_ZOMBIES;
+        normal_number_of_bites[Lane] = Params.normal_number_of_bites;
+        land_area[Lane] = Params.land_area;
+        normal_population_density[Lane] = Params.normal_population_density;
+        LoseSusceptibleThreshold[Lane] = Params.LoseSusceptibleThreshold;
+        WinDay[Lane] = Params.WinDay;
+
+        Susceptible[Lane] = State.Susceptible;
+        Zombies[Lane] = State.Zombies;
+        TimeStepsFinished[Lane] = State.TimeStepsFinished;
+        ConveyorTotal[Lane] = State.conveyor.Content();
+
+        // Same regrouping as TZombieConveyor::SetTransitTime, relative to the cohort leaving next
+        const int32 Outgoing = State.conveyor.GetOutgoingCohort();
+        for (int32 Cohort = Outgoing; Cohort < State.conveyor.GetIncomingCohort(); ++Cohort)
+        {
+            const int32 ArrivalOffset = FMath::Min(Cohort - Outgoing, TransitSteps[Lane] - 1);
+            ConveyorSlots[static_cast<size_t>(ArrivalOffset) * PaddedLanes + Lane] += State.conveyor.GetCohort(Cohort);
+        }
+    }
+}
+
+void FZombieModelBatch::StepBatch()
+{
+    const VectorRegister4Float Zero = VectorZeroFloat();
+    const VectorRegister4Float One = VectorSetFloat1(1.f);
+    const VectorRegister4Float Half = VectorSetFloat1(0.5f);
+
+    // FMath::RoundToFloat is floor(x + 0.5), spelled out so the lanes round exactly like the scalar model
+    auto RoundToFloat = [&Half](const VectorRegister4Float& V) { return VectorFloor(VectorAdd(V, Half)); };
+
+    // Calculate auxiliaries up to the curve, which needs a per-lane table fetch
+    for (int32 i = 0; i < PaddedLanes; i += LanesPerVector)
+    {
+        const VectorRegister4Float non_zombie_population = VectorAdd(VectorLoad(&ConveyorTotal[i]), VectorLoad(&Susceptible[i]));
+        const VectorRegister4Float population_density = VectorDivide(non_zombie_population, VectorLoad(&land_area[i]));
+        VectorStore(VectorDivide(population_density, VectorLoad(&normal_population_density[i])), &DensityRatio[i]);
+    }
+
+    if (Graph)
+    {
+        Graph->graph_lookup_batch(DensityRatio.data(), DensityEffect.data(), PaddedLanes);
+    }
+    else
+    {
+        std::fill(DensityEffect.begin(), DensityEffect.end(), 1.f);
+    }
+
+    // Every lane's outgoing cohort is in the same plane
+    float* Outgoing = &ConveyorSlots[static_cast<size_t>(ConveyorCursor % MaxTransitSteps) * PaddedLanes];
+
+    for (int32 i = 0; i < PaddedLanes; i += LanesPerVector)
+    {
+        const VectorRegister4Float S = VectorLoad(&Susceptible[i]);
+        const VectorRegister4Float Z = VectorLoad(&Zombies[i]);
+        const VectorRegister4Float Content = VectorLoad(&ConveyorTotal[i]);
+
+        const VectorRegister4Float non_zombie_population = VectorAdd(Content, S);
+        const VectorRegister4Float number_of_bites_per_zombie_per_day = VectorMultiply(VectorLoad(&normal_number_of_bites[i]), VectorLoad(&DensityEffect[i]));
+        const VectorRegister4Float total_bitten_per_day = RoundToFloat(VectorMultiply(Z, number_of_bites_per_zombie_per_day));
+
+        const VectorRegister4Float denom = VectorMax(non_zombie_population, One);
+        const VectorRegister4Float number_of_bites_from_total_zombies_on_susceptible = RoundToFloat(VectorMultiply(VectorDivide(S, denom), total_bitten_per_day));
+
+        // Enforce non-negative susceptible
+        const VectorRegister4Float getting_bitten = VectorMin(number_of_bites_from_total_zombies_on_susceptible, VectorFloor(S));
+
+        // Conveyor mechanics
+        const VectorRegister4Float raw_outflow_people = VectorLoad(Outgoing + i);
+        VectorStore(Zero, Outgoing + i);
+        const VectorRegister4Float current_content = VectorSubtract(Content, raw_outflow_people);
+
+        // Capacity check for new inflow
+        const VectorRegister4Float free_cap = VectorMax(Zero, VectorSubtract(VectorLoad(&Bitten_capacity[i]), current_content));
+        const VectorRegister4Float inflow_people = VectorMax(Zero, VectorMin(getting_bitten, free_cap));
+        VectorStore(inflow_people, &Inflow[i]);
+        VectorStore(VectorAdd(current_content, inflow_people), &ConveyorTotal[i]);
+
+        // Convert outflow to zombies
+        const VectorRegister4Float becoming_infected = VectorMultiply(raw_outflow_people, VectorLoad(&CONVERSION_FROM_PEOPLE_TO_ZOMBIES[i]));
+
+        // Update stocks
+        VectorStore(VectorMax(Zero, VectorSubtract(S, getting_bitten)), &Susceptible[i]);
+        VectorStore(VectorMax(Zero, VectorAdd(Z, becoming_infected)), &Zombies[i]);
+    }
+
+    // Each lane's cohort arrives after its own transit time, so the inflow is scattered per lane.
+    // The target plane was emptied when it last left, like the slot FZombieConveyor refills.
+    for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+    {
+        const int32 Plane = (ConveyorCursor + TransitSteps[Lane]) % MaxTransitSteps;
+        ConveyorSlots[static_cast<size_t>(Plane) * PaddedLanes + Lane] += Inflow[Lane];
+    }
+    ConveyorCursor++;
+
+    //Check if win or lose.
+    for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+    {
+        bLose[Lane] = Susceptible[Lane] <= LoseSusceptibleThreshold[Lane];
+        bWin[Lane] = Zombies[Lane] <= 0 || TimeStepsFinished[Lane] > WinDay[Lane];
+        TimeStepsFinished[Lane]++;
+    }
+}
+
+void FZombieModelBatch::Run(int32 MaxDays, bool bStopAtFirstOutcome, FZombieRunResult* OutResults)
+{
+    std::vector<uint8> bDone(NumLanes, 0);
+    int32 NumDone = 0;
+
+    for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+        OutResults[Lane] = FZombieRunResult();
+
+    auto Finish = [&](int32 Lane)
+    {
+        bDone[Lane] = 1;
+        NumDone++;
+        OutResults[Lane].FinalSusceptible = Susceptible[Lane];
+        OutResults[Lane].FinalBitten = ConveyorTotal[Lane];
+        OutResults[Lane].FinalZombies = Zombies[Lane];
+    };
+
+    for (int32 Day{0}; Day < MaxDays && NumDone < NumLanes; Day++)
+    {
+        StepBatch();
+
+        for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+        {
+            if (bDone[Lane])
+                continue;
+
+            FZombieRunResult& Result = OutResults[Lane];
+            Result.DaysRun++;
+
+            if (bLose[Lane] && Result.LoseDay < 0)
+                Result.LoseDay = TimeStepsFinished[Lane];
+            if (bWin[Lane] && Result.WinDay < 0)
+                Result.WinDay = TimeStepsFinished[Lane];
+
+            const bool bAnyOutcome = Result.LoseDay >= 0 || Result.WinDay >= 0;
+            const bool bBothOutcomes = Result.LoseDay >= 0 && Result.WinDay >= 0;
+            if (bBothOutcomes || (bStopAtFirstOutcome && bAnyOutcome))
+                Finish(Lane);
+        }
+    }
+
+    for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+    {
+        if (!bDone[Lane])
+            Finish(Lane);
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZombieModel.h"
+#include <vector>
+
+// Many independent copies of FZombieModel ("lanes") stepped together for sweeps.
+// Constants, stocks and conveyor cohorts are stored as structure-of-arrays, one float per lane,
+// and StepBatch advances four lanes per vector instruction. Every lane steps to bitwise the same
+// stocks as FZombieModel::RunSimulationStep on the model it was loaded from, a single lane included.
+// Lanes always step like the Stella reference, Euler over one day, see SupportsParams.
+class ZOMBIEAPOCALYPSE_API FZombieModelBatch
+{
+public:
+	// Shared by every lane, never modified after it is loaded
+	TSharedPtr<const FZombieGraph> Graph;
+
+	// Whether a model with these constants steps the same in a batch, i.e. it integrates with Euler at DT 1
+	// and its bitten people incubate on the conveyor
+	static bool SupportsParams(const FZombieModelParams& Params)
+	{
+		const FZombieStepSize StepSize(Params.DT);
+		return Params.IntegrationMethod == EZombieIntegrationMethod::Euler && StepSize.Days == 1 && StepSize.NumSubsteps == 1
+			&& Params.Incubation == EZombieIncubation::Conveyor;
+	}
+
+	// Loads one lane per model. All lanes use the curve of the first model.
+	void Initialize(const FZombieModel* Models, int32 NumModels);
+
+	int32 GetNumLanes() const { return NumLanes; }
+
+	// Advances every lane one day and increments its TimeStepsFinished
+	void StepBatch();
+
+	// FZombieModel::Run on every lane, OutResults must hold GetNumLanes() entries.
+	// Lanes that are done keep stepping with the others but stop being recorded.
+	void Run(int32 MaxDays, bool bStopAtFirstOutcome, FZombieRunResult* OutResults);
+
+	float GetSusceptible(int32 Lane) const { return Susceptible[Lane]; }
+	float GetBitten(int32 Lane) const { return ConveyorTotal[Lane]; }
+	float GetZombies(int32 Lane) const { return Zombies[Lane]; }
+	int32 GetTimeStepsFinished(int32 Lane) const { return TimeStepsFinished[Lane]; }
+
+	// Win/lose conditions of each lane as evaluated at the end of the last step
+	FZombieStepOutcome GetOutcome(int32 Lane) const { return { bLose[Lane] != 0, bWin[Lane] != 0 }; }
+
+private:
+	// Lanes rounded up to a whole number of vectors. The padding lanes are empty and never read back.
+	static constexpr int32 LanesPerVector = 4;
+	int32 NumLanes{ 0 };
+	int32 PaddedLanes{ 0 };
+
+	// Constants per lane, see FZombieModelParams
+	std::vector<float> Bitten_capacity;
+	std::vector<float> CONVERSION_FROM_PEOPLE_TO_ZOMBIES;
+	std::vector<float> normal_number_of_bites;
+	std::vector<float> land_area;
+	std::vector<float> normal_population_density;
+	std::vector<float> LoseSusceptibleThreshold;
+	std::vector<int32> WinDay;
+
+	// Stocks per lane. Bitten is the conveyor total.
+	std::vector<float> Susceptible;
+	std::vector<float> Zombies;
+	std::vector<int32> TimeStepsFinished;
+
+	// MaxTransitSteps planes of PaddedLanes, plane = arrival day % MaxTransitSteps.
+	// All lanes take their outflow from the same plane; the inflow goes TransitSteps[Lane] planes ahead.
+	std::vector<float> ConveyorSlots;
+	std::vector<float> ConveyorTotal;
+	std::vector<int32> TransitSteps;
+	int32 MaxTransitSteps{ 1 };
+	int32 ConveyorCursor{ 0 };
+
+	std::vector<uint8> bLose;
+	std::vector<uint8> bWin;
+
+	// Per-lane scratch, sized once in Initialize
+	std::vector<float> DensityRatio;
+	std::vector<float> DensityEffect;
+	std::vector<float> Inflow;
+};
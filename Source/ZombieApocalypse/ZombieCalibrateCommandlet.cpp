@@ -0,0 +1,140 @@
+#include "ZombieCalibrateCommandlet.h"
+#include "ZombieCommandletHelpers.h"
+#include "ZombieCalibration.h"
+#include "ZombieParametersAsset.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformTime.h"
+#if WITH_EDITOR
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+#endif
+
+namespace ZombieCalibrate
+{
+#if WITH_EDITOR
+    // Creates or replaces the asset at a long package name such as /Game/Calibration/DA_ZombieFitted
+    static bool SaveParametersAsset(const FString& PackageName, const FZombieCalibrationResult& Result, const TArray<FString>& SourceFiles)
+    {
+        FText Reason;
+        if (!FPackageName::IsValidLongPackageName(PackageName, false, &Reason))
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieCalibrate: %s is not a package name: %s"), *PackageName, *Reason.ToString());
+            return false;
+        }
+
+        UPackage* Package = CreatePackage(*PackageName);
+        Package->FullyLoad();
+
+        const FName AssetName(*FPackageName::GetLongPackageAssetName(PackageName));
+        UZombieParametersAsset* Asset = FindObject<UZombieParametersAsset>(Package, *AssetName.ToString());
+        if (!Asset)
+            Asset = NewObject<UZombieParametersAsset>(Package, AssetName, RF_Public | RF_Standalone);
+
+        Asset->Params = Result.Params;
+        Asset->CurvePoints.Reset(static_cast<int32>(Result.Graph->graphPts.size()));
+        for (const std::pair<float, float>& Point : Result.Graph->graphPts)
+            Asset->CurvePoints.Emplace(Point.first, Point.second);
+        Asset->Error = Result.Error;
+        Asset->SourceFiles = SourceFiles;
+        Package->MarkPackageDirty();
+
+        const FString FileName = FPackageName::LongPackageNameToFilename(PackageName, FPackageName::GetAssetPackageExtension());
+        FSavePackageArgs SaveArgs;
+        SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+        if (!UPackage::SavePackage(Package, Asset, *FileName, SaveArgs))
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieCalibrate: Could not save %s"), *FileName);
+            return false;
+        }
+
+        UE_LOG(LogTemp, Display, TEXT("ZombieCalibrate: Saved %s"), *PackageName);
+        return true;
+    }
+#endif
+}
+
+UZombieCalibrateCommandlet::UZombieCalibrateCommandlet()
+{
+    IsClient = false;
+    IsEditor = false;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 UZombieCalibrateCommandlet::Main(const FString& Params)
+{
+    FZombieModel BaseModel;
+    if (!ZombieCommandlets::LoadBaseModel(Params, BaseModel))
+        return 1;
+
+    FString ObservedText;
+    if (!FParse::Value(*Params, TEXT("Observed="), ObservedText, false))
+    {
+        UE_LOG(LogTemp, Error, TEXT("ZombieCalibrate: Needs -Observed=<history file>[,<history file>...]"));
+        return 1;
+    }
+
+    TArray<FString> SourceFiles;
+    ObservedText.ParseIntoArray(SourceFiles, TEXT(","));
+
+    TArray<FZombieObservedRun> Observed;
+    for (FString& SourceFile : SourceFiles)
+    {
+        SourceFile.TrimStartAndEndInline();
+        const FString FilePath = FPaths::IsRelative(SourceFile) ? FPaths::ProjectSavedDir() / SourceFile : SourceFile;
+        if (!Observed.AddDefaulted_GetRef().ReadHistoryFile(FilePath))
+            return 1;
+    }
+
+    FZombieCalibrationSettings Settings;
+    FString FitText;
+    if (FParse::Value(*Params, TEXT("Fit="), FitText, false))
+    {
+        Settings.bFitBites = FitText.Contains(TEXT("Bites"));
+        Settings.bFitConversion = FitText.Contains(TEXT("Conversion"));
+        Settings.bFitLandArea = FitText.Contains(TEXT("LandArea"));
+        Settings.bFitCurve = FitText.Contains(TEXT("Curve"));
+    }
+    FParse::Value(*Params, TEXT("Iterations="), Settings.MaxIterations);
+    FParse::Value(*Params, TEXT("Tolerance="), Settings.Tolerance);
+    FParse::Value(*Params, TEXT("Restarts="), Settings.Restarts);
+
+    const double StartTime = FPlatformTime::Seconds();
+    const FZombieCalibrationResult Result = ZombieCalibration::Fit(BaseModel, Observed, Settings);
+    const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+    UE_LOG(LogTemp, Display, TEXT("ZombieCalibrate: %d iterations, %d runs in %.3f seconds, mean squared error %g -> %g"),
+        Result.Iterations, Result.Evaluations, Elapsed, Result.InitialError, Result.Error);
+    UE_LOG(LogTemp, Display, TEXT("ZombieCalibrate: normal_number_of_bites = %g, CONVERSION_FROM_PEOPLE_TO_ZOMBIES = %g, land_area = %g"),
+        Result.Params.normal_number_of_bites, Result.Params.CONVERSION_FROM_PEOPLE_TO_ZOMBIES, Result.Params.land_area);
+
+    // Same layout as PopulationDensityEffect.csv, so it works as -Curve or as the source of a UZombieCurveAsset
+    FString Csv(TEXT("---,PopulationDensity,NormalPopulationDensity\n"));
+    for (int32 Point = 0; Point < static_cast<int32>(Result.Graph->graphPts.size()); ++Point)
+        Csv += FString::Printf(TEXT("%d, %.3f, %.6f\n"), Point + 1, Result.Graph->graphPts[Point].first, Result.Graph->graphPts[Point].second);
+
+    FString OutPath = FPaths::ProjectSavedDir() / TEXT("ZombieCalibration.csv");
+    FParse::Value(*Params, TEXT("Out="), OutPath);
+
+    if (!FFileHelper::SaveStringToFile(Csv, *OutPath))
+    {
+        UE_LOG(LogTemp, Error, TEXT("ZombieCalibrate: Could not write %s"), *OutPath);
+        return 1;
+    }
+    UE_LOG(LogTemp, Display, TEXT("ZombieCalibrate: Wrote the fitted curve to %s"), *OutPath);
+
+    FString AssetPath;
+    if (FParse::Value(*Params, TEXT("Asset="), AssetPath))
+    {
+#if WITH_EDITOR
+        if (!ZombieCalibrate::SaveParametersAsset(AssetPath, Result, SourceFiles))
+            return 1;
+#else
+        UE_LOG(LogTemp, Warning, TEXT("ZombieCalibrate: -Asset needs an editor build, only the curve file was written"));
+#endif
+    }
+
+    return 0;
+}
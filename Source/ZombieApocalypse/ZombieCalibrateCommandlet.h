@@ -0,0 +1,29 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ZombieCalibrateCommandlet.generated.h"
+
+/**
+ * Fits the model constants and the y values of the lookup curve to stocks recorded in play sessions,
+ * see ZombieCalibration::Fit, and writes the fitted curve in the PopulationDensityEffect.csv layout.
+ * Editor builds also save the result as a UZombieParametersAsset.
+ *
+ * Example:
+ *   UnrealEditor-Cmd ZombieApocalypse.uproject -run=ZombieCalibrate -Observed=ZombieHistory.csv,Session2.bin -Asset=/Game/Calibration/DA_ZombieFitted
+ *
+ * -Observed takes history files written by USimulationHistoryComponent, relative paths are inside Saved.
+ * -Fit=Bites,Conversion,LandArea,Curve picks the inputs to fit (all of them by default).
+ * -Iterations=<n>, -Tolerance=<fraction> and -Restarts=<n> control the search, -Out=<file.csv> the curve file.
+ * Takes the same -Controller, -Parameters, -Curve and -Table options as ZombieSweep; the fit starts from that model.
+ */
+UCLASS()
+class ZOMBIEAPOCALYPSE_API UZombieCalibrateCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UZombieCalibrateCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,341 @@
+#include "ZombieCalibration.h"
+#include "Async/ParallelFor.h"
+#include "Misc/FileHelper.h"
+
+namespace ZombieCalibration
+{
+    // Binary history layout, see USimulationHistoryComponent: "ZHST", version and column count, then one
+    // float per column per row starting with Day, Susceptible, Bitten, Zombies
+    static constexpr uint32 HistoryMagic = 0x5453485A;
+    static constexpr int32 HistoryHeaderSize = 3 * sizeof(uint32);
+    static constexpr int32 HistoryStockColumns = 4;
+
+    // Reflected, expanded, outside and inside contracted point of a Nelder-Mead iteration
+    static constexpr int32 NumCandidates = 4;
+
+    // Input a coordinate of the simplex stands for
+    struct FInput
+    {
+        enum class EKind : uint8
+        {
+            Bites,
+            Conversion,
+            LandArea,
+            CurvePoint
+        };
+
+        EKind Kind;
+        int32 PointIndex;
+
+        // Coordinates are in units of the starting value, so one step size suits inputs of any magnitude
+        float Scale;
+    };
+
+    // Model and curve of one worker slot, overwritten for every point it scores
+    struct FEvaluator
+    {
+        FZombieModel Model;
+        TSharedPtr<FZombieGraph> Graph;
+    };
+
+    static void ApplyInputs(const TArray<FInput>& Inputs, const float* Point, FZombieModelParams& Params, FZombieGraph& Graph)
+    {
+        for (int32 i = 0; i < Inputs.Num(); ++i)
+        {
+            // All of them are rates, areas or multipliers, none can go below zero
+            const float Value = FMath::Max(0.f, Point[i] * Inputs[i].Scale);
+            switch (Inputs[i].Kind)
+            {
+            case FInput::EKind::Bites:      Params.normal_number_of_bites = Value; break;
+            case FInput::EKind::Conversion: Params.CONVERSION_FROM_PEOPLE_TO_ZOMBIES = Value; break;
+            case FInput::EKind::LandArea:   Params.land_area = FMath::Max(Value, UE_KINDA_SMALL_NUMBER); break;
+            case FInput::EKind::CurvePoint: Graph.graphPts[Inputs[i].PointIndex].second = Value; break;
+            }
+        }
+        Graph.Rebake();
+    }
+
+    // Mean squared error of the stocks over every recorded row
+    static float Score(FEvaluator& Evaluator, const FZombieModel& Base, const TArray<FInput>& Inputs, const float* Point, const TArray<FZombieObservedRun>& Observed)
+    {
+        FZombieModel& Model = Evaluator.Model;
+        Model.Params = Base.Params;
+        ApplyInputs(Inputs, Point, Model.Params, *Evaluator.Graph);
+
+        double SquaredError = 0.0;
+        int32 NumValues = 0;
+        for (const FZombieObservedRun& Run : Observed)
+        {
+            // The conveyor has the same length as the one already in the slot, so this copies into its storage
+            Model.State = Base.State;
+            for (int32 Row = 0; Row < Run.Num(); ++Row)
+            {
+                while (Model.State.TimeStepsFinished < Run.Days[Row])
+                    Model.RunSimulationStep();
+
+                SquaredError += FMath::Square(static_cast<double>(Model.State.Susceptible - Run.Susceptible[Row]))
+                    + FMath::Square(static_cast<double>(Model.State.Bitten - Run.Bitten[Row]))
+                    + FMath::Square(static_cast<double>(Model.State.Zombies - Run.Zombies[Row]));
+                NumValues += 3;
+            }
+        }
+
+        const float Error = NumValues > 0 ? static_cast<float>(SquaredError / NumValues) : 0.f;
+        return FMath::IsFinite(Error) ? Error : MAX_flt;
+    }
+}
+
+bool FZombieObservedRun::ReadHistoryFile(const FString& FilePath)
+{
+    using namespace ZombieCalibration;
+
+    Days.Reset();
+    Susceptible.Reset();
+    Bitten.Reset();
+    Zombies.Reset();
+
+    TArray<uint8> Bytes;
+    if (!FFileHelper::LoadFileToArray(Bytes, *FilePath))
+    {
+        UE_LOG(LogTemp, Error, TEXT("ZombieCalibration: Could not read %s"), *FilePath);
+        return false;
+    }
+
+    uint32 Header[3] = { 0, 0, 0 };
+    if (Bytes.Num() >= HistoryHeaderSize)
+        FMemory::Memcpy(Header, Bytes.GetData(), HistoryHeaderSize);
+
+    if (Header[0] == HistoryMagic)
+    {
+        const int32 NumColumns = static_cast<int32>(Header[2]);
+        const int32 RowSize = NumColumns * sizeof(float);
+        if (NumColumns < HistoryStockColumns || (Bytes.Num() - HistoryHeaderSize) % RowSize != 0)
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieCalibration: %s is not a complete binary history"), *FilePath);
+            return false;
+        }
+
+        for (int32 Offset = HistoryHeaderSize; Offset < Bytes.Num(); Offset += RowSize)
+        {
+            float Row[HistoryStockColumns];
+            FMemory::Memcpy(Row, Bytes.GetData() + Offset, sizeof(Row));
+            Days.Add(FMath::RoundToInt(Row[0]));
+            Susceptible.Add(Row[1]);
+            Bitten.Add(Row[2]);
+            Zombies.Add(Row[3]);
+        }
+    }
+    else
+    {
+        FString Text;
+        FFileHelper::BufferToString(Text, Bytes.GetData(), Bytes.Num());
+
+        TArray<FString> Lines;
+        Text.ParseIntoArrayLines(Lines);
+        for (const FString& Line : Lines)
+        {
+            // Header row starts with "---" like the DataTable export, then row number, Day, Susceptible, Bitten, Zombies
+            if (Line.StartsWith(TEXT("---")))
+                continue;
+
+            TArray<FString> Columns;
+            Line.ParseIntoArray(Columns, TEXT(","));
+            if (Columns.Num() < HistoryStockColumns + 1)
+                continue;
+
+            Days.Add(FCString::Atoi(*Columns[1].TrimStartAndEnd()));
+            Susceptible.Add(FCString::Atof(*Columns[2].TrimStartAndEnd()));
+            Bitten.Add(FCString::Atof(*Columns[3].TrimStartAndEnd()));
+            Zombies.Add(FCString::Atof(*Columns[4].TrimStartAndEnd()));
+        }
+    }
+
+    for (int32 Row = 1; Row < Days.Num(); ++Row)
+    {
+        if (Days[Row] < Days[Row - 1])
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieCalibration: Days in %s go backwards at row %d"), *FilePath, Row + 1);
+            return false;
+        }
+    }
+
+    if (Days.Num() == 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("ZombieCalibration: %s has no recorded days"), *FilePath);
+        return false;
+    }
+    return true;
+}
+
+FZombieCalibrationResult ZombieCalibration::Fit(const FZombieModel& Model, const TArray<FZombieObservedRun>& Observed, const FZombieCalibrationSettings& Settings)
+{
+    FZombieCalibrationResult Result;
+    Result.Params = Model.Params;
+    Result.Graph = Model.Graph ? MakeShared<FZombieGraph>(*Model.Graph) : MakeShared<FZombieGraph>();
+
+    TArray<FInput> Inputs;
+    TArray<float> BestPoint;
+    auto AddInput = [&Inputs, &BestPoint](FInput::EKind Kind, int32 PointIndex, float Value)
+    {
+        const float Scale = FMath::Abs(Value) > UE_KINDA_SMALL_NUMBER ? FMath::Abs(Value) : 1.f;
+        Inputs.Add({ Kind, PointIndex, Scale });
+        BestPoint.Add(Value / Scale);
+    };
+
+    if (Settings.bFitBites)
+        AddInput(FInput::EKind::Bites, INDEX_NONE, Model.Params.normal_number_of_bites);
+    if (Settings.bFitConversion)
+        AddInput(FInput::EKind::Conversion, INDEX_NONE, Model.Params.CONVERSION_FROM_PEOPLE_TO_ZOMBIES);
+    if (Settings.bFitLandArea)
+        AddInput(FInput::EKind::LandArea, INDEX_NONE, Model.Params.land_area);
+    if (Settings.bFitCurve)
+    {
+        for (int32 Point = 0; Point < static_cast<int32>(Result.Graph->graphPts.size()); ++Point)
+            AddInput(FInput::EKind::CurvePoint, Point, Result.Graph->graphPts[Point].second);
+    }
+
+    const int32 N = Inputs.Num();
+
+    // Every point scored in parallel gets a slot of its own: the whole simplex when it is built or shrunk,
+    // the candidates otherwise. Each slot is sized here, once.
+    TArray<FEvaluator> Evaluators;
+    Evaluators.SetNum(FMath::Max(N + 1, NumCandidates));
+    for (FEvaluator& Evaluator : Evaluators)
+    {
+        Evaluator.Graph = MakeShared<FZombieGraph>(*Result.Graph);
+        Evaluator.Model = Model;
+        Evaluator.Model.Graph = Evaluator.Graph;
+    }
+
+    auto ScorePoints = [&](const float* Points, float* OutErrors, int32 NumPoints)
+    {
+        ParallelFor(NumPoints, [&](int32 Index)
+        {
+            OutErrors[Index] = Score(Evaluators[Index], Model, Inputs, Points + Index * N, Observed);
+        });
+        Result.Evaluations += NumPoints;
+    };
+
+    if (N == 0 || Observed.Num() == 0)
+    {
+        ScorePoints(BestPoint.GetData(), &Result.Error, 1);
+        Result.InitialError = Result.Error;
+        return Result;
+    }
+
+    // Vertex i is Vertices[i * N .. i * N + N)
+    TArray<float> Vertices;
+    Vertices.SetNumUninitialized((N + 1) * N);
+    TArray<float> Errors;
+    Errors.SetNumUninitialized(N + 1);
+    TArray<float> Candidates;
+    Candidates.SetNumUninitialized(NumCandidates * N);
+    float CandidateErrors[NumCandidates];
+    TArray<float> Centroid;
+    Centroid.SetNumUninitialized(N);
+
+    float BestError = MAX_flt;
+    for (int32 Restart = 0; Restart <= Settings.Restarts && Result.Iterations < Settings.MaxIterations; ++Restart)
+    {
+        // Best point so far plus a step along every axis
+        for (int32 Vertex = 0; Vertex <= N; ++Vertex)
+        {
+            FMemory::Memcpy(&Vertices[Vertex * N], BestPoint.GetData(), N * sizeof(float));
+            if (Vertex > 0)
+            {
+                float& Coordinate = Vertices[Vertex * N + Vertex - 1];
+                Coordinate += Settings.InitialStep * (FMath::Abs(Coordinate) > UE_KINDA_SMALL_NUMBER ? FMath::Abs(Coordinate) : 1.f);
+            }
+        }
+        ScorePoints(Vertices.GetData(), Errors.GetData(), N + 1);
+        if (Restart == 0)
+            Result.InitialError = Errors[0];
+
+        int32 Best = 0;
+        while (Result.Iterations < Settings.MaxIterations)
+        {
+            Best = 0;
+            int32 Worst = 0;
+            for (int32 Vertex = 1; Vertex <= N; ++Vertex)
+            {
+                if (Errors[Vertex] < Errors[Best])
+                    Best = Vertex;
+                if (Errors[Vertex] > Errors[Worst])
+                    Worst = Vertex;
+            }
+            if (Errors[Worst] - Errors[Best] <= Settings.Tolerance * Errors[Best])
+                break;
+
+            int32 SecondWorst = Best;
+            for (int32 Vertex = 0; Vertex <= N; ++Vertex)
+            {
+                if (Vertex != Worst && Errors[Vertex] > Errors[SecondWorst])
+                    SecondWorst = Vertex;
+            }
+
+            ++Result.Iterations;
+
+            FMemory::Memzero(Centroid.GetData(), N * sizeof(float));
+            for (int32 Vertex = 0; Vertex <= N; ++Vertex)
+            {
+                if (Vertex == Worst)
+                    continue;
+                for (int32 i = 0; i < N; ++i)
+                    Centroid[i] += Vertices[Vertex * N + i];
+            }
+
+            static constexpr float CandidateSteps[NumCandidates] = { 1.f, 2.f, 0.5f, -0.5f };
+            for (int32 i = 0; i < N; ++i)
+            {
+                Centroid[i] /= N;
+                const float Direction = Centroid[i] - Vertices[Worst * N + i];
+                for (int32 Candidate = 0; Candidate < NumCandidates; ++Candidate)
+                    Candidates[Candidate * N + i] = Centroid[i] + CandidateSteps[Candidate] * Direction;
+            }
+            ScorePoints(Candidates.GetData(), CandidateErrors, NumCandidates);
+
+            // The choice sequential Nelder-Mead makes, it just never has to wait for the second point
+            const float Reflected = CandidateErrors[0];
+            int32 Accepted = INDEX_NONE;
+            if (Reflected < Errors[Best])
+                Accepted = CandidateErrors[1] < Reflected ? 1 : 0;
+            else if (Reflected < Errors[SecondWorst])
+                Accepted = 0;
+            else if (Reflected < Errors[Worst])
+                Accepted = CandidateErrors[2] <= Reflected ? 2 : INDEX_NONE;
+            else
+                Accepted = CandidateErrors[3] < Errors[Worst] ? 3 : INDEX_NONE;
+
+            if (Accepted != INDEX_NONE)
+            {
+                FMemory::Memcpy(&Vertices[Worst * N], &Candidates[Accepted * N], N * sizeof(float));
+                Errors[Worst] = CandidateErrors[Accepted];
+                continue;
+            }
+
+            // Shrink towards the best vertex. It is scored again with the rest, which is cheaper than
+            // compacting the others when they are scored at the same time anyway.
+            for (int32 Vertex = 0; Vertex <= N; ++Vertex)
+            {
+                for (int32 i = 0; i < N; ++i)
+                    Vertices[Vertex * N + i] = Vertices[Best * N + i] + 0.5f * (Vertices[Vertex * N + i] - Vertices[Best * N + i]);
+            }
+            ScorePoints(Vertices.GetData(), Errors.GetData(), N + 1);
+        }
+
+        for (int32 Vertex = 1; Vertex <= N; ++Vertex)
+        {
+            if (Errors[Vertex] < Errors[Best])
+                Best = Vertex;
+        }
+        if (Errors[Best] < BestError)
+        {
+            BestError = Errors[Best];
+            FMemory::Memcpy(BestPoint.GetData(), &Vertices[Best * N], N * sizeof(float));
+        }
+    }
+
+    ApplyInputs(Inputs, BestPoint.GetData(), Result.Params, *Result.Graph);
+    Result.Error = BestError;
+    return Result;
+}
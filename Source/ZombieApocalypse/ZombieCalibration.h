@@ -0,0 +1,71 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZombieModel.h"
+
+// Stocks recorded over a play session, e.g. by USimulationHistoryComponent
+struct FZombieObservedRun
+{
+	// TimeStepsFinished of every row, in increasing order
+	TArray<int32> Days;
+	TArray<float> Susceptible;
+	TArray<float> Bitten;
+	TArray<float> Zombies;
+
+	int32 Num() const { return Days.Num(); }
+
+	// Reads a history file in either format USimulationHistoryComponent writes. Logs and returns false on failure.
+	bool ReadHistoryFile(const FString& FilePath);
+};
+
+struct FZombieCalibrationSettings
+{
+	// Inputs that are fitted, everything else keeps the value of the base model
+	bool bFitBites{ true };
+	bool bFitConversion{ true };
+	bool bFitLandArea{ true };
+	bool bFitCurve{ true };
+
+	int32 MaxIterations{ 5000 };
+
+	// The simplex has converged when the worst error is within this fraction of the best
+	float Tolerance{ 1.e-6f };
+
+	// Size of the starting simplex as a fraction of every input
+	float InitialStep{ 0.1f };
+
+	// The search starts again around the best point this many times after it converges,
+	// which gets Nelder-Mead out of a simplex that collapsed before reaching the minimum
+	int32 Restarts{ 2 };
+};
+
+struct FZombieCalibrationResult
+{
+	// The base model's constants with the fitted ones replaced
+	FZombieModelParams Params;
+
+	// The base model's curve with the fitted y values, baked like the base one
+	TSharedPtr<FZombieGraph> Graph;
+
+	// Mean squared error per recorded day and stock, before and after fitting
+	float InitialError{ 0.f };
+	float Error{ 0.f };
+
+	int32 Iterations{ 0 };
+	int32 Evaluations{ 0 };
+};
+
+namespace ZombieCalibration
+{
+	/**
+	 * Fits normal_number_of_bites, CONVERSION_FROM_PEOPLE_TO_ZOMBIES, land_area and the y values of the curve
+	 * so that Model, run from its current state, reproduces the recorded stocks in the least squares sense.
+	 *
+	 * Nelder-Mead over the inputs scaled by their starting values. Every iteration scores the reflected,
+	 * expanded and both contracted points at once across the worker threads, then takes the one the
+	 * sequential method would have taken, so the search is the textbook one at the wall clock cost of a single
+	 * run per iteration. Every worker slot steps its own copy of the model and curve, sized once up front,
+	 * so scoring a point does not allocate.
+	 */
+	ZOMBIEAPOCALYPSE_API FZombieCalibrationResult Fit(const FZombieModel& Model, const TArray<FZombieObservedRun>& Observed, const FZombieCalibrationSettings& Settings);
+}
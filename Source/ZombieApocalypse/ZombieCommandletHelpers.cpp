@@ -0,0 +1,107 @@
+#include "ZombieCommandletHelpers.h"
+#include "SimulationController.h"
+#include "ZombieCurveAsset.h"
+#include "ZombieParametersAsset.h"
+
+bool ZombieCommandlets::LoadBaseModel(const FString& Params, FZombieModel& OutModel)
+{
+    // Defaults come from the SimulationController class so runs start from the level setup
+    TSubclassOf<ASimulationController> ControllerClass = ASimulationController::StaticClass();
+    FString ControllerPath;
+    if (FParse::Value(*Params, TEXT("Controller="), ControllerPath))
+    {
+        ControllerClass = LoadClass<ASimulationController>(nullptr, *ControllerPath);
+        if (!ControllerClass)
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieCommandlets: Could not load controller class %s"), *ControllerPath);
+            return false;
+        }
+    }
+    const ASimulationController* Defaults = ControllerClass->GetDefaultObject<ASimulationController>();
+
+    OutModel.Params = Defaults->GetModelParams();
+    OutModel.State.Susceptible = Defaults->Susceptible;
+    OutModel.State.Zombies = Defaults->Zombies;
+    OutModel.State.Bitten = Defaults->Bitten;
+
+    // Constants and curve fitted by ZombieCalibrate, the overrides below still apply on top
+    const UZombieParametersAsset* ParametersAsset = nullptr;
+    FString ParametersPath;
+    if (FParse::Value(*Params, TEXT("Parameters="), ParametersPath))
+    {
+        ParametersAsset = LoadObject<UZombieParametersAsset>(nullptr, *ParametersPath);
+        if (!ParametersAsset)
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieCommandlets: Could not load parameters asset %s"), *ParametersPath);
+            return false;
+        }
+        OutModel.Params = ParametersAsset->Params;
+    }
+
+    FString Integrator;
+    if (FParse::Value(*Params, TEXT("Integrator="), Integrator))
+    {
+        const int64 Method = StaticEnum<EZombieIntegrationMethod>()->GetValueByNameString(Integrator);
+        if (Method == INDEX_NONE)
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieCommandlets: Unknown integrator %s, use Euler, RK2 or RK4"), *Integrator);
+            return false;
+        }
+        OutModel.Params.IntegrationMethod = static_cast<EZombieIntegrationMethod>(Method);
+    }
+    FParse::Value(*Params, TEXT("DT="), OutModel.Params.DT);
+
+    FString Incubation;
+    if (FParse::Value(*Params, TEXT("Incubation="), Incubation))
+    {
+        const int64 Type = StaticEnum<EZombieIncubation>()->GetValueByNameString(Incubation);
+        if (Type == INDEX_NONE)
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieCommandlets: Unknown incubation %s, use Conveyor, Delay1, Delay3 or LeakyConveyor"), *Incubation);
+            return false;
+        }
+        OutModel.Params.Incubation = static_cast<EZombieIncubation>(Type);
+    }
+    FParse::Value(*Params, TEXT("Leakage="), OutModel.Params.leakage_fraction);
+
+    // Lookup curve: CSV file first, then the parameters asset, then the controller's cooked curve, then a DataTable
+    TSharedPtr<FZombieGraph> Graph = MakeShared<FZombieGraph>();
+    FString CurvePath;
+    FString TablePath(TEXT("/Game/DataTables/DT_PopulationDensityEffect.DT_PopulationDensityEffect"));
+    const bool bTableGiven = FParse::Value(*Params, TEXT("Table="), TablePath);
+    if (FParse::Value(*Params, TEXT("Curve="), CurvePath))
+    {
+        if (!Graph->ReadFromCsvFile(CurvePath))
+            return false;
+    }
+    else if (!bTableGiven && ParametersAsset && ParametersAsset->CurvePoints.Num() > 0)
+    {
+        OutModel.Graph = ParametersAsset->MakeGraph();
+        return true;
+    }
+    else if (!bTableGiven && Defaults->PopulationDensityEffectCurve)
+    {
+        // Already baked when it was cooked
+        OutModel.Graph = Defaults->PopulationDensityEffectCurve->MakeGraph();
+        return OutModel.Graph.IsValid();
+    }
+    else
+    {
+        const UDataTable* Table = Defaults->PopulationDensityEffectTable;
+        if (bTableGiven || !Table)
+            Table = LoadObject<UDataTable>(nullptr, *TablePath);
+
+        if (!Table)
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieCommandlets: Could not load lookup table %s"), *TablePath);
+            return false;
+        }
+        Graph->ReadFromDataTable(*Table);
+    }
+
+    if (Defaults->bBakeLookupTable)
+        Graph->Bake(Defaults->LookupTableResolution);
+
+    OutModel.Graph = Graph;
+    return true;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZombieModel.h"
+
+namespace ZombieCommandlets
+{
+	/**
+	 * Builds a model from the SimulationController defaults, for commandlets that run it headless.
+	 *   -Controller=<class path>  Blueprint subclass to take the defaults from (native class otherwise)
+	 *   -Curve=<file.csv>         Lookup curve in the PopulationDensityEffect.csv layout
+	 *   -Parameters=<object path> UZombieParametersAsset whose constants and curve replace the controller's
+	 *   -Table=<object path>      Lookup DataTable, used when there is no -Curve
+	 *   Without either, the controller's cooked PopulationDensityEffectCurve is used when it has one
+	 *   -Integrator=<Euler|RK2|RK4> and -DT=<days> override the integration settings
+	 *   -Incubation=<Conveyor|Delay1|Delay3|LeakyConveyor> overrides how bitten people turn
+	 *   -Leakage=<fraction> overrides the share of a leaky conveyor that leaks each day
+	 * Returns false and logs when something could not be loaded.
+	 */
+	ZOMBIEAPOCALYPSE_API bool LoadBaseModel(const FString& Params, FZombieModel& OutModel);
+}
@@ -0,0 +1,218 @@
+#include "ZombieCrowdCheckCommandlet.h"
+#include "ZombieCrowdSpawner.h"
+#include "ZombieCrowdSubsystem.h"
+#include "ZombieCrowdVisualsAsset.h"
+#include "MassEntitySubsystem.h"
+#include "MassEntityManager.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+namespace ZombieCrowdCheck
+{
+    static constexpr float FrameTime = 1.f / 30.f;
+
+    static const TCHAR* TypeNames[] = { TEXT("Susceptible"), TEXT("Bitten"), TEXT("Zombie") };
+
+    // Frame ranges that differ for every type and cycle, so a wrong pick shows in the custom data
+    static UZombieCrowdVisualsAsset* MakeVisuals()
+    {
+        UStaticMesh* Mesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+        if (!Mesh)
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieCrowdCheck: Could not load /Engine/BasicShapes/Cube"));
+            return nullptr;
+        }
+
+        UZombieCrowdVisualsAsset* Visuals = NewObject<UZombieCrowdVisualsAsset>(GetTransientPackage());
+        int32 StartFrame = 0;
+        for (FZombieCrowdTypeVisuals* TypeVisuals : { &Visuals->Susceptible, &Visuals->Bitten, &Visuals->Zombie })
+        {
+            TypeVisuals->Mesh = Mesh;
+            TypeVisuals->Idle.StartFrame = StartFrame;
+            TypeVisuals->Idle.NumFrames = 20;
+            TypeVisuals->Idle.FramesPerSecond = 24.f;
+            TypeVisuals->Walk.StartFrame = StartFrame + 20;
+            TypeVisuals->Walk.NumFrames = 30;
+            TypeVisuals->Walk.FramesPerSecond = 30.f;
+            StartFrame += 50;
+        }
+        return Visuals;
+    }
+
+    static void TickWorld(UWorld* World, int32 Frames)
+    {
+        for (int32 Frame = 0; Frame < Frames; ++Frame)
+        {
+            World->Tick(LEVELTICK_All, FrameTime);
+        }
+    }
+
+    // Every agent of every type has exactly one instance at its location, with the custom data of its cycle
+    static bool CheckInstances(UWorld* World, const UZombieCrowdSubsystem& Crowd, const TCHAR* Stage)
+    {
+        const FMassEntityManager& EntityManager = World->GetSubsystem<UMassEntitySubsystem>()->GetEntityManager();
+        const FZombieCrowdSettings& Settings = Crowd.GetSettings();
+        const UZombieCrowdVisualsAsset* Visuals = Crowd.GetVisuals();
+
+        bool bPassed = true;
+        for (int32 Type = 0; Type < UE_ARRAY_COUNT(TypeNames); ++Type)
+        {
+            const EPopulationType PopulationType = static_cast<EPopulationType>(Type);
+            const UInstancedStaticMeshComponent* Instances = Crowd.GetRepresentation(PopulationType);
+            const TConstArrayView<FMassEntityHandle> Agents = Crowd.GetAgents(PopulationType);
+            if (!Instances || Instances->GetInstanceCount() != Agents.Num())
+            {
+                UE_LOG(LogTemp, Error, TEXT("ZombieCrowdCheck: %s: %d %s agents but %d instances"),
+                    Stage, Agents.Num(), TypeNames[Type], Instances ? Instances->GetInstanceCount() : 0);
+                bPassed = false;
+                continue;
+            }
+
+            if (Instances->NumCustomDataFloats != UZombieCrowdVisualsAsset::NumCustomDataFloats
+                || Instances->PerInstanceSMCustomData.Num() != Agents.Num() * UZombieCrowdVisualsAsset::NumCustomDataFloats)
+            {
+                UE_LOG(LogTemp, Error, TEXT("ZombieCrowdCheck: %s: %s instances have %d custom data floats for %d instances"),
+                    Stage, TypeNames[Type], Instances->PerInstanceSMCustomData.Num(), Agents.Num());
+                bPassed = false;
+                continue;
+            }
+
+            // Instances are in chunk order, so every one is matched to the agent standing where it is
+            TArray<FVector> Locations;
+            Locations.Reserve(Agents.Num());
+            for (const FMassEntityHandle Agent : Agents)
+            {
+                Locations.Add(EntityManager.GetFragmentDataChecked<FZombieCrowdLocationFragment>(Agent).Location);
+            }
+
+            const FZombieCrowdTypeVisuals& TypeVisuals = Visuals->Get(PopulationType);
+            const FZombieCrowdAnimation& Expected = Settings.IsWalking(PopulationType) ? TypeVisuals.Walk : TypeVisuals.Idle;
+
+            for (int32 Instance = 0; Instance < Agents.Num(); ++Instance)
+            {
+                FTransform Transform;
+                Instances->GetInstanceTransform(Instance, Transform, true);
+
+                const int32 Match = Locations.IndexOfByPredicate([&Transform](const FVector& Location)
+                {
+                    return Location.Equals(Transform.GetLocation(), 0.01);
+                });
+                if (Match == INDEX_NONE || !Transform.GetScale3D().Equals(FVector(Settings.Scale), 0.001))
+                {
+                    UE_LOG(LogTemp, Error, TEXT("ZombieCrowdCheck: %s: %s instance %d at %s scale %s matches no agent"),
+                        Stage, TypeNames[Type], Instance, *Transform.GetLocation().ToString(), *Transform.GetScale3D().ToString());
+                    bPassed = false;
+                    break;
+                }
+                Locations.RemoveAtSwap(Match, EAllowShrinking::No);
+
+                const float* CustomData = &Instances->PerInstanceSMCustomData[Instance * UZombieCrowdVisualsAsset::NumCustomDataFloats];
+                const bool bCustomDataMatches = CustomData[0] == Expected.StartFrame && CustomData[1] == Expected.NumFrames
+                    && CustomData[2] == Expected.FramesPerSecond && CustomData[3] >= 0.f && CustomData[3] < 1.f && CustomData[4] == Type;
+                if (!bCustomDataMatches)
+                {
+                    UE_LOG(LogTemp, Error, TEXT("ZombieCrowdCheck: %s: %s instance %d has custom data %.0f %.0f %.0f %.3f %.0f, expected %d %d %.0f [0, 1) %d"),
+                        Stage, TypeNames[Type], Instance, CustomData[0], CustomData[1], CustomData[2], CustomData[3], CustomData[4],
+                        Expected.StartFrame, Expected.NumFrames, Expected.FramesPerSecond, Type);
+                    bPassed = false;
+                    break;
+                }
+            }
+        }
+
+        if (bPassed)
+        {
+            UE_LOG(LogTemp, Display, TEXT("ZombieCrowdCheck: %s: %d susceptible, %d bitten and %d zombie instances match their agents"), Stage,
+                Crowd.GetCount(EPopulationType::Susceptible), Crowd.GetCount(EPopulationType::Bitten), Crowd.GetCount(EPopulationType::Zombie));
+        }
+        return bPassed;
+    }
+
+    static bool Run(UWorld* World, const FString& Params)
+    {
+        int32 NumSusceptible = 200;
+        int32 NumZombies = 10;
+        int32 Frames = 10;
+        FParse::Value(*Params, TEXT("Susceptible="), NumSusceptible);
+        FParse::Value(*Params, TEXT("Zombies="), NumZombies);
+        FParse::Value(*Params, TEXT("Frames="), Frames);
+
+        UZombieCrowdVisualsAsset* Visuals = MakeVisuals();
+        UZombieCrowdSubsystem* Crowd = World->GetSubsystem<UZombieCrowdSubsystem>();
+        if (!Visuals || !Crowd || !World->GetSubsystem<UMassEntitySubsystem>())
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieCrowdCheck: The world has no crowd or entity subsystem"));
+            return false;
+        }
+
+        AZombieCrowdSpawner* Spawner = World->SpawnActorDeferred<AZombieCrowdSpawner>(AZombieCrowdSpawner::StaticClass(), FTransform::Identity);
+        Spawner->NumberOfSusceptible = NumSusceptible;
+        Spawner->NumberOfZombies = NumZombies;
+        Spawner->Visuals = Visuals;
+        Spawner->bAutoSpawnOnBeginPlay = true;
+        Spawner->FinishSpawning(FTransform::Identity);
+
+        if (Crowd->GetCount(EPopulationType::Susceptible) != NumSusceptible || Crowd->GetCount(EPopulationType::Zombie) != NumZombies)
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieCrowdCheck: Spawned %d susceptible and %d zombies, asked for %d and %d"),
+                Crowd->GetCount(EPopulationType::Susceptible), Crowd->GetCount(EPopulationType::Zombie), NumSusceptible, NumZombies);
+            return false;
+        }
+
+        // Without teleports nobody is bitten, so the counts hold still and zombies walk like the susceptible
+        FZombieCrowdSettings Settings = Crowd->GetSettings();
+        Settings.bEnableTeleportation = false;
+        Settings.bShouldWander = true;
+        Crowd->SetSettings(Settings);
+
+        TickWorld(World, Frames);
+        bool bPassed = CheckInstances(World, *Crowd, TEXT("Walking"));
+
+        // The cycle has to follow the settings without any agent changing type
+        Settings.bShouldWander = false;
+        Crowd->SetSettings(Settings);
+        TickWorld(World, Frames);
+        bPassed &= CheckInstances(World, *Crowd, TEXT("Standing"));
+
+        Settings.bShouldWander = true;
+        Crowd->SetSettings(Settings);
+        TickWorld(World, Frames);
+        bPassed &= CheckInstances(World, *Crowd, TEXT("Walking again"));
+
+        Spawner->ClearCrowd();
+        return bPassed;
+    }
+}
+
+UZombieCrowdCheckCommandlet::UZombieCrowdCheckCommandlet()
+{
+    IsClient = false;
+    IsEditor = false;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 UZombieCrowdCheckCommandlet::Main(const FString& Params)
+{
+    // A game world of its own, so the processors run with the same net mode and phases as in a packaged game
+    UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("ZombieCrowdCheck"));
+    FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+    WorldContext.SetCurrentWorld(World);
+    World->InitializeActorsForPlay(FURL());
+    World->BeginPlay();
+
+    const bool bPassed = ZombieCrowdCheck::Run(World, Params);
+
+    GEngine->DestroyWorldContext(World);
+    World->DestroyWorld(false);
+
+    if (!bPassed)
+    {
+        UE_LOG(LogTemp, Error, TEXT("ZombieCrowdCheck: FAILED"));
+        return 1;
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("ZombieCrowdCheck: Passed"));
+    return 0;
+}
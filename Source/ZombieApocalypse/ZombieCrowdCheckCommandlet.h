@@ -0,0 +1,29 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ZombieCrowdCheckCommandlet.generated.h"
+
+/**
+ * Smoke test of the MassEntity crowd that runs without a GPU: spawns an AZombieCrowdSpawner with baked
+ * visuals in a game world, ticks it and checks that every agent has an instance at its location with the
+ * custom data of the cycle it should play, then switches wandering off and on and checks that the
+ * instances switch between idle and walk. Returns non-zero when any check fails.
+ *
+ * Example:
+ *   UnrealEditor-Cmd ZombieApocalypse.uproject -run=ZombieCrowdCheck -nullrhi -Susceptible=200 -Zombies=10
+ *
+ *   -Susceptible=<int>  Susceptible agents to spawn (default 200)
+ *   -Zombies=<int>      Zombies to spawn (default 10)
+ *   -Frames=<int>       Frames ticked before every check (default 10)
+ */
+UCLASS()
+class ZOMBIEAPOCALYPSE_API UZombieCrowdCheckCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UZombieCrowdCheckCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
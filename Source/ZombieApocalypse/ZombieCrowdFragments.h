@@ -0,0 +1,134 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+#include "PopulationMeshActor.h"
+#include "ZombieCrowdFragments.generated.h"
+
+/**
+ * Fragments of a crowd agent, the MassEntity counterpart of APopulationMeshActor.
+ * An agent is a few dozen bytes in a chunk next to the agents of the same type instead of an actor with its
+ * own components and tick, so the processors in ZombieCrowdProcessors.h walk contiguous memory on the
+ * worker threads.
+ */
+
+// Which crowd array the agent is in. Type changes right away, the tags below follow when the commands flush.
+// RegistryIndex is INDEX_NONE once the agent is killed and only waits for its entity to be destroyed.
+USTRUCT()
+struct ZOMBIEAPOCALYPSE_API FZombieCrowdAgentFragment : public FMassFragment {
+
+	GENERATED_BODY()
+
+	EPopulationType Type = EPopulationType::Susceptible;
+
+	// Index in UZombieCrowdSubsystem's array for Type, so moving between arrays is a swap
+	int32 RegistryIndex = INDEX_NONE;
+};
+
+USTRUCT()
+struct ZOMBIEAPOCALYPSE_API FZombieCrowdLocationFragment : public FMassFragment {
+
+	GENERATED_BODY()
+
+	FVector Location = FVector::ZeroVector;
+
+	// Degrees, the agent faces where it walks or the target it teleported to
+	float Yaw = 0.0f;
+};
+
+// APopulationMeshActor's wandering and boundary turning state
+USTRUCT()
+struct ZOMBIEAPOCALYPSE_API FZombieCrowdWanderFragment : public FMassFragment {
+
+	GENERATED_BODY()
+
+	// Degrees
+	float Direction = 0.0f;
+
+	float Timer = 0.0f;
+
+	// Time until the next random direction, drawn from 3 to 7 seconds on every change
+	float NextChange = 5.0f;
+
+	bool bTurningAround = false;
+	float TurnTimer = 0.0f;
+
+	// Per agent, so the parallel processors draw without sharing a generator
+	FRandomStream Random;
+};
+
+USTRUCT()
+struct ZOMBIEAPOCALYPSE_API FZombieCrowdBiteFragment : public FMassFragment {
+
+	GENERATED_BODY()
+
+	// TimeStepsFinished when the agent was bitten, negative until then
+	float BittenTimestamp = -1.0f;
+
+	// Conveyor cohort the bite was counted in, INDEX_NONE until bitten. A bitten agent that dies is taken
+	// out of this cohort, like APopulationMeshActor::OnDeath does.
+	int32 ConveyorCohort = INDEX_NONE;
+};
+
+USTRUCT()
+struct ZOMBIEAPOCALYPSE_API FZombieCrowdTeleportFragment : public FMassFragment {
+
+	GENERATED_BODY()
+
+	float TeleportTimer = 0.0f;
+	float LastBiteTime = 0.0f;
+};
+
+// One tag per EPopulationType, so every chunk holds a single type and a processor only visits the types it handles
+USTRUCT()
+struct ZOMBIEAPOCALYPSE_API FZombieCrowdSusceptibleTag : public FMassTag {
+
+	GENERATED_BODY()
+};
+
+USTRUCT()
+struct ZOMBIEAPOCALYPSE_API FZombieCrowdBittenTag : public FMassTag {
+
+	GENERATED_BODY()
+};
+
+USTRUCT()
+struct ZOMBIEAPOCALYPSE_API FZombieCrowdZombieTag : public FMassTag {
+
+	GENERATED_BODY()
+};
+
+// The behaviour settings of APopulationMeshActor that the crowd uses, shared by every agent
+struct FZombieCrowdSettings {
+
+	float MovementSpeed = 50.0f;
+	bool bShouldWander = true;
+
+	float BiteRange = 100.0f;
+	float BiteCooldown = 2.0f;
+	bool bGuaranteeBites = true;
+
+	float TeleportInterval = 5.0f;
+	float TeleportRange = 150.0f;
+	bool bEnableTeleportation = true;
+
+	FVector BoundaryMin = FVector(-5000.0f, -5000.0f, -1000.0f);
+	FVector BoundaryMax = FVector(5000.0f, 5000.0f, 1000.0f);
+	float BoundaryBuffer = 200.0f;
+
+	float Scale = 1.0f;
+
+	// Takes the settings of an agent class's defaults, the boundaries stay as they are unless it uses custom ones
+	void CopyFrom(const APopulationMeshActor& Agent);
+
+	// Agents that move play the walk cycle, bitten agents and teleporting zombies stand
+	bool IsWalking(EPopulationType Type) const {
+
+		switch (Type) {
+
+		case EPopulationType::Susceptible: return bShouldWander;
+		case EPopulationType::Zombie: return bShouldWander && !bEnableTeleportation;
+		default: return false;
+		}
+	}
+};
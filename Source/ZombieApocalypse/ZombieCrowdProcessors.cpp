@@ -0,0 +1,420 @@
+#include "ZombieCrowdProcessors.h"
+#include "MassExecutionContext.h"
+#include "MassEntityManager.h"
+#include "MassCommandBuffer.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "ZombieCrowdFragments.h"
+#include "ZombieCrowdSubsystem.h"
+#include "ZombieCrowdVisualsAsset.h"
+#include "SimulationController.h"
+
+namespace {
+
+	FVector DirectionFromYaw(float Degrees) {
+
+		const float Radians = FMath::DegreesToRadians(Degrees);
+		return FVector(FMath::Cos(Radians), FMath::Sin(Radians), 0.0f);
+	}
+
+	bool IsWithinBoundaries(const FZombieCrowdSettings& Settings, const FVector& Location) {
+
+		return Location.X >= Settings.BoundaryMin.X && Location.X <= Settings.BoundaryMax.X &&
+			Location.Y >= Settings.BoundaryMin.Y && Location.Y <= Settings.BoundaryMax.Y &&
+			Location.Z >= Settings.BoundaryMin.Z && Location.Z <= Settings.BoundaryMax.Z;
+	}
+
+	bool IsNearBoundary(const FZombieCrowdSettings& Settings, const FVector& Location) {
+
+		return Location.X <= Settings.BoundaryMin.X + Settings.BoundaryBuffer ||
+			Location.X >= Settings.BoundaryMax.X - Settings.BoundaryBuffer ||
+			Location.Y <= Settings.BoundaryMin.Y + Settings.BoundaryBuffer ||
+			Location.Y >= Settings.BoundaryMax.Y - Settings.BoundaryBuffer;
+	}
+
+	// Wandering agents are the susceptible ones, and zombies when they do not teleport
+	bool IsWanderingChunk(const FZombieCrowdSettings& Settings, const FMassExecutionContext& Context) {
+
+		return !(Settings.bEnableTeleportation && Context.DoesArchetypeHaveTag<FZombieCrowdZombieTag>());
+	}
+
+	// Spread over [0, 1) by the golden ratio, stable for as long as the entity lives
+	float GetAnimationPhase(FMassEntityHandle Agent) {
+
+		return static_cast<float>(FMath::Frac(Agent.Index * 0.6180339887498949));
+	}
+
+	UZombieCrowdSubsystem* GetCrowd(const FMassEntityManager& EntityManager) {
+
+		const UWorld* World = EntityManager.GetWorld();
+		return World ? World->GetSubsystem<UZombieCrowdSubsystem>() : nullptr;
+	}
+}
+
+UZombieCrowdBoundaryProcessor::UZombieCrowdBoundaryProcessor()
+	: EntityQuery(*this) {
+
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::AllNetModes);
+}
+
+void UZombieCrowdBoundaryProcessor::ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) {
+
+	EntityQuery.AddRequirement<FZombieCrowdLocationFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FZombieCrowdWanderFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddTagRequirement<FZombieCrowdBittenTag>(EMassFragmentPresence::None);
+}
+
+void UZombieCrowdBoundaryProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) {
+
+	const UZombieCrowdSubsystem* Crowd = GetCrowd(EntityManager);
+	if (!Crowd || !Crowd->GetSettings().bShouldWander)
+		return;
+
+	// A copy, the chunks are processed on the worker threads
+	const FZombieCrowdSettings Settings = Crowd->GetSettings();
+
+	EntityQuery.ParallelForEachEntityChunk(Context, [Settings](FMassExecutionContext& Context) {
+
+		if (!IsWanderingChunk(Settings, Context))
+			return;
+
+		const float DeltaTime = Context.GetDeltaTimeSeconds();
+		const TConstArrayView<FZombieCrowdLocationFragment> Locations = Context.GetFragmentView<FZombieCrowdLocationFragment>();
+		const TArrayView<FZombieCrowdWanderFragment> Wanders = Context.GetMutableFragmentView<FZombieCrowdWanderFragment>();
+
+		for (int32 i = 0; i < Context.GetNumEntities(); ++i) {
+
+			FZombieCrowdWanderFragment& Wander = Wanders[i];
+
+			// Turn for 1 second
+			if (Wander.bTurningAround) {
+
+				Wander.TurnTimer += DeltaTime;
+				if (Wander.TurnTimer >= 1.0f) {
+
+					Wander.bTurningAround = false;
+					Wander.TurnTimer = 0.0f;
+				}
+			}
+
+			if (Wander.bTurningAround || !IsNearBoundary(Settings, Locations[i].Location))
+				continue;
+
+			// Away from every boundary that is within the buffer, or straight back
+			const FVector& Location = Locations[i].Location;
+			FVector Avoidance = FVector::ZeroVector;
+			Avoidance.X += Location.X <= Settings.BoundaryMin.X + Settings.BoundaryBuffer ? 1.0f : 0.0f;
+			Avoidance.X -= Location.X >= Settings.BoundaryMax.X - Settings.BoundaryBuffer ? 1.0f : 0.0f;
+			Avoidance.Y += Location.Y <= Settings.BoundaryMin.Y + Settings.BoundaryBuffer ? 1.0f : 0.0f;
+			Avoidance.Y -= Location.Y >= Settings.BoundaryMax.Y - Settings.BoundaryBuffer ? 1.0f : 0.0f;
+			if (Avoidance.IsNearlyZero()) {
+
+				Avoidance = -DirectionFromYaw(Wander.Direction);
+			}
+
+			Wander.Direction = FMath::RadiansToDegrees(FMath::Atan2(Avoidance.Y, Avoidance.X));
+			Wander.bTurningAround = true;
+			Wander.TurnTimer = 0.0f;
+			Wander.Timer = 0.0f;
+		}
+	});
+}
+
+UZombieCrowdWanderProcessor::UZombieCrowdWanderProcessor()
+	: EntityQuery(*this) {
+
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::AllNetModes);
+	ExecutionOrder.ExecuteAfter.Add(UZombieCrowdBoundaryProcessor::StaticClass()->GetFName());
+}
+
+void UZombieCrowdWanderProcessor::ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) {
+
+	EntityQuery.AddRequirement<FZombieCrowdAgentFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FZombieCrowdLocationFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FZombieCrowdWanderFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddTagRequirement<FZombieCrowdBittenTag>(EMassFragmentPresence::None);
+}
+
+void UZombieCrowdWanderProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) {
+
+	const UZombieCrowdSubsystem* Crowd = GetCrowd(EntityManager);
+	if (!Crowd || !Crowd->GetSettings().bShouldWander)
+		return;
+
+	const FZombieCrowdSettings Settings = Crowd->GetSettings();
+
+	EntityQuery.ParallelForEachEntityChunk(Context, [Settings](FMassExecutionContext& Context) {
+
+		if (!IsWanderingChunk(Settings, Context))
+			return;
+
+		const float DeltaTime = Context.GetDeltaTimeSeconds();
+		const TConstArrayView<FZombieCrowdAgentFragment> Agents = Context.GetFragmentView<FZombieCrowdAgentFragment>();
+		const TArrayView<FZombieCrowdLocationFragment> Locations = Context.GetMutableFragmentView<FZombieCrowdLocationFragment>();
+		const TArrayView<FZombieCrowdWanderFragment> Wanders = Context.GetMutableFragmentView<FZombieCrowdWanderFragment>();
+
+		for (int32 i = 0; i < Context.GetNumEntities(); ++i) {
+
+			// Bitten this frame, the tag follows when the commands flush
+			if (Agents[i].Type == EPopulationType::Bitten)
+				continue;
+
+			FZombieCrowdWanderFragment& Wander = Wanders[i];
+			FZombieCrowdLocationFragment& Location = Locations[i];
+
+			Wander.Timer += DeltaTime;
+			if (!Wander.bTurningAround && Wander.Timer >= Wander.NextChange) {
+
+				Wander.Direction = Wander.Random.FRandRange(0.0f, 360.0f);
+				Wander.NextChange = Wander.Random.FRandRange(3.0f, 7.0f);
+				Wander.Timer = 0.0f;
+			}
+
+			const FVector Direction = DirectionFromYaw(Wander.Direction);
+			const FVector Desired = Location.Location + Direction * Settings.MovementSpeed * DeltaTime;
+			const FVector Clamped = Desired.BoundToBox(Settings.BoundaryMin, Settings.BoundaryMax);
+
+			// Hit a boundary, force a direction change
+			if (!Clamped.Equals(Desired, 10.0f)) {
+
+				Wander.Direction = Wander.Random.FRandRange(0.0f, 360.0f);
+				Wander.bTurningAround = true;
+				Wander.TurnTimer = 0.0f;
+			}
+
+			Location.Location = Clamped;
+			Location.Yaw = FMath::RadiansToDegrees(FMath::Atan2(Direction.Y, Direction.X));
+		}
+	});
+}
+
+UZombieCrowdTeleportBiteProcessor::UZombieCrowdTeleportBiteProcessor()
+	: EntityQuery(*this) {
+
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::AllNetModes);
+	ExecutionOrder.ExecuteAfter.Add(UZombieCrowdWanderProcessor::StaticClass()->GetFName());
+
+	// Bites read the simulation controller and write the target's fragments and the crowd arrays
+	bRequiresGameThreadExecution = true;
+}
+
+void UZombieCrowdTeleportBiteProcessor::ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) {
+
+	EntityQuery.AddRequirement<FZombieCrowdLocationFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FZombieCrowdTeleportFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddTagRequirement<FZombieCrowdZombieTag>(EMassFragmentPresence::All);
+}
+
+void UZombieCrowdTeleportBiteProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) {
+
+	UZombieCrowdSubsystem* Crowd = GetCrowd(EntityManager);
+	if (!Crowd || !Crowd->GetSettings().bEnableTeleportation || Crowd->GetCount(EPopulationType::Zombie) == 0)
+		return;
+
+	const FZombieCrowdSettings& Settings = Crowd->GetSettings();
+
+	EntityQuery.ForEachEntityChunk(Context, [&](FMassExecutionContext& Context) {
+
+		const float DeltaTime = Context.GetDeltaTimeSeconds();
+		const TArrayView<FZombieCrowdLocationFragment> Locations = Context.GetMutableFragmentView<FZombieCrowdLocationFragment>();
+		const TArrayView<FZombieCrowdTeleportFragment> Teleports = Context.GetMutableFragmentView<FZombieCrowdTeleportFragment>();
+
+		for (int32 i = 0; i < Context.GetNumEntities(); ++i) {
+
+			FZombieCrowdTeleportFragment& Teleport = Teleports[i];
+			Teleport.TeleportTimer += DeltaTime;
+			Teleport.LastBiteTime += DeltaTime;
+			if (Teleport.TeleportTimer < Settings.TeleportInterval)
+				continue;
+
+			Teleport.TeleportTimer = 0.0f;
+
+			const FMassEntityHandle Target = Crowd->GetRandom(EPopulationType::Susceptible);
+			if (!Target.IsSet())
+				continue;
+
+			const FVector TargetLocation = EntityManager.GetFragmentDataChecked<FZombieCrowdLocationFragment>(Target).Location;
+
+			// A random position near the target, within the boundaries
+			const FVector Offset = DirectionFromYaw(FMath::RandRange(0.0f, 360.0f)) * FMath::RandRange(Settings.BiteRange * 0.5f, Settings.TeleportRange);
+			FVector TeleportLocation = (TargetLocation + Offset).BoundToBox(Settings.BoundaryMin, Settings.BoundaryMax);
+			if (FVector::Dist2D(TeleportLocation, TargetLocation) > Settings.TeleportRange) {
+
+				// Clamped too far away, try 8 directions at bite range before standing on the target
+				TeleportLocation = TargetLocation.BoundToBox(Settings.BoundaryMin, Settings.BoundaryMax);
+				for (int32 Attempt = 0; Attempt < 8; ++Attempt) {
+
+					const FVector TestLocation = TargetLocation + DirectionFromYaw(45.0f * Attempt) * Settings.BiteRange;
+					if (IsWithinBoundaries(Settings, TestLocation)) {
+
+						TeleportLocation = TestLocation;
+						break;
+					}
+				}
+			}
+
+			FZombieCrowdLocationFragment& Location = Locations[i];
+			Location.Location = TeleportLocation;
+			const FVector ToTarget = TargetLocation - TeleportLocation;
+			if (!ToTarget.IsNearlyZero()) {
+
+				Location.Yaw = FMath::RadiansToDegrees(FMath::Atan2(ToTarget.Y, ToTarget.X));
+			}
+
+			// Guaranteed bites skip the cooldown and distance checks
+			if (Settings.bGuaranteeBites || (Teleport.LastBiteTime >= Settings.BiteCooldown && FVector::Dist2D(TeleportLocation, TargetLocation) <= Settings.BiteRange)) {
+
+				Crowd->Bite(EntityManager, Context.Defer(), Target);
+				Teleport.LastBiteTime = 0.0f;
+			}
+		}
+	});
+}
+
+UZombieCrowdTransformationProcessor::UZombieCrowdTransformationProcessor()
+	: EntityQuery(*this) {
+
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::AllNetModes);
+	ExecutionOrder.ExecuteAfter.Add(UZombieCrowdTeleportBiteProcessor::StaticClass()->GetFName());
+	bRequiresGameThreadExecution = true;
+}
+
+void UZombieCrowdTransformationProcessor::ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) {
+
+	EntityQuery.AddRequirement<FZombieCrowdAgentFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FZombieCrowdBiteFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FZombieCrowdTeleportFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddTagRequirement<FZombieCrowdBittenTag>(EMassFragmentPresence::All);
+}
+
+void UZombieCrowdTransformationProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) {
+
+	UZombieCrowdSubsystem* Crowd = GetCrowd(EntityManager);
+	const ASimulationController* SimulationController = Crowd ? Crowd->GetSimulationController() : nullptr;
+	if (!SimulationController)
+		return;
+
+	// Days only pass when a step finishes
+	const int32 Step = SimulationController->TimeStepsFinished;
+	if (Step == Crowd->LastTransformationStep)
+		return;
+
+	Crowd->LastTransformationStep = Step;
+	if (Crowd->GetCount(EPopulationType::Bitten) == 0)
+		return;
+
+	// Read every step, so the crowd turns on the same transit time the model uses
+	const float TransformationDays = SimulationController->days_to_become_infected_from_bite;
+
+	EntityQuery.ForEachEntityChunk(Context, [&](FMassExecutionContext& Context) {
+
+		const TConstArrayView<FZombieCrowdBiteFragment> Bites = Context.GetFragmentView<FZombieCrowdBiteFragment>();
+
+		for (int32 i = 0; i < Context.GetNumEntities(); ++i) {
+
+			if (Bites[i].BittenTimestamp >= 0.0f && Step - Bites[i].BittenTimestamp >= TransformationDays) {
+
+				Crowd->Transform(EntityManager, Context.Defer(), Context.GetEntity(i));
+			}
+		}
+	});
+}
+
+UZombieCrowdRepresentationProcessor::UZombieCrowdRepresentationProcessor()
+	: EntityQuery(*this) {
+
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::Standalone | EProcessorExecutionFlags::Client);
+	ExecutionOrder.ExecuteAfter.Add(UZombieCrowdTransformationProcessor::StaticClass()->GetFName());
+
+	// Components are only touched on the game thread
+	bRequiresGameThreadExecution = true;
+}
+
+void UZombieCrowdRepresentationProcessor::ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) {
+
+	EntityQuery.AddRequirement<FZombieCrowdAgentFragment>(EMassFragmentAccess::ReadOnly);
+	EntityQuery.AddRequirement<FZombieCrowdLocationFragment>(EMassFragmentAccess::ReadOnly);
+}
+
+void UZombieCrowdRepresentationProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) {
+
+	UZombieCrowdSubsystem* Crowd = GetCrowd(EntityManager);
+	if (!Crowd)
+		return;
+
+	const FVector Scale(Crowd->GetSettings().Scale);
+	for (int32 Type = 0; Type < UE_ARRAY_COUNT(Transforms); ++Type) {
+
+		Transforms[Type].Reset();
+		Agents[Type].Reset();
+	}
+
+	// Sorted by the type the agent has now, an agent bitten this frame shows as bitten before its tag moves it
+	EntityQuery.ForEachEntityChunk(Context, [&](FMassExecutionContext& Context) {
+
+		const TConstArrayView<FZombieCrowdAgentFragment> AgentFragments = Context.GetFragmentView<FZombieCrowdAgentFragment>();
+		const TConstArrayView<FZombieCrowdLocationFragment> Locations = Context.GetFragmentView<FZombieCrowdLocationFragment>();
+
+		for (int32 i = 0; i < Context.GetNumEntities(); ++i) {
+
+			const int32 Type = static_cast<int32>(AgentFragments[i].Type);
+			Transforms[Type].Emplace(FRotator(0.0f, Locations[i].Yaw, 0.0f), Locations[i].Location, Scale);
+			Agents[Type].Add(Context.GetEntity(i));
+		}
+	});
+
+	const UZombieCrowdVisualsAsset* Visuals = Crowd->GetVisuals();
+
+	for (int32 Type = 0; Type < UE_ARRAY_COUNT(Transforms); ++Type) {
+
+		UInstancedStaticMeshComponent* Instances = Crowd->GetRepresentation(static_cast<EPopulationType>(Type));
+		if (!Instances)
+			continue;
+
+		// Moving agents only update the transforms, the instances are rebuilt when the number of a type changes
+		const bool bRebuild = Instances->GetInstanceCount() != Transforms[Type].Num();
+		if (!bRebuild) {
+
+			if (Transforms[Type].Num() > 0) {
+
+				Instances->BatchUpdateInstancesTransforms(0, Transforms[Type], true, true, false);
+			}
+		}
+
+		else {
+
+			Instances->ClearInstances();
+			Instances->AddInstances(Transforms[Type], false, true, false);
+		}
+
+		// Every agent of a type plays the same cycle, so custom data only changes where another agent took
+		// over an instance, which is everywhere after a rebuild or when the type switches between walk and idle
+		if (Visuals && Instances->NumCustomDataFloats == UZombieCrowdVisualsAsset::NumCustomDataFloats) {
+
+			const EPopulationType PopulationType = static_cast<EPopulationType>(Type);
+			const FZombieCrowdTypeVisuals& TypeVisuals = Visuals->Get(PopulationType);
+			const FZombieCrowdAnimation& Animation = Crowd->GetSettings().IsWalking(PopulationType) ? TypeVisuals.Walk : TypeVisuals.Idle;
+
+			const bool bRewriteAll = bRebuild || Animation != WrittenAnimation[Type];
+			WrittenAnimation[Type] = Animation;
+
+			bool bChanged = false;
+			float CustomData[UZombieCrowdVisualsAsset::NumCustomDataFloats];
+			for (int32 i = 0; i < Agents[Type].Num(); ++i) {
+
+				if (!bRewriteAll && PreviousAgents[Type].IsValidIndex(i) && PreviousAgents[Type][i] == Agents[Type][i])
+					continue;
+
+				UZombieCrowdVisualsAsset::WriteCustomData(Animation, GetAnimationPhase(Agents[Type][i]), PopulationType, CustomData);
+				Instances->SetCustomData(i, MakeArrayView(CustomData, UZombieCrowdVisualsAsset::NumCustomDataFloats), false);
+				bChanged = true;
+			}
+
+			if (bChanged) {
+
+				Instances->MarkRenderStateDirty();
+			}
+		}
+
+		Swap(PreviousAgents[Type], Agents[Type]);
+	}
+}
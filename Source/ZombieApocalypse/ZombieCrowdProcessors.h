@@ -0,0 +1,108 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassProcessor.h"
+#include "MassEntityQuery.h"
+#include "ZombieCrowdVisualsAsset.h"
+#include "ZombieCrowdProcessors.generated.h"
+
+/**
+ * Processors of the crowd, in the order they run every frame. Movement runs chunk by chunk across the worker
+ * threads; bites, transformations and the instanced meshes touch the simulation controller, other agents and
+ * components, so those run on the game thread, each over only the chunks of the type it handles.
+ */
+
+// Steers wandering agents away from the boundaries
+UCLASS()
+class ZOMBIEAPOCALYPSE_API UZombieCrowdBoundaryProcessor : public UMassProcessor {
+
+	GENERATED_BODY()
+
+public:
+	UZombieCrowdBoundaryProcessor();
+
+protected:
+	virtual void ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+};
+
+// Susceptible agents, and zombies when teleportation is off, walk in a random direction that changes every few seconds
+UCLASS()
+class ZOMBIEAPOCALYPSE_API UZombieCrowdWanderProcessor : public UMassProcessor {
+
+	GENERATED_BODY()
+
+public:
+	UZombieCrowdWanderProcessor();
+
+protected:
+	virtual void ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+};
+
+// Zombies teleport next to a random susceptible agent every TeleportInterval and bite it
+UCLASS()
+class ZOMBIEAPOCALYPSE_API UZombieCrowdTeleportBiteProcessor : public UMassProcessor {
+
+	GENERATED_BODY()
+
+public:
+	UZombieCrowdTeleportBiteProcessor();
+
+protected:
+	virtual void ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+};
+
+// Bitten agents turn days_to_become_infected_from_bite of the simulation controller after the bite, checked once per finished step
+UCLASS()
+class ZOMBIEAPOCALYPSE_API UZombieCrowdTransformationProcessor : public UMassProcessor {
+
+	GENERATED_BODY()
+
+public:
+	UZombieCrowdTransformationProcessor();
+
+protected:
+	virtual void ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+};
+
+// Writes every agent into the instanced mesh of its type, with the animation custom data when the crowd has baked visuals
+UCLASS()
+class ZOMBIEAPOCALYPSE_API UZombieCrowdRepresentationProcessor : public UMassProcessor {
+
+	GENERATED_BODY()
+
+public:
+	UZombieCrowdRepresentationProcessor();
+
+protected:
+	virtual void ConfigureQueries(const TSharedRef<FMassEntityManager>& EntityManager) override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+
+	// Kept between frames so the buffers are only allocated while the crowd grows
+	TArray<FTransform> Transforms[3];
+
+	// The agent behind every instance this frame and the last, custom data is only written where they differ
+	TArray<FMassEntityHandle> Agents[3];
+	TArray<FMassEntityHandle> PreviousAgents[3];
+
+	// Cycle last written into every instance of a type, all of them are rewritten when it changes
+	FZombieCrowdAnimation WrittenAnimation[3];
+};
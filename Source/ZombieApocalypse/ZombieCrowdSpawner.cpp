@@ -0,0 +1,130 @@
+#include "ZombieCrowdSpawner.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "ZombieCrowdSubsystem.h"
+#include "ZombieCrowdVisualsAsset.h"
+
+// Sets default values
+AZombieCrowdSpawner::AZombieCrowdSpawner() {
+
+	// The processors move the agents, nothing to do per frame here
+	PrimaryActorTick.bCanEverTick = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+	SusceptibleInstances = CreateInstances(TEXT("SusceptibleInstances"));
+	BittenInstances = CreateInstances(TEXT("BittenInstances"));
+	ZombieInstances = CreateInstances(TEXT("ZombieInstances"));
+
+	AgentClass = APopulationMeshActor::StaticClass();
+}
+
+UInstancedStaticMeshComponent* AZombieCrowdSpawner::CreateInstances(const TCHAR* Name) {
+
+	UInstancedStaticMeshComponent* Instances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(Name);
+	Instances->SetupAttachment(RootComponent);
+
+	// Tens of thousands of instances move every frame, collision and navigation would rebuild with them
+	Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Instances->SetCanEverAffectNavigation(false);
+	Instances->SetMobility(EComponentMobility::Movable);
+	return Instances;
+}
+
+// Called when the game starts or when spawned
+void AZombieCrowdSpawner::BeginPlay() {
+
+	Super::BeginPlay();
+
+	if (bAutoSpawnOnBeginPlay) {
+
+		SpawnCrowd();
+	}
+}
+
+void AZombieCrowdSpawner::EndPlay(const EEndPlayReason::Type EndPlayReason) {
+
+	ClearCrowd();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AZombieCrowdSpawner::SpawnCrowd() {
+
+	UZombieCrowdSubsystem* Crowd = GetWorld() ? GetWorld()->GetSubsystem<UZombieCrowdSubsystem>() : nullptr;
+	if (!Crowd) {
+
+		UE_LOG(LogTemp, Error, TEXT("ZombieCrowdSpawner: No crowd subsystem in this world!"));
+		return;
+	}
+
+	if (!AgentClass) {
+
+		UE_LOG(LogTemp, Error, TEXT("ZombieCrowdSpawner: No AgentClass set!"));
+		return;
+	}
+
+	ClearCrowd();
+
+	const APopulationMeshActor* AgentDefaults = AgentClass->GetDefaultObject<APopulationMeshActor>();
+
+	FZombieCrowdSettings Settings;
+	Settings.BoundaryMin = GetActorLocation() - SpawnExtent;
+	Settings.BoundaryMax = GetActorLocation() + SpawnExtent;
+	Settings.CopyFrom(*AgentDefaults);
+	Crowd->SetSettings(Settings);
+
+	SetupInstances(SusceptibleInstances, EPopulationType::Susceptible, SusceptibleMesh ? SusceptibleMesh : AgentDefaults->BaseMesh);
+	SetupInstances(BittenInstances, EPopulationType::Bitten, BittenMesh ? BittenMesh : AgentDefaults->BaseMesh);
+	SetupInstances(ZombieInstances, EPopulationType::Zombie, ZombieMesh ? ZombieMesh : AgentDefaults->BaseMesh);
+	Crowd->SetVisuals(Visuals);
+	Crowd->SetRepresentation(EPopulationType::Susceptible, SusceptibleInstances);
+	Crowd->SetRepresentation(EPopulationType::Bitten, BittenInstances);
+	Crowd->SetRepresentation(EPopulationType::Zombie, ZombieInstances);
+
+	SpawnType(Crowd, EPopulationType::Susceptible, NumberOfSusceptible);
+	SpawnType(Crowd, EPopulationType::Zombie, NumberOfZombies);
+
+	UE_LOG(LogTemp, Warning, TEXT("ZombieCrowdSpawner: Spawned %d susceptible and %d zombies"), NumberOfSusceptible, NumberOfZombies);
+}
+
+void AZombieCrowdSpawner::ClearCrowd() {
+
+	if (UZombieCrowdSubsystem* Crowd = GetWorld() ? GetWorld()->GetSubsystem<UZombieCrowdSubsystem>() : nullptr) {
+
+		Crowd->DestroyAllAgents();
+	}
+}
+
+void AZombieCrowdSpawner::SetupInstances(UInstancedStaticMeshComponent* Instances, EPopulationType Type, UStaticMesh* Mesh) const {
+
+	Instances->ClearInstances();
+
+	// The baked mesh's material reads the animation from the instance's custom data
+	if (Visuals && Visuals->Get(Type).Mesh) {
+
+		Instances->SetStaticMesh(Visuals->Get(Type).Mesh);
+		Instances->SetNumCustomDataFloats(UZombieCrowdVisualsAsset::NumCustomDataFloats);
+	}
+
+	else {
+
+		Instances->SetStaticMesh(Mesh);
+		Instances->SetNumCustomDataFloats(0);
+	}
+}
+
+void AZombieCrowdSpawner::SpawnType(UZombieCrowdSubsystem* Crowd, EPopulationType Type, int32 Count) const {
+
+	const FZombieCrowdSettings& Settings = Crowd->GetSettings();
+
+	TArray<FVector> Locations;
+	Locations.Reserve(Count);
+	for (int32 i = 0; i < Count; ++i) {
+
+		Locations.Emplace(
+			FMath::RandRange(Settings.BoundaryMin.X, Settings.BoundaryMax.X),
+			FMath::RandRange(Settings.BoundaryMin.Y, Settings.BoundaryMax.Y),
+			FMath::Clamp(GetActorLocation().Z, Settings.BoundaryMin.Z, Settings.BoundaryMax.Z));
+	}
+
+	Crowd->SpawnAgents(Type, Locations);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "PopulationMeshActor.h"
+#include "ZombieCrowdSpawner.generated.h"
+
+class UInstancedStaticMeshComponent;
+class UZombieCrowdVisualsAsset;
+
+/**
+ * Spawns the MassEntity crowd instead of one APopulationMeshActor per citizen. The agents behave like
+ * AgentClass's defaults and are drawn with one instanced static mesh per EPopulationType, animated by
+ * vertex animation textures when Visuals is set.
+ */
+UCLASS()
+class ZOMBIEAPOCALYPSE_API AZombieCrowdSpawner : public AActor {
+
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	AZombieCrowdSpawner();
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Spawner", meta = (ClampMin = "0", ClampMax = "100000"))
+	int32 NumberOfSusceptible = 1000;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Spawner", meta = (ClampMin = "0", ClampMax = "100000"))
+	int32 NumberOfZombies = 1;
+
+	// Agents spawn at random within this distance of the spawner, which is also their boundary unless
+	// AgentClass uses custom boundaries
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Spawner")
+	FVector SpawnExtent = FVector(5000.0f, 5000.0f, 1000.0f);
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Spawner")
+	bool bAutoSpawnOnBeginPlay = true;
+
+	// Movement, bite and teleport settings come from this class's defaults
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Spawner")
+	TSubclassOf<APopulationMeshActor> AgentClass;
+
+	// Baked walk and idle cycles, its meshes replace the ones below
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mesh Assets")
+	UZombieCrowdVisualsAsset* Visuals;
+
+	// Per type meshes without baked animation, any left empty use AgentClass's BaseMesh
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mesh Assets")
+	UStaticMesh* SusceptibleMesh;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mesh Assets")
+	UStaticMesh* BittenMesh;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Mesh Assets")
+	UStaticMesh* ZombieMesh;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components)
+	UInstancedStaticMeshComponent* SusceptibleInstances;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components)
+	UInstancedStaticMeshComponent* BittenInstances;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components)
+	UInstancedStaticMeshComponent* ZombieInstances;
+
+	UFUNCTION(CallInEditor, BlueprintCallable, Category = "Spawner")
+	void SpawnCrowd();
+
+	UFUNCTION(CallInEditor, BlueprintCallable, Category = "Spawner")
+	void ClearCrowd();
+
+private:
+	UInstancedStaticMeshComponent* CreateInstances(const TCHAR* Name);
+	void SetupInstances(UInstancedStaticMeshComponent* Instances, EPopulationType Type, UStaticMesh* Mesh) const;
+	void SpawnType(class UZombieCrowdSubsystem* Crowd, EPopulationType Type, int32 Count) const;
+};
@@ -0,0 +1,239 @@
+#include "ZombieCrowdSubsystem.h"
+#include "MassEntitySubsystem.h"
+#include "MassEntityManager.h"
+#include "MassCommandBuffer.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "PopulationRegistry.h"
+#include "SimulationController.h"
+
+void FZombieCrowdSettings::CopyFrom(const APopulationMeshActor& Agent) {
+
+	MovementSpeed = Agent.MovementSpeed;
+	bShouldWander = Agent.bShouldWander;
+	BiteRange = Agent.BiteRange;
+	BiteCooldown = Agent.BiteCooldown;
+	bGuaranteeBites = Agent.bGuaranteeBites;
+	TeleportInterval = Agent.TeleportInterval;
+	TeleportRange = Agent.TeleportRange;
+	bEnableTeleportation = Agent.bEnableTeleportation;
+	BoundaryBuffer = Agent.BoundaryBuffer;
+	Scale = Agent.ScaleMultiplier;
+
+	if (Agent.bUseCustomBoundaries) {
+
+		BoundaryMin = Agent.CustomBoundaryMin;
+		BoundaryMax = Agent.CustomBoundaryMax;
+	}
+}
+
+void UZombieCrowdSubsystem::Deinitialize() {
+
+	// The entity manager goes away with the world, only the handles are left to drop
+	for (TArray<FMassEntityHandle>& TypeAgents : Agents) {
+
+		TypeAgents.Empty();
+	}
+
+	Super::Deinitialize();
+}
+
+void UZombieCrowdSubsystem::SpawnAgents(EPopulationType Type, TConstArrayView<FVector> Locations) {
+
+	UMassEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>();
+	if (!EntitySubsystem || Locations.Num() == 0)
+		return;
+
+	FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
+
+	TArray<const UScriptStruct*> Composition = {
+		FZombieCrowdAgentFragment::StaticStruct(),
+		FZombieCrowdLocationFragment::StaticStruct(),
+		FZombieCrowdWanderFragment::StaticStruct(),
+		FZombieCrowdBiteFragment::StaticStruct(),
+		FZombieCrowdTeleportFragment::StaticStruct()
+	};
+
+	switch (Type) {
+
+	case EPopulationType::Susceptible: Composition.Add(FZombieCrowdSusceptibleTag::StaticStruct()); break;
+	case EPopulationType::Bitten: Composition.Add(FZombieCrowdBittenTag::StaticStruct()); break;
+	case EPopulationType::Zombie: Composition.Add(FZombieCrowdZombieTag::StaticStruct()); break;
+	}
+
+	const FMassArchetypeHandle Archetype = EntityManager.CreateArchetype(Composition);
+
+	TArray<FMassEntityHandle> NewAgents;
+	{
+		// Observers run when the creation context goes away, after the fragments are filled in
+		TSharedRef<FMassEntityManager::FEntityCreationContext> CreationContext = EntityManager.BatchCreateEntities(Archetype, Locations.Num(), NewAgents);
+
+		TArray<FMassEntityHandle>& TypeAgents = Agents[static_cast<int32>(Type)];
+		TypeAgents.Reserve(TypeAgents.Num() + NewAgents.Num());
+
+		for (int32 i = 0; i < NewAgents.Num(); ++i) {
+
+			const FMassEntityHandle Agent = NewAgents[i];
+
+			FZombieCrowdAgentFragment& AgentFragment = EntityManager.GetFragmentDataChecked<FZombieCrowdAgentFragment>(Agent);
+			AgentFragment.Type = Type;
+			AgentFragment.RegistryIndex = TypeAgents.Add(Agent);
+
+			FZombieCrowdWanderFragment& Wander = EntityManager.GetFragmentDataChecked<FZombieCrowdWanderFragment>(Agent);
+			Wander.Random.Initialize(FMath::Rand());
+			Wander.Direction = Wander.Random.FRandRange(0.0f, 360.0f);
+			Wander.NextChange = Wander.Random.FRandRange(3.0f, 7.0f);
+
+			FZombieCrowdLocationFragment& Location = EntityManager.GetFragmentDataChecked<FZombieCrowdLocationFragment>(Agent);
+			Location.Location = Locations[i];
+			Location.Yaw = Wander.Direction;
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("ZombieCrowdSubsystem: Spawned %d agents of type %d, %d in total"), NewAgents.Num(), static_cast<int32>(Type), GetTotalCount());
+}
+
+void UZombieCrowdSubsystem::DestroyAllAgents() {
+
+	UMassEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>();
+	for (TArray<FMassEntityHandle>& TypeAgents : Agents) {
+
+		if (EntitySubsystem) {
+
+			EntitySubsystem->GetMutableEntityManager().BatchDestroyEntities(TypeAgents);
+		}
+		TypeAgents.Reset();
+	}
+
+	for (UInstancedStaticMeshComponent* Instances : Representation) {
+
+		if (Instances) {
+
+			Instances->ClearInstances();
+		}
+	}
+}
+
+void UZombieCrowdSubsystem::SetRepresentation(EPopulationType Type, UInstancedStaticMeshComponent* Instances) {
+
+	Representation[static_cast<int32>(Type)] = Instances;
+}
+
+int32 UZombieCrowdSubsystem::GetTotalCount() const {
+
+	int32 Total = 0;
+	for (const TArray<FMassEntityHandle>& TypeAgents : Agents) {
+
+		Total += TypeAgents.Num();
+	}
+	return Total;
+}
+
+FMassEntityHandle UZombieCrowdSubsystem::GetRandom(EPopulationType Type) const {
+
+	const TArray<FMassEntityHandle>& TypeAgents = Agents[static_cast<int32>(Type)];
+	return TypeAgents.Num() > 0 ? TypeAgents[FMath::RandRange(0, TypeAgents.Num() - 1)] : FMassEntityHandle();
+}
+
+void UZombieCrowdSubsystem::Bite(FMassEntityManager& EntityManager, FMassCommandBuffer& Commands, FMassEntityHandle Target) {
+
+	FZombieCrowdAgentFragment& AgentFragment = EntityManager.GetFragmentDataChecked<FZombieCrowdAgentFragment>(Target);
+	if (AgentFragment.Type != EPopulationType::Susceptible || AgentFragment.RegistryIndex == INDEX_NONE)
+		return;
+
+	FZombieCrowdBiteFragment& BiteFragment = EntityManager.GetFragmentDataChecked<FZombieCrowdBiteFragment>(Target);
+	if (ASimulationController* SimulationController = GetSimulationController()) {
+
+		BiteFragment.BittenTimestamp = static_cast<float>(SimulationController->TimeStepsFinished);
+		BiteFragment.ConveyorCohort = SimulationController->GetIncomingConveyorCohort();
+	}
+
+	else {
+
+		BiteFragment.BittenTimestamp = 0.0f;
+	}
+
+	MoveToType(EntityManager, Target, AgentFragment, EPopulationType::Bitten);
+	Commands.SwapTags<FZombieCrowdSusceptibleTag, FZombieCrowdBittenTag>(Target);
+}
+
+void UZombieCrowdSubsystem::Transform(FMassEntityManager& EntityManager, FMassCommandBuffer& Commands, FMassEntityHandle Agent) {
+
+	FZombieCrowdAgentFragment& AgentFragment = EntityManager.GetFragmentDataChecked<FZombieCrowdAgentFragment>(Agent);
+	if (AgentFragment.Type != EPopulationType::Bitten || AgentFragment.RegistryIndex == INDEX_NONE)
+		return;
+
+	EntityManager.GetFragmentDataChecked<FZombieCrowdTeleportFragment>(Agent).TeleportTimer = 0.0f;
+
+	MoveToType(EntityManager, Agent, AgentFragment, EPopulationType::Zombie);
+	Commands.SwapTags<FZombieCrowdBittenTag, FZombieCrowdZombieTag>(Agent);
+}
+
+void UZombieCrowdSubsystem::Kill(FMassEntityManager& EntityManager, FMassCommandBuffer& Commands, FMassEntityHandle Agent) {
+
+	FZombieCrowdAgentFragment& AgentFragment = EntityManager.GetFragmentDataChecked<FZombieCrowdAgentFragment>(Agent);
+	if (AgentFragment.RegistryIndex == INDEX_NONE)
+		return;
+
+	// Queued for the start of the next step instead of changing the stocks under the model, at the death site
+	// so the spatial grid takes the person from the cell they died in
+	if (ASimulationController* SimulationController = GetSimulationController()) {
+
+		const FVector DeathSite = EntityManager.GetFragmentDataChecked<FZombieCrowdLocationFragment>(Agent).Location;
+		switch (AgentFragment.Type) {
+
+		case EPopulationType::Susceptible:
+			SimulationController->EnqueueStockDelta({ EZombieStock::Susceptible, -1.f, INDEX_NONE, DeathSite });
+			break;
+		case EPopulationType::Bitten:
+			SimulationController->EnqueueStockDelta({ EZombieStock::Bitten, -1.f, EntityManager.GetFragmentDataChecked<FZombieCrowdBiteFragment>(Agent).ConveyorCohort, DeathSite });
+			break;
+		case EPopulationType::Zombie:
+			SimulationController->EnqueueStockDelta({ EZombieStock::Zombies, -1.f, INDEX_NONE, DeathSite });
+			break;
+		}
+	}
+
+	RemoveFromType(EntityManager, AgentFragment);
+	Commands.DestroyEntity(Agent);
+}
+
+void UZombieCrowdSubsystem::KillAgent(FMassEntityHandle Agent) {
+
+	UMassEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>();
+	if (!EntitySubsystem)
+		return;
+
+	FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
+	if (EntityManager.IsEntityValid(Agent)) {
+
+		Kill(EntityManager, EntityManager.Defer(), Agent);
+	}
+}
+
+void UZombieCrowdSubsystem::MoveToType(FMassEntityManager& EntityManager, FMassEntityHandle Agent, FZombieCrowdAgentFragment& AgentFragment, EPopulationType NewType) {
+
+	RemoveFromType(EntityManager, AgentFragment);
+
+	AgentFragment.Type = NewType;
+	AgentFragment.RegistryIndex = Agents[static_cast<int32>(NewType)].Add(Agent);
+}
+
+void UZombieCrowdSubsystem::RemoveFromType(FMassEntityManager& EntityManager, FZombieCrowdAgentFragment& AgentFragment) {
+
+	TArray<FMassEntityHandle>& OldAgents = Agents[static_cast<int32>(AgentFragment.Type)];
+	const int32 Index = AgentFragment.RegistryIndex;
+
+	OldAgents.RemoveAtSwap(Index, EAllowShrinking::No);
+	if (Index < OldAgents.Num()) {
+
+		EntityManager.GetFragmentDataChecked<FZombieCrowdAgentFragment>(OldAgents[Index]).RegistryIndex = Index;
+	}
+
+	AgentFragment.RegistryIndex = INDEX_NONE;
+}
+
+ASimulationController* UZombieCrowdSubsystem::GetSimulationController() const {
+
+	UPopulationRegistry* Registry = GetWorld()->GetSubsystem<UPopulationRegistry>();
+	return Registry ? Registry->GetSimulationController() : nullptr;
+}
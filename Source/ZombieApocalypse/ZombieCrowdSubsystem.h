@@ -0,0 +1,89 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MassEntityTypes.h"
+#include "ZombieCrowdFragments.h"
+#include "ZombieCrowdSubsystem.generated.h"
+
+struct FMassEntityManager;
+struct FMassCommandBuffer;
+class UInstancedStaticMeshComponent;
+class ASimulationController;
+class UZombieCrowdVisualsAsset;
+
+/**
+ * The crowd of a world: spawns agents as MassEntity entities, keeps one dense array of entity handles per
+ * EPopulationType for counts and random picks, and holds the settings and instanced meshes the processors use.
+ * Population changes go through here on the game thread, the tags of the entity follow through the command
+ * buffer of the processor that made the change.
+ */
+UCLASS()
+class ZOMBIEAPOCALYPSE_API UZombieCrowdSubsystem : public UWorldSubsystem {
+
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Creates an agent of a type at every location
+	void SpawnAgents(EPopulationType Type, TConstArrayView<FVector> Locations);
+
+	void DestroyAllAgents();
+
+	void SetSettings(const FZombieCrowdSettings& NewSettings) { Settings = NewSettings; }
+	const FZombieCrowdSettings& GetSettings() const { return Settings; }
+
+	// Instanced meshes the representation processor writes every type into. nullptr hides a type.
+	void SetRepresentation(EPopulationType Type, UInstancedStaticMeshComponent* Instances);
+	UInstancedStaticMeshComponent* GetRepresentation(EPopulationType Type) const { return Representation[static_cast<int32>(Type)]; }
+
+	// Baked animation the representation writes into the instances' custom data, nullptr for static meshes
+	void SetVisuals(UZombieCrowdVisualsAsset* NewVisuals) { Visuals = NewVisuals; }
+	const UZombieCrowdVisualsAsset* GetVisuals() const { return Visuals; }
+
+	UFUNCTION(BlueprintCallable, Category = "Crowd")
+	int32 GetCount(EPopulationType Type) const { return Agents[static_cast<int32>(Type)].Num(); }
+
+	int32 GetTotalCount() const;
+
+	// Every agent of a type, in no particular order
+	TConstArrayView<FMassEntityHandle> GetAgents(EPopulationType Type) const { return Agents[static_cast<int32>(Type)]; }
+
+	// Uniformly random agent of a type, an unset handle if there is none
+	FMassEntityHandle GetRandom(EPopulationType Type) const;
+
+	// Bites a susceptible agent: it moves to the bitten array now and swaps its tag when Commands flush
+	void Bite(FMassEntityManager& EntityManager, FMassCommandBuffer& Commands, FMassEntityHandle Target);
+
+	// Turns a bitten agent
+	void Transform(FMassEntityManager& EntityManager, FMassCommandBuffer& Commands, FMassEntityHandle Agent);
+
+	// Kills an agent like APopulationMeshActor::OnDeath: its stock loses one person at the next step, taken from
+	// the conveyor cohort of its bite if it was bitten, and the entity is destroyed when Commands flush
+	void Kill(FMassEntityManager& EntityManager, FMassCommandBuffer& Commands, FMassEntityHandle Agent);
+
+	// Kill for gameplay code outside the processors, the entity is destroyed with the entity manager's deferred commands
+	void KillAgent(FMassEntityHandle Agent);
+
+	ASimulationController* GetSimulationController() const;
+
+	// TimeStepsFinished the transformation processor last checked the bitten agents at
+	int32 LastTransformationStep = INDEX_NONE;
+
+private:
+	static constexpr int32 NumTypes = 3;
+
+	TArray<FMassEntityHandle> Agents[NumTypes];
+
+	UPROPERTY()
+	UInstancedStaticMeshComponent* Representation[NumTypes] = {};
+
+	UPROPERTY()
+	UZombieCrowdVisualsAsset* Visuals = nullptr;
+
+	FZombieCrowdSettings Settings;
+
+	void MoveToType(FMassEntityManager& EntityManager, FMassEntityHandle Agent, FZombieCrowdAgentFragment& AgentFragment, EPopulationType NewType);
+	void RemoveFromType(FMassEntityManager& EntityManager, FZombieCrowdAgentFragment& AgentFragment);
+};
@@ -0,0 +1,20 @@
+#include "ZombieCrowdVisualsAsset.h"
+
+const FZombieCrowdTypeVisuals& UZombieCrowdVisualsAsset::Get(EPopulationType Type) const {
+
+	switch (Type) {
+
+	case EPopulationType::Bitten: return Bitten;
+	case EPopulationType::Zombie: return Zombie;
+	default: return Susceptible;
+	}
+}
+
+void UZombieCrowdVisualsAsset::WriteCustomData(const FZombieCrowdAnimation& Animation, float Phase, EPopulationType Type, float* OutCustomData) {
+
+	OutCustomData[0] = static_cast<float>(Animation.StartFrame);
+	OutCustomData[1] = static_cast<float>(FMath::Max(Animation.NumFrames, 1));
+	OutCustomData[2] = Animation.FramesPerSecond;
+	OutCustomData[3] = Phase;
+	OutCustomData[4] = static_cast<float>(Type);
+}
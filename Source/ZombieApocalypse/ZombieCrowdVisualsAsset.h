@@ -0,0 +1,80 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Engine/StaticMesh.h"
+#include "PopulationMeshActor.h"
+#include "ZombieCrowdVisualsAsset.generated.h"
+
+// A cycle in a vertex animation texture, rows StartFrame to StartFrame + NumFrames - 1
+USTRUCT(BlueprintType)
+struct ZOMBIEAPOCALYPSE_API FZombieCrowdAnimation {
+
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Animation", meta = (ClampMin = "0"))
+	int32 StartFrame = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Animation", meta = (ClampMin = "1"))
+	int32 NumFrames = 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Animation", meta = (ClampMin = "0"))
+	float FramesPerSecond = 30.0f;
+
+	bool operator==(const FZombieCrowdAnimation& Other) const {
+
+		return StartFrame == Other.StartFrame && NumFrames == Other.NumFrames && FramesPerSecond == Other.FramesPerSecond;
+	}
+};
+
+USTRUCT(BlueprintType)
+struct ZOMBIEAPOCALYPSE_API FZombieCrowdTypeVisuals {
+
+	GENERATED_BODY()
+
+	// Static mesh baked from the skeletal mesh, with a material that plays the vertex animation texture
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Mesh Assets")
+	UStaticMesh* Mesh = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Animation")
+	FZombieCrowdAnimation Idle;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Animation")
+	FZombieCrowdAnimation Walk;
+};
+
+/**
+ * Baked crowd visuals, one instanced static mesh per EPopulationType instead of a skeletal mesh and anim
+ * instance per agent. The walk and idle cycles of Girl, Girl2 and Zombie are baked into vertex animation
+ * textures with the AnimToTexture plugin by the ZombieCrowdBake commandlet (ZombieApocalypseEditor module),
+ * which also builds the material and fills in this asset.
+ *
+ * Every instance carries NumCustomDataFloats of custom primitive data, which the material reads to play its
+ * own cycle without any per agent animation on the CPU:
+ *   0 StartFrame, 1 NumFrames, 2 FramesPerSecond of the cycle the agent is in
+ *   3 Phase in [0, 1), so agents of a type do not step in lockstep
+ *   4 EPopulationType
+ * The frame shown is StartFrame + floor(frac(Time * FramesPerSecond / NumFrames + Phase) * NumFrames).
+ */
+UCLASS(BlueprintType)
+class ZOMBIEAPOCALYPSE_API UZombieCrowdVisualsAsset : public UDataAsset {
+
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	FZombieCrowdTypeVisuals Susceptible;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	FZombieCrowdTypeVisuals Bitten;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	FZombieCrowdTypeVisuals Zombie;
+
+	static constexpr int32 NumCustomDataFloats = 5;
+
+	const FZombieCrowdTypeVisuals& Get(EPopulationType Type) const;
+
+	// The custom data of one instance
+	static void WriteCustomData(const FZombieCrowdAnimation& Animation, float Phase, EPopulationType Type, float* OutCustomData);
+};
@@ -0,0 +1,77 @@
+#include "ZombieCurveAsset.h"
+#include "Misc/Paths.h"
+#include "Serialization/CustomVersion.h"
+
+namespace
+{
+    struct FZombieCurveAssetVersion
+    {
+        enum Type
+        {
+            // CookedData without a version in its header
+            BeforeCustomVersion = 0,
+            VersionedCookedData = 1,
+
+            LatestVersion = VersionedCookedData
+        };
+
+        static const FGuid GUID;
+    };
+
+    const FGuid FZombieCurveAssetVersion::GUID(0x5A0C3E71, 0x2B9D4F86, 0x9E1A7C43, 0xD8F26B15);
+    FCustomVersionRegistration GRegisterZombieCurveAssetVersion(FZombieCurveAssetVersion::GUID, FZombieCurveAssetVersion::LatestVersion, TEXT("ZombieCurveAsset"));
+}
+
+TSharedPtr<FZombieGraph> UZombieCurveAsset::MakeGraph() const
+{
+    TSharedPtr<FZombieGraph> Graph = MakeShared<FZombieGraph>();
+    if (!Graph->ReadCooked(CookedData))
+    {
+        UE_LOG(LogTemp, Error, TEXT("ZombieCurveAsset: %s has no cooked curve, rebuild it from its source file"), *GetPathName());
+        return nullptr;
+    }
+    return Graph;
+}
+
+TSharedPtr<FZombieGraph> UZombieCurveAsset::ReadSourceFile() const
+{
+    TSharedPtr<FZombieGraph> Graph = MakeShared<FZombieGraph>();
+    if (!Graph->ReadFromCsvFile(GetSourceFilePath()))
+        return nullptr;
+
+    if (BakeResolution > 0)
+        Graph->Bake(BakeResolution);
+    return Graph;
+}
+
+FString UZombieCurveAsset::GetSourceFilePath() const
+{
+    return FPaths::ConvertRelativePathToFull(FPaths::ProjectDir(), SourceFile.FilePath);
+}
+
+#if WITH_EDITOR
+void UZombieCurveAsset::RebuildFromSource()
+{
+    const TSharedPtr<FZombieGraph> Graph = ReadSourceFile();
+    if (!Graph)
+        return;
+
+    Modify();
+    Graph->WriteCooked(CookedData);
+    UE_LOG(LogTemp, Log, TEXT("ZombieCurveAsset: %s rebuilt with %d points from %s"),
+        *GetPathName(), static_cast<int32>(Graph->graphPts.size()), *SourceFile.FilePath);
+}
+#endif
+
+void UZombieCurveAsset::Serialize(FArchive& Ar)
+{
+    Super::Serialize(Ar);
+    Ar.UsingCustomVersion(FZombieCurveAssetVersion::GUID);
+    CookedData.BulkSerialize(Ar);
+
+    // Older layouts are not read at all, MakeGraph then asks for a rebuild from the source file
+    if (Ar.IsLoading() && Ar.CustomVer(FZombieCurveAssetVersion::GUID) < FZombieCurveAssetVersion::VersionedCookedData)
+    {
+        CookedData.Reset();
+    }
+}
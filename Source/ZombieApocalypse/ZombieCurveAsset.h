@@ -0,0 +1,49 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "ZombieModel.h"
+#include "ZombieCurveAsset.generated.h"
+
+/**
+ * The population density effect curve, cooked. Holds the points and the baked lookup table as one flat
+ * float array that is bulk serialized, so loading the asset is a single read and building the graph a
+ * copy, instead of walking DataTable rows and baking at BeginPlay.
+ * Rebuild it from the CSV in the editor with Rebuild From Source.
+ */
+UCLASS(BlueprintType)
+class ZOMBIEAPOCALYPSE_API UZombieCurveAsset : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	// CSV in the PopulationDensityEffect.csv layout, relative to the project directory. Development builds
+	// watch it and reload the curve while the game runs, see ASimulationController::bHotReloadCurve.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Curve", meta = (FilePathFilter = "csv"))
+	FFilePath SourceFile{ TEXT("PopulationDensityEffect.csv") };
+
+	// Intervals used when the points are not evenly spaced and have to be resampled, 0 keeps the curve unbaked
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Curve", meta = (ClampMin = "0"))
+	int32 BakeResolution{ 256 };
+
+	// Builds the graph from the cooked data. Returns nullptr and logs if the asset has not been built.
+	TSharedPtr<FZombieGraph> MakeGraph() const;
+
+	// Reads SourceFile and bakes it the way this asset does, without touching the asset
+	TSharedPtr<FZombieGraph> ReadSourceFile() const;
+
+	// Full path of SourceFile
+	FString GetSourceFilePath() const;
+
+#if WITH_EDITOR
+	// Reads SourceFile again and replaces the cooked data
+	UFUNCTION(CallInEditor, Category = "Curve")
+	void RebuildFromSource();
+#endif
+
+	virtual void Serialize(FArchive& Ar) override;
+
+private:
+	// See FZombieGraph::WriteCooked
+	TArray<float> CookedData;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Forward-mode dual number: a value plus its derivative with respect to N inputs.
+// Stepping the model over TZombieDual instead of float gives the trajectory and
+// all N derivatives of it in a single pass.
+template<int32 N>
+struct TZombieDual
+{
+	float Value{ 0.f };
+	float Partials[N]{};
+
+	TZombieDual() = default;
+
+	// Constants have no derivatives, so plain floats convert implicitly
+	TZombieDual(float InValue) : Value(InValue) {}
+
+	// The input with derivative 1 in column Index
+	static TZombieDual Seed(float InValue, int32 Index)
+	{
+		TZombieDual Result(InValue);
+		if (Index >= 0 && Index < N)
+			Result.Partials[Index] = 1.f;
+		return Result;
+	}
+
+	TZombieDual& operator+=(const TZombieDual& B) { return *this = *this + B; }
+	TZombieDual& operator-=(const TZombieDual& B) { return *this = *this - B; }
+
+	friend TZombieDual operator+(const TZombieDual& A, const TZombieDual& B)
+	{
+		TZombieDual Result(A.Value + B.Value);
+		for (int32 i = 0; i < N; ++i)
+			Result.Partials[i] = A.Partials[i] + B.Partials[i];
+		return Result;
+	}
+
+	friend TZombieDual operator-(const TZombieDual& A, const TZombieDual& B)
+	{
+		TZombieDual Result(A.Value - B.Value);
+		for (int32 i = 0; i < N; ++i)
+			Result.Partials[i] = A.Partials[i] - B.Partials[i];
+		return Result;
+	}
+
+	friend TZombieDual operator*(const TZombieDual& A, const TZombieDual& B)
+	{
+		TZombieDual Result(A.Value * B.Value);
+		for (int32 i = 0; i < N; ++i)
+			Result.Partials[i] = A.Partials[i] * B.Value + B.Partials[i] * A.Value;
+		return Result;
+	}
+
+	friend TZombieDual operator/(const TZombieDual& A, const TZombieDual& B)
+	{
+		TZombieDual Result(A.Value / B.Value);
+		for (int32 i = 0; i < N; ++i)
+			Result.Partials[i] = (A.Partials[i] - Result.Value * B.Partials[i]) / B.Value;
+		return Result;
+	}
+
+	friend bool operator<(const TZombieDual& A, const TZombieDual& B) { return A.Value < B.Value; }
+	friend bool operator<=(const TZombieDual& A, const TZombieDual& B) { return A.Value <= B.Value; }
+	friend bool operator>(const TZombieDual& A, const TZombieDual& B) { return A.Value > B.Value; }
+	friend bool operator>=(const TZombieDual& A, const TZombieDual& B) { return A.Value >= B.Value; }
+};
+
+// The handful of FMath functions the model uses, for float and for TZombieDual.
+// The float versions are FMath itself, so templated code stepped with float is unchanged.
+namespace ZombieMath
+{
+	inline float Max(float A, float B) { return FMath::Max(A, B); }
+	inline float Min(float A, float B) { return FMath::Min(A, B); }
+	inline float RoundToFloat(float A) { return FMath::RoundToFloat(A); }
+	inline float Floor(float A) { return FMath::Floor(A); }
+	inline float Value(float A) { return A; }
+
+	// Same tie-breaking as FMath: the derivative follows the branch that is picked
+	template<int32 N>
+	TZombieDual<N> Max(const TZombieDual<N>& A, const TZombieDual<N>& B) { return A.Value >= B.Value ? A : B; }
+
+	template<int32 N>
+	TZombieDual<N> Min(const TZombieDual<N>& A, const TZombieDual<N>& B) { return A.Value <= B.Value ? A : B; }
+
+	// Rounding is flat almost everywhere, which would zero every derivative behind a rounded
+	// number of bites. The derivative is passed straight through instead, i.e. treated as the
+	// unrounded value, which is what a finite difference over a large enough step sees.
+	template<int32 N>
+	TZombieDual<N> RoundToFloat(const TZombieDual<N>& A)
+	{
+		TZombieDual<N> Result = A;
+		Result.Value = FMath::RoundToFloat(A.Value);
+		return Result;
+	}
+
+	template<int32 N>
+	TZombieDual<N> Floor(const TZombieDual<N>& A)
+	{
+		TZombieDual<N> Result = A;
+		Result.Value = FMath::Floor(A.Value);
+		return Result;
+	}
+
+	template<int32 N>
+	float Value(const TZombieDual<N>& A) { return A.Value; }
+}
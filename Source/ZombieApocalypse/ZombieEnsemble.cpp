@@ -0,0 +1,155 @@
+#include "ZombieEnsemble.h"
+#include "Async/ParallelFor.h"
+
+void FZombieDayHistogram::Init(int32 InDays, float MaxValue, float InBinWidth, int32 MaxBins)
+{
+    Days = FMath::Max(InDays, 0);
+    MaxValue = FMath::Max(MaxValue, 0.f);
+    BinWidth = FMath::Max(InBinWidth, UE_KINDA_SMALL_NUMBER);
+
+    // Compared in double, a tiny width over a large population does not fit in an int32
+    MaxBins = FMath::Max(MaxBins, 2);
+    if (static_cast<double>(MaxValue) / BinWidth + 1.0 > MaxBins)
+    {
+        NumBins = MaxBins;
+        BinWidth = MaxValue / (MaxBins - 1);
+    }
+    else
+    {
+        NumBins = FMath::RoundToInt(MaxValue / BinWidth) + 1;
+    }
+
+    Counts.Reset();
+    Counts.SetNumZeroed(static_cast<int64>(Days) * NumBins);
+}
+
+void FZombieDayHistogram::Add(int32 Day, float Value)
+{
+    const int32 Bin = FMath::Clamp(FMath::RoundToInt(Value / BinWidth), 0, NumBins - 1);
+    Counts[static_cast<int64>(Day) * NumBins + Bin]++;
+}
+
+void FZombieDayHistogram::Merge(const FZombieDayHistogram& Other)
+{
+    check(Other.Counts.Num() == Counts.Num());
+    for (int64 i = 0; i < Counts.Num(); ++i)
+    {
+        Counts[i] += Other.Counts[i];
+    }
+}
+
+float FZombieDayHistogram::Quantile(int32 Day, float Q) const
+{
+    const uint32* DayCounts = &Counts[static_cast<int64>(Day) * NumBins];
+
+    uint64 Total = 0;
+    for (int32 Bin = 0; Bin < NumBins; ++Bin)
+        Total += DayCounts[Bin];
+    if (Total == 0)
+        return 0.f;
+
+    // Nearest rank
+    const uint64 Rank = FMath::Max<uint64>(1, static_cast<uint64>(FMath::CeilToDouble(FMath::Clamp(Q, 0.f, 1.f) * static_cast<double>(Total))));
+    uint64 Cumulative = 0;
+    for (int32 Bin = 0; Bin < NumBins; ++Bin)
+    {
+        Cumulative += DayCounts[Bin];
+        if (Cumulative >= Rank)
+            return Bin * BinWidth;
+    }
+    return (NumBins - 1) * BinWidth;
+}
+
+FZombieEnsembleResult ZombieEnsemble::Run(const FZombieModel& Model, const FZombieEnsembleSettings& Settings)
+{
+    // Everything one worker thread accumulates into, merged at the end
+    struct FPartial
+    {
+        FZombieDayHistogram Susceptible;
+        FZombieDayHistogram Bitten;
+        FZombieDayHistogram Zombies;
+        TArray<uint32> LostByDay;
+        TArray<uint32> WonByDay;
+    };
+
+    const int32 NumRuns = FMath::Max(Settings.NumRuns, 0);
+    const int32 Days = FMath::Max(Settings.Days, 0);
+
+    // Nobody is created or lost, but a conversion rate above 1 can make more zombies than people
+    const float People = Model.State.Susceptible + Model.State.Bitten;
+    const float MaxValue = Model.State.Zombies + People * FMath::Max(1.f, Model.Params.CONVERSION_FROM_PEOPLE_TO_ZOMBIES);
+
+    // One partial per task ParallelFor starts, which is bounded by the worker threads whatever NumRuns is.
+    // The runs are seeded by index and the counts only add up, so the split does not change the result.
+    TArray<FPartial> Partials;
+    ParallelForWithTaskContext(TEXT("ZombieEnsemble"), Partials, NumRuns,
+        [&](int32 /*ContextIndex*/, int32 /*NumContexts*/)
+        {
+            FPartial Partial;
+            Partial.Susceptible.Init(Days, MaxValue, Settings.BinWidth, Settings.MaxBins);
+            Partial.Bitten.Init(Days, MaxValue, Settings.BinWidth, Settings.MaxBins);
+            Partial.Zombies.Init(Days, MaxValue, Settings.BinWidth, Settings.MaxBins);
+            Partial.LostByDay.SetNumZeroed(Days);
+            Partial.WonByDay.SetNumZeroed(Days);
+            return Partial;
+        },
+        [&](FPartial& Partial, int32 RunIndex)
+        {
+            FRandomStream Stream(static_cast<int32>(HashCombine(static_cast<uint32>(Settings.Seed), static_cast<uint32>(RunIndex))));
+            FZombieModel Member = Model;
+
+            // The histograms are per day and the draws are per day of bites
+            Member.Params.IntegrationMethod = EZombieIntegrationMethod::Euler;
+            Member.Params.DT = 1.f;
+            bool bLost = false;
+            bool bWon = false;
+
+            for (int32 Day = 0; Day < Days; ++Day)
+            {
+                const FZombieStepOutcome Outcome = Member.RunStochasticStep(Stream);
+                bLost |= Outcome.bLose;
+                bWon |= Outcome.bWin;
+
+                Partial.Susceptible.Add(Day, Member.State.Susceptible);
+                Partial.Bitten.Add(Day, Member.State.Bitten);
+                Partial.Zombies.Add(Day, Member.State.Zombies);
+                Partial.LostByDay[Day] += bLost ? 1 : 0;
+                Partial.WonByDay[Day] += bWon ? 1 : 0;
+            }
+        });
+
+    FZombieEnsembleResult Result;
+    Result.NumRuns = NumRuns;
+    Result.Days = Days;
+    if (Partials.Num() == 0)
+    {
+        // No runs, empty histograms of the right shape
+        Result.Susceptible.Init(Days, MaxValue, Settings.BinWidth, Settings.MaxBins);
+        Result.Bitten.Init(Days, MaxValue, Settings.BinWidth, Settings.MaxBins);
+        Result.Zombies.Init(Days, MaxValue, Settings.BinWidth, Settings.MaxBins);
+        Result.LostByDay.SetNumZeroed(Days);
+        Result.WonByDay.SetNumZeroed(Days);
+        return Result;
+    }
+
+    Result.Susceptible = MoveTemp(Partials[0].Susceptible);
+    Result.Bitten = MoveTemp(Partials[0].Bitten);
+    Result.Zombies = MoveTemp(Partials[0].Zombies);
+    Result.LostByDay = MoveTemp(Partials[0].LostByDay);
+    Result.WonByDay = MoveTemp(Partials[0].WonByDay);
+
+    for (int32 PartialIndex = 1; PartialIndex < Partials.Num(); ++PartialIndex)
+    {
+        const FPartial& Partial = Partials[PartialIndex];
+        Result.Susceptible.Merge(Partial.Susceptible);
+        Result.Bitten.Merge(Partial.Bitten);
+        Result.Zombies.Merge(Partial.Zombies);
+        for (int32 Day = 0; Day < Days; ++Day)
+        {
+            Result.LostByDay[Day] += Partial.LostByDay[Day];
+            Result.WonByDay[Day] += Partial.WonByDay[Day];
+        }
+    }
+
+    return Result;
+}
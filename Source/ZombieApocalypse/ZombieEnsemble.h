@@ -0,0 +1,70 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZombieModel.h"
+
+// How many runs each day falls into each value bin, for one stock. Bins are BinWidth wide and centred on
+// multiples of it, so whole-person stocks with a width of 1 are counted exactly. Two histograms merge by
+// adding their counts, which lets every worker fill its own and keeps memory independent of the run count.
+struct ZOMBIEAPOCALYPSE_API FZombieDayHistogram
+{
+	// At most MaxBins bins per day; when MaxValue needs more, the bins are widened to cover it with MaxBins
+	void Init(int32 InDays, float MaxValue, float InBinWidth, int32 MaxBins);
+
+	// Values above the last bin are counted in it
+	void Add(int32 Day, float Value);
+	void Merge(const FZombieDayHistogram& Other);
+
+	// Value below which a fraction Q (0..1) of the runs fall on Day, to the nearest bin
+	float Quantile(int32 Day, float Q) const;
+
+	int32 GetNumBins() const { return NumBins; }
+	float GetBinWidth() const { return BinWidth; }
+
+private:
+	int32 Days{ 0 };
+	int32 NumBins{ 0 };
+	float BinWidth{ 1.f };
+
+	// [Day * NumBins + Bin]
+	TArray64<uint32> Counts;
+};
+
+struct FZombieEnsembleSettings
+{
+	int32 NumRuns{ 1000 };
+	int32 Days{ 180 };
+
+	// Run i draws from a stream seeded with HashCombine(Seed, i), so results do not depend on threading
+	int32 Seed{ 0 };
+
+	// Width of the histogram bins in people, widened when the population needs more than MaxBins of them
+	float BinWidth{ 1.f };
+	int32 MaxBins{ 512 };
+};
+
+struct FZombieEnsembleResult
+{
+	int32 NumRuns{ 0 };
+	int32 Days{ 0 };
+
+	// Stocks after each day across all runs
+	FZombieDayHistogram Susceptible;
+	FZombieDayHistogram Bitten;
+	FZombieDayHistogram Zombies;
+
+	// Runs in which Lose/Win had triggered by the end of each day
+	TArray<uint32> LostByDay;
+	TArray<uint32> WonByDay;
+
+	float GetLoseProbability(int32 Day) const { return NumRuns > 0 ? static_cast<float>(LostByDay[Day]) / NumRuns : 0.f; }
+	float GetWinProbability(int32 Day) const { return NumRuns > 0 ? static_cast<float>(WonByDay[Day]) / NumRuns : 0.f; }
+};
+
+namespace ZombieEnsemble
+{
+	// Runs NumRuns stochastic copies of Model (see FZombieModel::RunStochasticStep) across the worker threads.
+	// The copies step Euler over one day whatever the integration settings of Model are. Every worker thread
+	// fills one set of histograms, so memory is bounded by the thread count, Days and MaxBins.
+	ZOMBIEAPOCALYPSE_API FZombieEnsembleResult Run(const FZombieModel& Model, const FZombieEnsembleSettings& Settings);
+}
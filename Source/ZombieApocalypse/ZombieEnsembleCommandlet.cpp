@@ -0,0 +1,60 @@
+#include "ZombieEnsembleCommandlet.h"
+#include "ZombieCommandletHelpers.h"
+#include "ZombieEnsemble.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformTime.h"
+
+UZombieEnsembleCommandlet::UZombieEnsembleCommandlet()
+{
+    IsClient = false;
+    IsEditor = false;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 UZombieEnsembleCommandlet::Main(const FString& Params)
+{
+    FZombieModel BaseModel;
+    if (!ZombieCommandlets::LoadBaseModel(Params, BaseModel))
+        return 1;
+
+    FZombieEnsembleSettings Settings;
+    FParse::Value(*Params, TEXT("Runs="), Settings.NumRuns);
+    FParse::Value(*Params, TEXT("Days="), Settings.Days);
+    FParse::Value(*Params, TEXT("Seed="), Settings.Seed);
+    FParse::Value(*Params, TEXT("BinWidth="), Settings.BinWidth);
+    FParse::Value(*Params, TEXT("MaxBins="), Settings.MaxBins);
+
+    const double StartTime = FPlatformTime::Seconds();
+    const FZombieEnsembleResult Result = ZombieEnsemble::Run(BaseModel, Settings);
+    const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+    FString Csv(TEXT("---,Day"));
+    for (const TCHAR* Stock : { TEXT("Susceptible"), TEXT("Bitten"), TEXT("Zombies") })
+        Csv += FString::Printf(TEXT(",%s_P5,%s_P50,%s_P95"), Stock, Stock, Stock);
+    Csv += TEXT(",LoseProbability,WinProbability\n");
+
+    for (int32 Day = 0; Day < Result.Days; ++Day)
+    {
+        Csv += FString::Printf(TEXT("%d, %d"), Day + 1, BaseModel.State.TimeStepsFinished + Day + 1);
+        for (const FZombieDayHistogram* Stock : { &Result.Susceptible, &Result.Bitten, &Result.Zombies })
+        {
+            Csv += FString::Printf(TEXT(", %.3f, %.3f, %.3f"), Stock->Quantile(Day, 0.05f), Stock->Quantile(Day, 0.5f), Stock->Quantile(Day, 0.95f));
+        }
+        Csv += FString::Printf(TEXT(", %.4f, %.4f\n"), Result.GetLoseProbability(Day), Result.GetWinProbability(Day));
+    }
+
+    FString OutPath = FPaths::ProjectSavedDir() / TEXT("ZombieEnsemble.csv");
+    FParse::Value(*Params, TEXT("Out="), OutPath);
+
+    if (!FFileHelper::SaveStringToFile(Csv, *OutPath))
+    {
+        UE_LOG(LogTemp, Error, TEXT("ZombieEnsemble: Could not write %s"), *OutPath);
+        return 1;
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("ZombieEnsemble: %d runs of %d days in %.2f s, bins %.3g people wide, wrote %s"),
+        Result.NumRuns, Result.Days, Elapsed, Result.Zombies.GetBinWidth(), *OutPath);
+    return 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ZombieEnsembleCommandlet.generated.h"
+
+/**
+ * Runs a Monte-Carlo ensemble of the stochastic model and writes the P5/P50/P95 of every stock
+ * and the probability of having lost or won, one CSV row per day.
+ *
+ * Example:
+ *   UnrealEditor-Cmd ZombieApocalypse.uproject -run=ZombieEnsemble -Runs=10000 -Days=180 -Seed=1 -Out=Saved/ZombieEnsemble.csv
+ *
+ * -BinWidth=<people> coarsens the histograms (default 1, exact for whole people). Populations that would need more
+ * than -MaxBins=<count> bins (default 512) get wider bins instead, so memory stays bounded.
+ * Takes the same -Controller, -Curve and -Table options as ZombieSweep.
+ */
+UCLASS()
+class ZOMBIEAPOCALYPSE_API UZombieEnsembleCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UZombieEnsembleCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -11,8 +11,8 @@
 // Sets default values
 AZombieGirlActor::AZombieGirlActor() {
 
-	// Set this actor to call Tick() every frame
-	PrimaryActorTick.bCanEverTick = true;
+	// Updated by the registry like every other population actor
+	PrimaryActorTick.bCanEverTick = false;
 
 	// Set default population type to Bitten (closest to zombie representation)
 	PopulationType = EPopulationType::Bitten;
@@ -50,25 +50,6 @@ void AZombieGirlActor::BeginPlay() {
 	SetupZombieComponents();
 }
 
-// Called every frame
-void AZombieGirlActor::Tick(float DeltaTime) {
-
-	Super::Tick(DeltaTime);
-
-	// Handle zombie-specific updates
-	if (SimulationController) {
-
-		float CurrentZombieCount = GetZombiePopulation();
-
-		// Update zombie representation when population changes
-		if (CurrentZombieCount != PreviousZombieCount) {
-
-			UpdateZombieMesh();
-			PreviousZombieCount = CurrentZombieCount;
-		}
-	}
-}
-
 void AZombieGirlActor::SetupZombieComponents() {
 
 	// Configure zombie mesh
@@ -117,14 +98,6 @@ void AZombieGirlActor::UpdateZombieMesh() {
 	}
 }
 
-float AZombieGirlActor::GetZombiePopulation() const {
-
-	if (!SimulationController)
-		return 0.0f;
-
-	return SimulationController->Zombies;
-}
-
 // inherits boundary functionality from PopulationMeshActor
 bool AZombieGirlActor::ZombieIsWithinBoundaries(const FVector& Location) const {
 	// Delegate to parent class boundary checking
@@ -21,9 +21,6 @@ protected:
 	virtual void BeginPlay() override;
 
 public:
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
 	// Visual effects
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Visual Effects")
 	bool bEnableZombieEffects = true;
@@ -46,11 +43,7 @@ protected:
 
 private:
 	void UpdateZombieMesh();
-	float GetZombiePopulation() const;
 	void SetupZombieComponents();
-
-	// Zombie-specific tracking
-	float PreviousZombieCount = 0.0f;
 	
 	// Teleportation tracking
 	float TeleportTimer = 5.0f;
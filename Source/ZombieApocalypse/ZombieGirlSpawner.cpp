@@ -123,7 +123,7 @@ void AZombieGirlSpawner::ConfigureSpawnedZombie(AZombieGirlActor* SpawnedZombie)
 	if (!SpawnedZombie) return;
 
 	// Set population type to Zombie
-	SpawnedZombie->PopulationType = EPopulationType::Zombie;
+	SpawnedZombie->SetPopulationType(EPopulationType::Zombie);
 
 	// Assign the mesh assets
 	SpawnedZombie->ZombieMesh = ZombieMesh;
@@ -0,0 +1,321 @@
+#include "ZombieGridModel.h"
+
+void FZombieGridModel::Initialize(int32 InSizeX, int32 InSizeY)
+{
+    SizeX = FMath::Max(1, InSizeX);
+    SizeY = FMath::Max(1, InSizeY);
+    const size_t NumCells = static_cast<size_t>(GetNumCells());
+
+    Susceptible.assign(NumCells, 0.f);
+    Bitten.assign(NumCells, 0.f);
+    Zombies.assign(NumCells, 0.f);
+
+    DensityRatio.assign(NumCells, 0.f);
+    DensityEffect.assign(NumCells, 0.f);
+    MigrationScratch.assign(NumCells, 0.f);
+
+    ConveyorSlots.clear();
+    TransitSteps = 0;
+    ConveyorCursor = 0;
+    TimeStepsFinished = 0;
+    SetTransitTime(Params.days_to_become_infected_from_bite);
+
+    RecomputeTotals();
+}
+
+FZombieStepOutcome FZombieGridModel::RunSimulationStep(FZombieModelAuxiliaries* OutAuxiliaries)
+{
+    const int32 NumCells = GetNumCells();
+    const float CellLandArea = Params.land_area / NumCells;
+    const float CellBittenCapacity = Params.Bitten_capacity / NumCells;
+    const float MinDenominator = bRoundToWholePeople ? 1.f : UE_SMALL_NUMBER;
+
+    float* RESTRICT S = Susceptible.data();
+    float* RESTRICT B = Bitten.data();
+    float* RESTRICT Z = Zombies.data();
+    float* RESTRICT Ratio = DensityRatio.data();
+    float* RESTRICT Effect = DensityEffect.data();
+
+    // Calculate auxiliaries
+    for (int32 i = 0; i < NumCells; ++i)
+    {
+        Ratio[i] = (B[i] + S[i]) / CellLandArea / Params.normal_population_density;
+    }
+
+    if (Graph)
+        Graph->graph_lookup_batch(Ratio, Effect, NumCells);
+    else
+        std::fill(DensityEffect.begin(), DensityEffect.end(), 1.f);
+
+    // Conveyor mechanics
+    SetTransitTime(Params.days_to_become_infected_from_bite);
+    float* RESTRICT Plane = GetConveyorPlane(ConveyorCursor);
+
+    float TotalGettingBitten = 0.f;
+    float TotalBecomingInfected = 0.f;
+    float WeightedBitesPerZombie = 0.f;
+    for (int32 i = 0; i < NumCells; ++i)
+    {
+        const float non_zombie_population = B[i] + S[i];
+        const float number_of_bites_per_zombie_per_day = Params.normal_number_of_bites * Effect[i];
+
+        float total_bitten_per_day = Z[i] * number_of_bites_per_zombie_per_day;
+        if (bRoundToWholePeople)
+            total_bitten_per_day = FMath::RoundToFloat(total_bitten_per_day);
+
+        float number_of_bites_from_total_zombies_on_susceptible = (S[i] / FMath::Max(non_zombie_population, MinDenominator)) * total_bitten_per_day;
+        if (bRoundToWholePeople)
+            number_of_bites_from_total_zombies_on_susceptible = FMath::RoundToFloat(number_of_bites_from_total_zombies_on_susceptible);
+
+        // Enforce non-negative susceptible
+        const float getting_bitten = FMath::Min(number_of_bites_from_total_zombies_on_susceptible, bRoundToWholePeople ? FMath::Floor(S[i]) : S[i]);
+
+        // The plane arriving this step is also the one the new inflow goes into
+        const float raw_outflow_people = Plane[i];
+        const float current_content = B[i] - raw_outflow_people;
+        const float free_cap = FMath::Max(0.f, CellBittenCapacity - current_content);
+        const float inflow_people = FMath::Max(0.f, FMath::Min(getting_bitten, free_cap));
+        Plane[i] = inflow_people;
+
+        const float becoming_infected = raw_outflow_people * Params.CONVERSION_FROM_PEOPLE_TO_ZOMBIES;
+
+        WeightedBitesPerZombie += Z[i] * number_of_bites_per_zombie_per_day;
+        TotalGettingBitten += getting_bitten;
+        TotalBecomingInfected += becoming_infected;
+
+        // Update stocks
+        S[i] = FMath::Max(0.f, S[i] - getting_bitten);
+        Z[i] = FMath::Max(0.f, Z[i] + becoming_infected);
+        B[i] = current_content + inflow_people;
+    }
+    ConveyorCursor++;
+
+    // Migration between neighbouring cells
+    Migrate(S, SusceptibleMigrationRate);
+    Migrate(Z, ZombieMigrationRate);
+    if (BittenMigrationRate > 0.f)
+    {
+        // Bitten people keep their arrival day, so every cohort plane migrates on its own
+        std::fill(Bitten.begin(), Bitten.end(), 0.f);
+        for (int32 ArrivalDay = ConveyorCursor; ArrivalDay < ConveyorCursor + TransitSteps; ++ArrivalDay)
+        {
+            float* RESTRICT Cohort = GetConveyorPlane(ArrivalDay);
+            Migrate(Cohort, BittenMigrationRate);
+            for (int32 i = 0; i < NumCells; ++i)
+            {
+                B[i] += Cohort[i];
+            }
+        }
+    }
+
+    const float TotalZombiesBefore = TotalZombies;
+    RecomputeTotals();
+
+    if (OutAuxiliaries)
+    {
+        // Level-wide values, bites per zombie is the zombie-weighted mean over the cells
+        OutAuxiliaries->population_density = (TotalBitten + TotalSusceptible) / Params.land_area;
+        OutAuxiliaries->population_density_effect_on_zombie_bites = Params.normal_number_of_bites > 0.f && TotalZombiesBefore > 0.f
+            ? WeightedBitesPerZombie / TotalZombiesBefore / Params.normal_number_of_bites : 0.f;
+        OutAuxiliaries->number_of_bites_per_zombie_per_day = TotalZombiesBefore > 0.f ? WeightedBitesPerZombie / TotalZombiesBefore : 0.f;
+        OutAuxiliaries->getting_bitten = TotalGettingBitten;
+        OutAuxiliaries->becoming_infected = TotalBecomingInfected;
+    }
+
+    //Check if win or lose.
+    FZombieStepOutcome Outcome;
+    Outcome.bLose = TotalSusceptible <= Params.LoseSusceptibleThreshold;
+    Outcome.bWin = TotalZombies <= 0 || TimeStepsFinished > Params.WinDay;
+
+    TimeStepsFinished++;
+    return Outcome;
+}
+
+void FZombieGridModel::Migrate(float* Stock, float Rate)
+{
+    if (Rate <= 0.f)
+        return;
+
+    // Each neighbour gets Rate / 4 of the stock. A missing neighbour at the edge of the level
+    // counts as the cell itself, so nothing flows out of the grid and people are conserved.
+    const float k = FMath::Min(Rate, 1.f) * 0.25f;
+    float* RESTRICT Out = MigrationScratch.data();
+
+    for (int32 Y = 0; Y < SizeY; ++Y)
+    {
+        const float* RESTRICT Row = Stock + static_cast<size_t>(Y) * SizeX;
+        const float* RESTRICT Up = Y > 0 ? Row - SizeX : Row;
+        const float* RESTRICT Down = Y < SizeY - 1 ? Row + SizeX : Row;
+        float* RESTRICT OutRow = Out + static_cast<size_t>(Y) * SizeX;
+
+        if (SizeX == 1)
+        {
+            OutRow[0] = Row[0] + k * (Up[0] + Down[0] - 2.f * Row[0]);
+            continue;
+        }
+
+        OutRow[0] = Row[0] + k * (Row[1] + Up[0] + Down[0] - 3.f * Row[0]);
+        for (int32 X = 1; X < SizeX - 1; ++X)
+        {
+            OutRow[X] = Row[X] + k * (Row[X - 1] + Row[X + 1] + Up[X] + Down[X] - 4.f * Row[X]);
+        }
+        const int32 Last = SizeX - 1;
+        OutRow[Last] = Row[Last] + k * (Row[Last - 1] + Up[Last] + Down[Last] - 3.f * Row[Last]);
+    }
+
+    FMemory::Memcpy(Stock, Out, sizeof(float) * GetNumCells());
+}
+
+void FZombieGridModel::SetTransitTime(float TransitDays)
+{
+    const int32 NewTransitSteps = FZombieConveyor::TransitStepsFor(TransitDays, 1.f);
+    if (NewTransitSteps == TransitSteps)
+        return;
+
+    // Same rule as FZombieConveyor: cohorts keep their arrival day, or arrive at the new latest day if that is sooner
+    const size_t NumCells = static_cast<size_t>(GetNumCells());
+    std::vector<float> Resized(static_cast<size_t>(NewTransitSteps) * NumCells, 0.f);
+    for (int32 ArrivalDay = ConveyorCursor; ArrivalDay < ConveyorCursor + TransitSteps; ++ArrivalDay)
+    {
+        const float* RESTRICT From = GetConveyorPlane(ArrivalDay);
+        const int32 NewArrivalDay = FMath::Min(ArrivalDay, ConveyorCursor + NewTransitSteps - 1);
+        float* RESTRICT To = &Resized[static_cast<size_t>(NewArrivalDay % NewTransitSteps) * NumCells];
+        for (size_t i = 0; i < NumCells; ++i)
+        {
+            To[i] += From[i];
+        }
+    }
+    ConveyorSlots.swap(Resized);
+    TransitSteps = NewTransitSteps;
+}
+
+void FZombieGridModel::RecomputeTotals()
+{
+    TotalSusceptible = 0.f;
+    TotalBitten = 0.f;
+    TotalZombies = 0.f;
+    for (int32 i = 0; i < GetNumCells(); ++i)
+    {
+        TotalSusceptible += Susceptible[i];
+        TotalBitten += Bitten[i];
+        TotalZombies += Zombies[i];
+    }
+}
+
+void FZombieGridModel::ScaleStocksToTotals(float InSusceptible, float InZombies)
+{
+    auto Scale = [](std::vector<float>& Stock, float From, float To)
+    {
+        if (From == To)
+            return;
+        if (From <= 0.f)
+        {
+            // Nothing to keep the distribution of, spread it evenly
+            std::fill(Stock.begin(), Stock.end(), FMath::Max(0.f, To) / Stock.size());
+            return;
+        }
+        const float Factor = FMath::Max(0.f, To) / From;
+        for (float& Value : Stock)
+        {
+            Value *= Factor;
+        }
+    };
+
+    Scale(Susceptible, TotalSusceptible, InSusceptible);
+    Scale(Zombies, TotalZombies, InZombies);
+
+    RecomputeTotals();
+}
+
+void FZombieGridModel::ChangeCellStocks(int32 Cell, float SusceptibleChange, float ZombiesChange)
+{
+    if (Cell < 0 || Cell >= GetNumCells())
+        return;
+
+    const float SusceptibleApplied = FMath::Max(SusceptibleChange, -Susceptible[Cell]);
+    const float ZombiesApplied = FMath::Max(ZombiesChange, -Zombies[Cell]);
+    Susceptible[Cell] += SusceptibleApplied;
+    Zombies[Cell] += ZombiesApplied;
+    TotalSusceptible += SusceptibleApplied;
+    TotalZombies += ZombiesApplied;
+}
+
+float FZombieGridModel::RemoveFromCohort(int32 Cohort, float AmountOfPeople, int32 Cell)
+{
+    if (Cohort < ConveyorCursor || Cohort >= ConveyorCursor + TransitSteps || AmountOfPeople <= 0.f)
+        return 0.f;
+
+    float* RESTRICT Plane = GetConveyorPlane(Cohort);
+
+    // The cell's own part of the cohort first, which only touches that cell
+    float CellRemoved = 0.f;
+    if (Cell >= 0 && Cell < GetNumCells())
+    {
+        CellRemoved = FMath::Min(AmountOfPeople, Plane[Cell]);
+        const float BittenTaken = FMath::Min(CellRemoved, Bitten[Cell]);
+        Plane[Cell] -= CellRemoved;
+        Bitten[Cell] -= BittenTaken;
+        TotalBitten -= BittenTaken;
+        AmountOfPeople -= CellRemoved;
+        if (AmountOfPeople <= 0.f)
+            return CellRemoved;
+    }
+
+    float CohortTotal = 0.f;
+    for (int32 i = 0; i < GetNumCells(); ++i)
+    {
+        CohortTotal += Plane[i];
+    }
+    if (CohortTotal <= 0.f)
+        return CellRemoved;
+
+    const float Removed = FMath::Min(AmountOfPeople, CohortTotal);
+    const float Keep = 1.f - Removed / CohortTotal;
+    for (int32 i = 0; i < GetNumCells(); ++i)
+    {
+        const float Taken = Plane[i] * (1.f - Keep);
+        Plane[i] -= Taken;
+        Bitten[i] = FMath::Max(0.f, Bitten[i] - Taken);
+    }
+
+    RecomputeTotals();
+    return CellRemoved + Removed;
+}
+
+void FZombieGridModel::CollapseInto(FZombieModel& OutModel) const
+{
+    OutModel.Params = Params;
+    OutModel.Params.Incubation = EZombieIncubation::Conveyor;
+    OutModel.Graph = Graph;
+    OutModel.State.Susceptible = TotalSusceptible;
+    OutModel.State.Bitten = TotalBitten;
+    OutModel.State.Zombies = TotalZombies;
+    OutModel.State.TimeStepsFinished = TimeStepsFinished;
+
+    std::vector<float> Cohorts(static_cast<size_t>(TransitSteps), 0.f);
+    for (int32 Step = 0; Step < TransitSteps; ++Step)
+    {
+        const float* Plane = &ConveyorSlots[static_cast<size_t>((ConveyorCursor + Step) % TransitSteps) * GetNumCells()];
+        for (int32 i = 0; i < GetNumCells(); ++i)
+        {
+            Cohorts[Step] += Plane[i];
+        }
+    }
+    OutModel.State.conveyor.Assign(ConveyorCursor, Cohorts);
+}
+
+FZombieModelSnapshot FZombieGridModel::MakeSnapshot(const FZombieModelAuxiliaries& Auxiliaries, const FZombieStepOutcome& Outcome) const
+{
+    FZombieModelSnapshot Snapshot;
+    Snapshot.Susceptible = TotalSusceptible;
+    Snapshot.Bitten = TotalBitten;
+    Snapshot.Zombies = TotalZombies;
+    Snapshot.TimeStepsFinished = TimeStepsFinished;
+    Snapshot.population_density = Auxiliaries.population_density;
+    Snapshot.number_of_bites_per_zombie_per_day = Auxiliaries.number_of_bites_per_zombie_per_day;
+    Snapshot.getting_bitten = Auxiliaries.getting_bitten;
+    Snapshot.becoming_infected = Auxiliaries.becoming_infected;
+    Snapshot.bLose = Outcome.bLose;
+    Snapshot.bWin = Outcome.bWin;
+    return Snapshot;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZombieModel.h"
+#include <vector>
+
+// Metapopulation version of FZombieModel: the level is split into SizeX * SizeY cells, each with
+// its own stocks and conveyor, and people migrate between neighbouring cells every day.
+// Stocks are stored as structure-of-arrays (one float per cell per stock) and stepped in flat loops.
+// A 1x1 grid with bRoundToWholePeople and no migration steps exactly like FZombieModel.
+// Bitten people always incubate on the conveyor, Params.Incubation is ignored.
+class ZOMBIEAPOCALYPSE_API FZombieGridModel
+{
+public:
+	// Whole-level constants. land_area and Bitten_capacity are split evenly between the cells.
+	FZombieModelParams Params;
+
+	// Shared with the well-mixed model, never modified after it is loaded
+	TSharedPtr<const FZombieGraph> Graph;
+
+	// Fraction of a cell's stock that moves to its neighbours per day, 0..1
+	float SusceptibleMigrationRate{ 0.f };
+	float BittenMigrationRate{ 0.f };
+	float ZombieMigrationRate{ 0.f };
+
+	// Round bites to whole people like the Stella model. Cells usually hold fractions of a person,
+	// so by default flows are continuous.
+	bool bRoundToWholePeople{ false };
+
+	// Stocks per cell, index = Y * SizeX + X
+	std::vector<float> Susceptible;
+	std::vector<float> Bitten;
+	std::vector<float> Zombies;
+
+	int32 TimeStepsFinished{ 0 };
+
+	// Allocates the cells with every stock at zero
+	void Initialize(int32 InSizeX, int32 InSizeY);
+
+	int32 GetSizeX() const { return SizeX; }
+	int32 GetSizeY() const { return SizeY; }
+	int32 GetNumCells() const { return SizeX * SizeY; }
+	int32 GetCellIndex(int32 X, int32 Y) const { return Y * SizeX + X; }
+
+	// Advances every cell one day, then migrates. Outcome and auxiliaries are for the whole level.
+	FZombieStepOutcome RunSimulationStep(FZombieModelAuxiliaries* OutAuxiliaries = nullptr);
+
+	// Level totals, kept up to date by RunSimulationStep and the functions below
+	float GetTotalSusceptible() const { return TotalSusceptible; }
+	float GetTotalBitten() const { return TotalBitten; }
+	float GetTotalZombies() const { return TotalZombies; }
+
+	// Scales every cell so the level totals match, keeping the spatial distribution.
+	// Used to apply changes gameplay made to the global stocks without saying where. Bitten follows the conveyor,
+	// like in FZombieModel, so it is changed through RemoveFromCohort instead.
+	void ScaleStocksToTotals(float InSusceptible, float InZombies);
+
+	// Adds to the stocks of one cell and the level totals, for gameplay changes made at a known place such
+	// as a kill. A cell never drops below zero; ScaleStocksToTotals spreads whatever it could not take.
+	void ChangeCellStocks(int32 Cell, float SusceptibleChange, float ZombiesChange);
+
+	// Call after writing to Susceptible or Zombies directly
+	void RecomputeTotals();
+
+	// Conveyor cohorts are shared by all cells, same handles as FZombieConveyor
+	int32 GetIncomingCohort() const { return ConveyorCursor + TransitSteps; }
+
+	// Removes people from a cohort in proportion to how many each cell holds. Returns how many were removed.
+	// With a Cell they come out of that cell's part of the cohort, and only what it lacks from every cell.
+	float RemoveFromCohort(int32 Cohort, float AmountOfPeople, int32 Cell = INDEX_NONE);
+
+	// Sums the cells into a well-mixed model, e.g. to forecast from the current state
+	void CollapseInto(FZombieModel& OutModel) const;
+
+	// Level totals together with the auxiliaries and outcome of the step that produced them
+	FZombieModelSnapshot MakeSnapshot(const FZombieModelAuxiliaries& Auxiliaries, const FZombieStepOutcome& Outcome) const;
+
+private:
+	int32 SizeX{ 0 };
+	int32 SizeY{ 0 };
+
+	// TransitSteps planes of NumCells, plane = arrival day % TransitSteps
+	std::vector<float> ConveyorSlots;
+	int32 TransitSteps{ 0 };
+	int32 ConveyorCursor{ 0 };
+
+	float TotalSusceptible{ 0.f };
+	float TotalBitten{ 0.f };
+	float TotalZombies{ 0.f };
+
+	// Per-cell scratch, sized once in Initialize
+	std::vector<float> DensityRatio;
+	std::vector<float> DensityEffect;
+	std::vector<float> MigrationScratch;
+
+	float* GetConveyorPlane(int32 ArrivalDay) { return &ConveyorSlots[static_cast<size_t>(ArrivalDay % TransitSteps) * GetNumCells()]; }
+
+	void SetTransitTime(float TransitDays);
+	void Migrate(float* Stock, float Rate);
+};
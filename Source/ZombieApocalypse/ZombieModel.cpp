@@ -0,0 +1,412 @@
+#include "ZombieModel.h"
+#include "Misc/FileHelper.h"
+
+FZombieStepOutcome FZombieModel::RunSimulationStep(FZombieModelAuxiliaries* OutAuxiliaries)
+{
+    return StepZombieModel(Params, TZombieModelRates<float>(Params), State, [this](float xIn) { return graph_lookup(xIn); }, OutAuxiliaries);
+}
+
+FZombieStepOutcome FZombieModel::RunStochasticStep(FRandomStream& Stream, FZombieModelAuxiliaries* OutAuxiliaries)
+{
+    return StepZombieModel(Params, TZombieModelRates<float>(Params), State, [this](float xIn) { return graph_lookup(xIn); }, OutAuxiliaries,
+        FZombieStochasticFlows(Stream));
+}
+
+float FZombieStochasticFlows::Conversions(float People, float ConversionRate) const
+{
+    // Each bitten person turns with probability ConversionRate; above 1 a person can make more than one zombie
+    return ConversionRate <= 1.f ? Binomial(People, ConversionRate) : Poisson(People * ConversionRate);
+}
+
+float FZombieStochasticFlows::Poisson(float Mean) const
+{
+    if (Mean <= 0.f)
+        return 0.f;
+
+    // Normal approximation once the mean is large enough for it to be good
+    if (Mean >= 30.f)
+        return FMath::Max(0.f, FMath::RoundToFloat(Mean + FMath::Sqrt(Mean) * Gaussian()));
+
+    // Inversion: walk up the CDF until it passes a uniform draw
+    float Probability = FMath::Exp(-Mean);
+    float Cumulative = Probability;
+    const float Uniform = Stream.GetFraction();
+    int32 Count = 0;
+    while (Uniform > Cumulative && Probability > 0.f)
+    {
+        Count++;
+        Probability *= Mean / Count;
+        Cumulative += Probability;
+    }
+    return static_cast<float>(Count);
+}
+
+float FZombieStochasticFlows::Binomial(float Trials, float Probability) const
+{
+    const int32 n = FMath::RoundToInt(Trials);
+    if (n <= 0 || Probability <= 0.f)
+        return 0.f;
+    if (Probability >= 1.f)
+        return static_cast<float>(n);
+
+    // The walk below is shortest for p <= 0.5
+    if (Probability > 0.5f)
+        return n - Binomial(Trials, 1.f - Probability);
+
+    if (n * Probability >= 30.f)
+    {
+        const float Mean = n * Probability;
+        const float StdDev = FMath::Sqrt(Mean * (1.f - Probability));
+        return FMath::Clamp(FMath::RoundToFloat(Mean + StdDev * Gaussian()), 0.f, static_cast<float>(n));
+    }
+
+    // Inversion (BINV): the probability of k + 1 successes follows from the probability of k
+    const float q = 1.f - Probability;
+    const float s = Probability / q;
+    const float a = (n + 1) * s;
+    float r = FMath::Pow(q, static_cast<float>(n));
+    float Uniform = Stream.GetFraction();
+    int32 Count = 0;
+    while (Uniform > r && Count < n)
+    {
+        Uniform -= r;
+        Count++;
+        r *= a / Count - s;
+    }
+    return static_cast<float>(Count);
+}
+
+float FZombieStochasticFlows::Gaussian() const
+{
+    // Box-Muller
+    const float u1 = FMath::Max(Stream.GetFraction(), UE_SMALL_NUMBER);
+    const float u2 = Stream.GetFraction();
+    return FMath::Sqrt(-2.f * FMath::Loge(u1)) * FMath::Cos(2.f * UE_PI * u2);
+}
+
+FZombieRunResult FZombieModel::Run(int32 MaxDays, bool bStopAtFirstOutcome)
+{
+    FZombieRunResult Result;
+
+    // A step covers more than one day when DT is above 1
+    while (Result.DaysRun < MaxDays)
+    {
+        const int32 DayBefore = State.TimeStepsFinished;
+        FZombieStepOutcome Outcome = RunSimulationStep();
+        Result.DaysRun += State.TimeStepsFinished - DayBefore;
+
+        if (Outcome.bLose && Result.LoseDay < 0)
+            Result.LoseDay = State.TimeStepsFinished;
+        if (Outcome.bWin && Result.WinDay < 0)
+            Result.WinDay = State.TimeStepsFinished;
+
+        const bool bAnyOutcome = Result.LoseDay >= 0 || Result.WinDay >= 0;
+        const bool bBothOutcomes = Result.LoseDay >= 0 && Result.WinDay >= 0;
+        if (bBothOutcomes || (bStopAtFirstOutcome && bAnyOutcome))
+            break;
+    }
+
+    Result.FinalSusceptible = State.Susceptible;
+    Result.FinalBitten = State.Bitten;
+    Result.FinalZombies = State.Zombies;
+    return Result;
+}
+
+void FZombieModel::Forecast(int32 DaysAhead, FZombieForecast& OutForecast)
+{
+    OutForecast.StartDay = State.TimeStepsFinished;
+    OutForecast.LoseDay = -1;
+    OutForecast.WinDay = -1;
+    OutForecast.Trajectory.Reset(FMath::Max(DaysAhead, 0));
+
+    while (State.TimeStepsFinished < OutForecast.StartDay + DaysAhead)
+    {
+        FZombieModelAuxiliaries Auxiliaries;
+        const FZombieStepOutcome Outcome = RunSimulationStep(&Auxiliaries);
+        OutForecast.Trajectory.Add(MakeSnapshot(Auxiliaries, Outcome));
+
+        if (Outcome.bLose && OutForecast.LoseDay < 0)
+            OutForecast.LoseDay = State.TimeStepsFinished;
+        if (Outcome.bWin && OutForecast.WinDay < 0)
+            OutForecast.WinDay = State.TimeStepsFinished;
+    }
+}
+
+void FZombieModel::Apply(const FZombieCounterfactual& Change)
+{
+    State.Susceptible = FMath::Max(0.f, State.Susceptible + Change.SusceptibleChange);
+    State.Zombies = FMath::Max(0.f, State.Zombies + Change.ZombiesChange);
+
+    // Bitten is recomputed from the conveyor every step, so it has to come off there
+    switch (Params.Incubation)
+    {
+    case EZombieIncubation::Delay1:        State.incubation_delay1.Remove(Change.BittenRemoved); break;
+    case EZombieIncubation::Delay3:        State.incubation_delay3.Remove(Change.BittenRemoved); break;
+    case EZombieIncubation::LeakyConveyor: State.incubation_leaky_conveyor.Remove(Change.BittenRemoved); break;
+    default:                               State.conveyor.RemoveOldest(Change.BittenRemoved); break;
+    }
+    State.Bitten = conveyor_content();
+}
+
+void FZombieModel::RemoveBitten(int32 Cohort, float AmountOfPeople)
+{
+    switch (Params.Incubation)
+    {
+    case EZombieIncubation::Delay1:        State.incubation_delay1.Remove(AmountOfPeople); break;
+    case EZombieIncubation::Delay3:        State.incubation_delay3.Remove(AmountOfPeople); break;
+    case EZombieIncubation::LeakyConveyor: State.incubation_leaky_conveyor.Remove(AmountOfPeople); break;
+    default:                               State.conveyor.Remove(Cohort, AmountOfPeople); break;
+    }
+}
+
+bool FZombieModel::HasSameInputs(const FZombieModel& Other) const
+{
+    return Graph == Other.Graph
+        && Params == Other.Params
+        && State.Susceptible == Other.State.Susceptible
+        && State.Bitten == Other.State.Bitten
+        && State.Zombies == Other.State.Zombies
+        && State.TimeStepsFinished == Other.State.TimeStepsFinished
+        && State.conveyor == Other.State.conveyor
+        && State.incubation_delay1 == Other.State.incubation_delay1
+        && State.incubation_delay3 == Other.State.incubation_delay3
+        && State.incubation_leaky_conveyor == Other.State.incubation_leaky_conveyor;
+}
+
+FZombieModelSnapshot FZombieModel::MakeSnapshot(const FZombieModelAuxiliaries& Auxiliaries, const FZombieStepOutcome& Outcome) const
+{
+    FZombieModelSnapshot Snapshot;
+    Snapshot.Susceptible = State.Susceptible;
+    Snapshot.Bitten = State.Bitten;
+    Snapshot.Zombies = State.Zombies;
+    Snapshot.TimeStepsFinished = State.TimeStepsFinished;
+    Snapshot.population_density = Auxiliaries.population_density;
+    Snapshot.number_of_bites_per_zombie_per_day = Auxiliaries.number_of_bites_per_zombie_per_day;
+    Snapshot.getting_bitten = Auxiliaries.getting_bitten;
+    Snapshot.becoming_infected = Auxiliaries.becoming_infected;
+    Snapshot.bLose = Outcome.bLose;
+    Snapshot.bWin = Outcome.bWin;
+    return Snapshot;
+}
+
+float FZombieModel::conveyor_content() const
+{
+    return State.IncubatingContent(Params.Incubation);
+}
+
+float FZombieModel::graph_lookup(float xIn) const
+{
+    return Graph ? Graph->graph_lookup(xIn) : 1.0f;
+}
+
+void FZombieGraph::graph_lookup_batch(const float* xIn, float* yOut, int32 Num) const
+{
+    int32 i = 0;
+
+    if (IsBaked())
+    {
+        // Same operations as graph_lookup so both paths give identical results
+        const VectorRegister4Float MinX = VectorSetFloat1(BakedMinX);
+        const VectorRegister4Float InvStep = VectorSetFloat1(BakedInvStep);
+        const VectorRegister4Float MaxIndex = VectorSetFloat1(BakedMaxIndex);
+        const VectorRegister4Float Zero = VectorZeroFloat();
+
+        for (; i + 4 <= Num; i += 4)
+        {
+            VectorRegister4Float u = VectorMultiply(VectorSubtract(VectorLoad(xIn + i), MinX), InvStep);
+            u = VectorMin(VectorMax(u, Zero), MaxIndex);
+            const VectorRegister4Float Index = VectorFloor(u);
+
+            // No gather in the vector API, so fetch the table entries per lane
+            alignas(16) float Lanes[4];
+            alignas(16) float y0[4];
+            alignas(16) float Slope[4];
+            VectorStoreAligned(Index, Lanes);
+            for (int32 Lane = 0; Lane < 4; ++Lane)
+            {
+                const int32 Entry = static_cast<int32>(Lanes[Lane]);
+                y0[Lane] = BakedValues[Entry];
+                Slope[Lane] = BakedSlopes[Entry];
+            }
+
+            const VectorRegister4Float Frac = VectorSubtract(u, Index);
+            VectorStore(VectorAdd(VectorLoadAligned(y0), VectorMultiply(VectorLoadAligned(Slope), Frac)), yOut + i);
+        }
+    }
+
+    for (; i < Num; ++i)
+        yOut[i] = graph_lookup(xIn[i]);
+}
+
+void FZombieGraph::Bake(int32 Resolution)
+{
+    BakedValues.clear();
+    BakedSlopes.clear();
+
+    if (graphPts.size() < 2)
+        return;
+
+    const float MinX = graphPts.front().first;
+    const float MaxX = graphPts.back().first;
+    if (MaxX <= MinX)
+        return;
+
+    // Evenly spaced points (like the DataTable) bake without any resampling error
+    const float FirstSpacing = graphPts[1].first - graphPts[0].first;
+    bool bEvenlySpaced = true;
+    for (size_t i = 1; i < graphPts.size(); ++i)
+    {
+        const float Spacing = graphPts[i].first - graphPts[i-1].first;
+        bEvenlySpaced &= FMath::IsNearlyEqual(Spacing, FirstSpacing, FirstSpacing * 1.e-3f);
+    }
+
+    const int32 Intervals = bEvenlySpaced ? static_cast<int32>(graphPts.size()) - 1 : FMath::Max(1, Resolution);
+    const float Step = (MaxX - MinX) / Intervals;
+
+    BakedValues.resize(Intervals + 1);
+    BakedSlopes.resize(Intervals + 1);
+    for (int32 i = 0; i <= Intervals; ++i)
+    {
+        BakedValues[i] = bEvenlySpaced ? graphPts[i].second : graph_lookup_scan(MinX + Step * i);
+    }
+    for (int32 i = 0; i < Intervals; ++i)
+    {
+        BakedSlopes[i] = BakedValues[i + 1] - BakedValues[i];
+    }
+    BakedSlopes[Intervals] = 0.f;
+
+    BakedMinX = MinX;
+    BakedInvStep = 1.f / Step;
+    BakedMaxIndex = static_cast<float>(Intervals);
+}
+
+float FZombieGraph::graph_lookup_scan(float xIn) const
+{
+    if (graphPts.empty()) return 1.0f;
+
+    if (xIn <= graphPts.front().first)
+        return graphPts.front().second;
+    if (xIn >= graphPts.back().first)
+        return graphPts.back().second;
+
+    for (size_t i = 1; i < graphPts.size(); ++i)
+    {
+        if (xIn <= graphPts[i].first)
+        {
+            float x0 = graphPts[i-1].first, x1 = graphPts[i].first;
+            float y0 = graphPts[i-1].second, y1 = graphPts[i].second;
+            float t = (xIn - x0) / (x1 - x0);
+            return y0 + t*(y1 - y0);
+        }
+    }
+    return graphPts.back().second;
+}
+
+void FZombieGraph::ReadFromDataTable(const UDataTable& Table)
+{
+    graphPts.clear();
+    BakedValues.clear();
+    BakedSlopes.clear();
+
+    TArray<FName> rowNames = Table.GetRowNames();
+    graphPts.reserve(rowNames.Num());
+
+    for (const FName& rowName : rowNames)
+    {
+        const FPopulationDensityEffect* rowData = Table.FindRow<FPopulationDensityEffect>(rowName, TEXT(""));
+        if (rowData)
+            graphPts.emplace_back(rowData->PopulationDensity, rowData->NormalPopulationDensity);
+    }
+}
+
+// Cooked layout: version, point count, baked count, BakedMinX, BakedInvStep, BakedMaxIndex, then x, y per
+// point, then the baked values and the baked slopes. Bump the version whenever the layout changes.
+static constexpr int32 CookedHeaderSize = 6;
+static constexpr float CookedVersion = 2.f;
+
+void FZombieGraph::WriteCooked(TArray<float>& OutData) const
+{
+    static_assert(sizeof(std::pair<float, float>) == 2 * sizeof(float), "Points are copied as pairs of floats");
+
+    const int32 NumPoints = static_cast<int32>(graphPts.size());
+    const int32 NumBaked = static_cast<int32>(BakedValues.size());
+    OutData.SetNumUninitialized(CookedHeaderSize + 2 * NumPoints + 2 * NumBaked);
+
+    float* Data = OutData.GetData();
+    Data[0] = CookedVersion;
+    Data[1] = static_cast<float>(NumPoints);
+    Data[2] = static_cast<float>(NumBaked);
+    Data[3] = BakedMinX;
+    Data[4] = BakedInvStep;
+    Data[5] = BakedMaxIndex;
+    Data += CookedHeaderSize;
+
+    FMemory::Memcpy(Data, graphPts.data(), NumPoints * sizeof(std::pair<float, float>));
+    Data += 2 * NumPoints;
+    FMemory::Memcpy(Data, BakedValues.data(), NumBaked * sizeof(float));
+    Data += NumBaked;
+    FMemory::Memcpy(Data, BakedSlopes.data(), NumBaked * sizeof(float));
+}
+
+bool FZombieGraph::ReadCooked(const TArray<float>& Data)
+{
+    if (Data.Num() < CookedHeaderSize || Data[0] != CookedVersion)
+        return false;
+
+    // Counts are checked as floats first, so a corrupt header cannot overflow the size check
+    if (!(Data[1] >= 1.f && Data[1] <= Data.Num() && Data[2] >= 0.f && Data[2] <= Data.Num()))
+        return false;
+
+    const int32 NumPoints = static_cast<int32>(Data[1]);
+    const int32 NumBaked = static_cast<int32>(Data[2]);
+    if (Data.Num() != CookedHeaderSize + 2 * NumPoints + 2 * NumBaked)
+        return false;
+
+    // The baked lookup clamps its index to BakedMaxIndex, which has to be the last entry of the table
+    if (NumBaked > 0 && (NumBaked < 2 || Data[5] != static_cast<float>(NumBaked - 1)
+        || !FMath::IsFinite(Data[3]) || !FMath::IsFinite(Data[4]) || Data[4] <= 0.f))
+        return false;
+
+    const float* Source = Data.GetData() + CookedHeaderSize;
+    graphPts.resize(NumPoints);
+    FMemory::Memcpy(graphPts.data(), Source, NumPoints * sizeof(std::pair<float, float>));
+    Source += 2 * NumPoints;
+    BakedValues.assign(Source, Source + NumBaked);
+    Source += NumBaked;
+    BakedSlopes.assign(Source, Source + NumBaked);
+
+    BakedMinX = Data[3];
+    BakedInvStep = Data[4];
+    BakedMaxIndex = Data[5];
+    return true;
+}
+
+bool FZombieGraph::ReadFromCsvFile(const FString& FilePath)
+{
+    TArray<FString> Lines;
+    if (!FFileHelper::LoadFileToStringArray(Lines, *FilePath))
+    {
+        UE_LOG(LogTemp, Error, TEXT("ZombieModel: Could not read curve file %s"), *FilePath);
+        return false;
+    }
+
+    graphPts.clear();
+    BakedValues.clear();
+    BakedSlopes.clear();
+
+    for (const FString& Line : Lines)
+    {
+        // Header row starts with "---" like the DataTable export
+        if (Line.IsEmpty() || Line.StartsWith(TEXT("---")))
+            continue;
+
+        TArray<FString> Columns;
+        Line.ParseIntoArray(Columns, TEXT(","));
+        if (Columns.Num() < 3)
+            continue;
+
+        graphPts.emplace_back(FCString::Atof(*Columns[1].TrimStartAndEnd()), FCString::Atof(*Columns[2].TrimStartAndEnd()));
+    }
+
+    return !graphPts.empty();
+}
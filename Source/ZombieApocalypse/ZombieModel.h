@@ -0,0 +1,954 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataTable.h"
+#include "ZombieDual.h"
+#include "SDDelays.h"
+#include <vector>
+#include <atomic>
+#include "ZombieModel.generated.h"
+
+
+// Struct for the Unreal DataTable
+USTRUCT(BlueprintType)
+struct FPopulationDensityEffect : public FTableRowBase
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float PopulationDensity;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float NormalPopulationDensity;
+};
+
+// How Susceptible and Zombies are integrated over a step. The conveyor moves once per step whatever the
+// method; the higher orders re-evaluate the bites at intermediate stocks within the step.
+UENUM(BlueprintType)
+enum class EZombieIntegrationMethod : uint8
+{
+	Euler,
+	RK2,
+	RK4
+};
+
+// How bitten people incubate. The conveyor is the Stella model: everyone turns exactly
+// days_to_become_infected_from_bite days after the bite. The material delays spread the turning out
+// around that time instead, DELAY3 more tightly than DELAY1. The leaky conveyor is the conveyor with
+// Stella's leakage: every day leakage_fraction of the people still incubating die or recover and never turn.
+UENUM(BlueprintType)
+enum class EZombieIncubation : uint8
+{
+	Conveyor,
+	Delay1,
+	Delay3,
+	LeakyConveyor
+};
+
+// Constants of the stock-and-flow model. Names follow the Stella model.
+USTRUCT(BlueprintType)
+struct FZombieModelParams
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables")
+	float days_to_become_infected_from_bite{ 15.f };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables")
+	float Bitten_capacity{ 100.f };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables")
+	float CONVERSION_FROM_PEOPLE_TO_ZOMBIES{ 1.f };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables")
+	float normal_number_of_bites{ 1.f };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables")
+	float land_area{ 1000.f };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables")
+	float normal_population_density{ 0.1f };
+
+	// The conveyor is the Stella reference
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables")
+	EZombieIncubation Incubation{ EZombieIncubation::Conveyor };
+
+	// Share of the bitten people on a leaky conveyor who leave it each day without turning
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Simulation Variables", meta = (ClampMin = "0", ClampMax = "1"))
+	float leakage_fraction{ 0.f };
+
+	// Lose() fires when Susceptible drops to this value or below
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "End Game")
+	float LoseSusceptibleThreshold{ 45.f };
+
+	// Win() fires once more than this many days have passed
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "End Game")
+	int32 WinDay{ 180 };
+
+	// Euler at DT 1 is the Stella reference
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Integration")
+	EZombieIntegrationMethod IntegrationMethod{ EZombieIntegrationMethod::Euler };
+
+	// Step size in days. Below 1 every step is split into round(1 / DT) equal substeps and still covers a day;
+	// above 1 a step covers round(DT) days, for fast-forwarding.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Integration", meta = (ClampMin = "0.01"))
+	float DT{ 1.f };
+
+	bool operator==(const FZombieModelParams& Other) const
+	{
+		return days_to_become_infected_from_bite == Other.days_to_become_infected_from_bite
+			&& Bitten_capacity == Other.Bitten_capacity
+			&& CONVERSION_FROM_PEOPLE_TO_ZOMBIES == Other.CONVERSION_FROM_PEOPLE_TO_ZOMBIES
+			&& normal_number_of_bites == Other.normal_number_of_bites
+			&& land_area == Other.land_area
+			&& normal_population_density == Other.normal_population_density
+			&& Incubation == Other.Incubation
+			&& leakage_fraction == Other.leakage_fraction
+			&& LoseSusceptibleThreshold == Other.LoseSusceptibleThreshold
+			&& WinDay == Other.WinDay
+			&& IntegrationMethod == Other.IntegrationMethod
+			&& DT == Other.DT;
+	}
+};
+
+// Conveyor system for bitten people.
+// Fixed-size ring of cohorts indexed by the step they arrive at the Zombies stock,
+// with a running total so the content is O(1). A cohort that enters on step t
+// leaves on step t + max(1, ceil(days_to_become_infected_from_bite / step length)).
+// With steps other than a day the transit is rarely a whole number of steps, so each inflow is
+// split between that step and the one before it such that it still arrives after the transit
+// time on average, e.g. 15 days at 7-day steps is 6/7 after 2 steps and 1/7 after 3.
+// Templated on the number type so the sensitivity pass can carry derivatives through it.
+template<typename T>
+class TZombieConveyor
+{
+public:
+	TZombieConveyor() = default;
+
+	// Copies the cohorts of a conveyor over another number type
+	template<typename U>
+	explicit TZombieConveyor(const TZombieConveyor<U>& Other)
+		: Slots(Other.Slots.begin(), Other.Slots.end())
+		, Cursor(Other.Cursor)
+		, Total(Other.Total)
+		, StepDays(Other.StepDays)
+		, LateFraction(Other.LateFraction)
+	{
+	}
+
+	// Whole number of steps of InStepDays a cohort spends on the conveyor
+	static int32 TransitStepsFor(float TransitDays, float InStepDays)
+	{
+		// Tolerates 1 / DT not being exact in float, e.g. 15 days at DT 0.1 is 150 steps, not 151
+		return FMath::Max(1, FMath::CeilToInt(TransitDays / InStepDays - UE_KINDA_SMALL_NUMBER));
+	}
+
+	// Share of an inflow that stays the whole TransitStepsFor steps, the rest leaves a step earlier.
+	// A one-day step is the Stella step, which rounds the transit up to whole days, so it is always 1 there.
+	static float LateFractionFor(float TransitDays, float InStepDays)
+	{
+		const int32 TransitSteps = TransitStepsFor(TransitDays, InStepDays);
+		if (InStepDays == 1.f || TransitSteps < 2)
+			return 1.f;
+
+		const float Fraction = TransitDays / InStepDays - (TransitSteps - 1);
+		return Fraction > 1.f - UE_KINDA_SMALL_NUMBER ? 1.f : FMath::Max(Fraction, 0.f);
+	}
+
+	// Sizes the ring for the transit time and step length. Only reallocates when the number of steps or the
+	// step length changes; cohorts already in flight keep their arrival time, rounded down to a whole step,
+	// or arrive at the new latest step if that is sooner.
+	void SetTransitTime(float TransitDays, float InStepDays = 1.f)
+	{
+		const int32 TransitSteps = TransitStepsFor(TransitDays, InStepDays);
+		LateFraction = LateFractionFor(TransitDays, InStepDays);
+		if (TransitSteps == GetTransitSteps() && InStepDays == StepDays)
+			return;
+
+		std::vector<T> Resized(TransitSteps, T(0.f));
+		for (int32 ArrivalStep = Cursor; ArrivalStep < Cursor + GetTransitSteps(); ++ArrivalStep)
+		{
+			const T People = Slots[ArrivalStep % GetTransitSteps()];
+			int32 StepsLeft = ArrivalStep - Cursor;
+			if (InStepDays != StepDays)
+				StepsLeft = FMath::FloorToInt(StepsLeft * StepDays / InStepDays + UE_KINDA_SMALL_NUMBER);
+			const int32 NewArrivalStep = Cursor + FMath::Min(StepsLeft, TransitSteps - 1);
+			Resized[NewArrivalStep % TransitSteps] += People;
+		}
+		Slots.swap(Resized);
+		StepDays = InStepDays;
+	}
+
+	// Empties the cohort arriving this step and returns how many people it held
+	T TakeOutflow()
+	{
+		T& Slot = Slots[Cursor % GetTransitSteps()];
+		const T Outflow = Slot;
+		Slot = T(0.f);
+		Total -= Outflow;
+		return Outflow;
+	}
+
+	// Puts people in the cohort entering this step and moves on to the next step
+	void AddInflowAndAdvance(const T& AmountOfPeople)
+	{
+		// The slot just emptied by TakeOutflow is the one that arrives TransitSteps from now
+		if (LateFraction < 1.f)
+		{
+			const T Early = AmountOfPeople * T(1.f - LateFraction);
+			Slots[(Cursor + GetTransitSteps() - 1) % GetTransitSteps()] += Early;
+			Slots[Cursor % GetTransitSteps()] += AmountOfPeople - Early;
+		}
+		else
+		{
+			Slots[Cursor % GetTransitSteps()] += AmountOfPeople;
+		}
+		Total += AmountOfPeople;
+		Cursor++;
+	}
+
+	// Handle of the cohort that the next step's inflow goes into
+	int32 GetIncomingCohort() const { return Cursor + GetTransitSteps(); }
+
+	// Handle of the cohort that leaves on the next step
+	int32 GetOutgoingCohort() const { return Cursor; }
+
+	// People in a cohort still in flight, 0 for any other handle
+	T GetCohort(int32 Cohort) const
+	{
+		if (Cohort < Cursor || Cohort >= Cursor + GetTransitSteps())
+			return T(0.f);
+		return Slots[Cohort % GetTransitSteps()];
+	}
+
+	// Removes up to AmountOfPeople from a cohort still in flight. Returns how many were removed.
+	// When inflows are split, the rest is taken from the cohort a step earlier that holds the other part.
+	T Remove(int32 Cohort, T AmountOfPeople)
+	{
+		T Removed = RemoveFromSlot(Cohort, AmountOfPeople);
+		if (LateFraction < 1.f && Removed < AmountOfPeople)
+			Removed += RemoveFromSlot(Cohort - 1, AmountOfPeople - Removed);
+		return Removed;
+	}
+
+	// Removes up to AmountOfPeople starting with the cohort that arrives first. Returns how many were removed.
+	T RemoveOldest(T AmountOfPeople)
+	{
+		T Removed = T(0.f);
+		for (int32 Cohort = Cursor; Cohort < Cursor + GetTransitSteps() && Removed < AmountOfPeople; ++Cohort)
+		{
+			Removed += RemoveFromSlot(Cohort, AmountOfPeople - Removed);
+		}
+		return Removed;
+	}
+
+	// Replaces the content with one cohort per transit step, CohortsByArrival[0] arriving on step InCursor.
+	// New inflows go whole into the last cohort until SetTransitTime splits them.
+	void Assign(int32 InCursor, const std::vector<T>& CohortsByArrival, float InStepDays = 1.f)
+	{
+		StepDays = InStepDays;
+		LateFraction = 1.f;
+		const int32 TransitSteps = FMath::Max(1, static_cast<int32>(CohortsByArrival.size()));
+		Slots.assign(TransitSteps, T(0.f));
+		Cursor = InCursor;
+		Total = T(0.f);
+		for (int32 Step = 0; Step < static_cast<int32>(CohortsByArrival.size()); ++Step)
+		{
+			Slots[(Cursor + Step) % TransitSteps] = CohortsByArrival[Step];
+			Total += CohortsByArrival[Step];
+		}
+	}
+
+	const T& Content() const { return Total; }
+	int32 GetTransitSteps() const { return static_cast<int32>(Slots.size()); }
+
+	bool operator==(const TZombieConveyor& Other) const
+	{
+		return Cursor == Other.Cursor && Total == Other.Total && StepDays == Other.StepDays && LateFraction == Other.LateFraction
+			&& Slots == Other.Slots;
+	}
+
+private:
+	template<typename U>
+	friend class TZombieConveyor;
+
+	T RemoveFromSlot(int32 Cohort, T AmountOfPeople)
+	{
+		if (Cohort < Cursor || Cohort >= Cursor + GetTransitSteps())
+			return T(0.f);
+
+		T& Slot = Slots[Cohort % GetTransitSteps()];
+		const T Removed = FMath::Clamp(AmountOfPeople, T(0.f), Slot);
+		Slot -= Removed;
+		Total -= Removed;
+		return Removed;
+	}
+
+	// People per cohort, slot = arrival step % transit steps
+	std::vector<T> Slots;
+
+	// Index of the next step, i.e. the arrival step of the cohort leaving next
+	int32 Cursor{ 0 };
+
+	T Total{ 0.f };
+
+	// Length of a step in days
+	float StepDays{ 1.f };
+
+	// Share of each inflow that arrives after the full GetTransitSteps(), see LateFractionFor
+	float LateFraction{ 1.f };
+};
+
+using FZombieConveyor = TZombieConveyor<float>;
+
+// Stocks of the model plus the bitten conveyor, or the delay that replaces it, see EZombieIncubation
+template<typename T>
+struct TZombieModelState
+{
+	T Susceptible{ 100.f };
+	T Bitten{ 0.f };
+	T Zombies{ 1.f };
+
+	// Number of time steps completed - to keep track and compare to Stella
+	int32 TimeStepsFinished{ 0 };
+
+	TZombieConveyor<T> conveyor;
+	TSDDelay1<T> incubation_delay1;
+	TSDDelay3<T> incubation_delay3;
+
+	// Cohorts like the conveyor's, but at most TSDLeakyConveyor::MaxTransitSteps of them; a longer transit is cut short
+	TSDLeakyConveyor<T> incubation_leaky_conveyor;
+
+	// Bitten people who have not turned yet
+	T IncubatingContent(EZombieIncubation Incubation) const
+	{
+		switch (Incubation)
+		{
+		case EZombieIncubation::Delay1:        return incubation_delay1.Content();
+		case EZombieIncubation::Delay3:        return incubation_delay3.Content();
+		case EZombieIncubation::LeakyConveyor: return incubation_leaky_conveyor.Content();
+		default:                               return conveyor.Content();
+		}
+	}
+};
+
+using FZombieModelState = TZombieModelState<float>;
+
+// Auxiliaries and flows computed during one step, handy for logging and analysis
+template<typename T>
+struct TZombieModelAuxiliaries
+{
+	T population_density{ 0.f };
+	T population_density_effect_on_zombie_bites{ 0.f };
+	T number_of_bites_per_zombie_per_day{ 0.f };
+	T getting_bitten{ 0.f };
+	T becoming_infected{ 0.f };
+};
+
+using FZombieModelAuxiliaries = TZombieModelAuxiliaries<float>;
+
+// The constants of FZombieModelParams that are continuous, so derivatives can be taken with respect to them.
+// days_to_become_infected_from_bite only matters through its whole number of days and stays a float.
+template<typename T>
+struct TZombieModelRates
+{
+	T Bitten_capacity;
+	T CONVERSION_FROM_PEOPLE_TO_ZOMBIES;
+	T normal_number_of_bites;
+	T land_area;
+	T normal_population_density;
+
+	explicit TZombieModelRates(const FZombieModelParams& Params)
+		: Bitten_capacity(Params.Bitten_capacity)
+		, CONVERSION_FROM_PEOPLE_TO_ZOMBIES(Params.CONVERSION_FROM_PEOPLE_TO_ZOMBIES)
+		, normal_number_of_bites(Params.normal_number_of_bites)
+		, land_area(Params.land_area)
+		, normal_population_density(Params.normal_population_density)
+	{
+	}
+};
+
+// Win/lose conditions as evaluated at the end of a step
+struct FZombieStepOutcome
+{
+	bool bLose{ false };
+	bool bWin{ false };
+};
+
+// Flows of the Stella model: bites are rounded to whole people, conversions are exact.
+// StepZombieModel takes the flows as a policy so a stochastic variant can draw them instead.
+struct FZombieRoundedFlows
+{
+	template<typename T>
+	T TotalBites(const T& ExpectedBites) const { return ZombieMath::RoundToFloat(ExpectedBites); }
+
+	template<typename T>
+	T BitesOnSusceptible(const T& FractionSusceptible, const T& TotalBites) const { return ZombieMath::RoundToFloat(FractionSusceptible * TotalBites); }
+
+	template<typename T>
+	T Conversions(const T& People, const T& ConversionRate) const { return People * ConversionRate; }
+
+	// Most susceptible people that can be bitten, whole people only
+	template<typename T>
+	T Available(const T& Susceptible) const { return ZombieMath::Floor(Susceptible); }
+};
+
+// The expected values of the flows without any rounding. The higher-order integrators evaluate their
+// intermediate stages with these, so a stage does not jump by a whole person.
+struct FZombieExpectedFlows
+{
+	template<typename T>
+	T TotalBites(const T& ExpectedBites) const { return ExpectedBites; }
+
+	template<typename T>
+	T BitesOnSusceptible(const T& FractionSusceptible, const T& TotalBites) const { return FractionSusceptible * TotalBites; }
+
+	template<typename T>
+	T Conversions(const T& People, const T& ConversionRate) const { return People * ConversionRate; }
+
+	template<typename T>
+	T Available(const T& Susceptible) const { return Susceptible; }
+};
+
+// Flows drawn at random around the same expected values: a Poisson number of bites, split binomially
+// between susceptible and bitten people, and binomial conversions. Used for Monte-Carlo ensembles.
+struct ZOMBIEAPOCALYPSE_API FZombieStochasticFlows
+{
+	FRandomStream& Stream;
+
+	explicit FZombieStochasticFlows(FRandomStream& InStream) : Stream(InStream) {}
+
+	float TotalBites(float ExpectedBites) const { return Poisson(ExpectedBites); }
+	float BitesOnSusceptible(float FractionSusceptible, float TotalBites) const { return Binomial(TotalBites, FractionSusceptible); }
+	float Conversions(float People, float ConversionRate) const;
+	float Available(float Susceptible) const { return FMath::Floor(Susceptible); }
+
+	// Whole number of events with the given mean
+	float Poisson(float Mean) const;
+
+	// Successes out of RoundToInt(Trials) tries with the given probability
+	float Binomial(float Trials, float Probability) const;
+
+private:
+	float Gaussian() const;
+};
+
+// How a step of FZombieModelParams::DT is made up: NumSubsteps integration substeps of SubstepDays each,
+// together covering Days whole days
+struct FZombieStepSize
+{
+	int32 Days{ 1 };
+	int32 NumSubsteps{ 1 };
+	float SubstepDays{ 1.f };
+
+	explicit FZombieStepSize(float DT)
+	{
+		if (DT > 0.f && DT < 1.f)
+		{
+			NumSubsteps = FMath::Clamp(FMath::RoundToInt(1.f / DT), 1, 1000);
+			SubstepDays = 1.f / NumSubsteps;
+		}
+		else if (DT > 1.f)
+		{
+			Days = FMath::Max(1, FMath::RoundToInt(DT));
+			SubstepDays = static_cast<float>(Days);
+		}
+	}
+};
+
+// People getting bitten per day at the given stocks, with the auxiliaries on the way there.
+// The higher-order integrators evaluate this at intermediate stocks within a step.
+template<typename T, typename LookupType, typename FlowsType>
+T ZombieGettingBitten(const TZombieModelRates<T>& Rates, const T& Susceptible, const T& Bitten, const T& Zombies,
+	const LookupType& graph_lookup, const FlowsType& Flows, TZombieModelAuxiliaries<T>* OutAuxiliaries = nullptr)
+{
+	// Calculate auxiliaries
+	T non_zombie_population = Bitten + Susceptible;
+	T population_density = non_zombie_population / Rates.land_area;
+	T x = population_density / Rates.normal_population_density;
+
+	T population_density_effect_on_zombie_bites = graph_lookup(x);
+	T number_of_bites_per_zombie_per_day = Rates.normal_number_of_bites * population_density_effect_on_zombie_bites;
+	T total_bitten_per_day = Flows.TotalBites(Zombies * number_of_bites_per_zombie_per_day);
+
+	T denom = ZombieMath::Max(non_zombie_population, T(1.f));
+	T number_of_bites_from_total_zombies_on_susceptible = Flows.BitesOnSusceptible(Susceptible / denom, total_bitten_per_day);
+
+	if (OutAuxiliaries)
+	{
+		OutAuxiliaries->population_density = population_density;
+		OutAuxiliaries->population_density_effect_on_zombie_bites = population_density_effect_on_zombie_bites;
+		OutAuxiliaries->number_of_bites_per_zombie_per_day = number_of_bites_per_zombie_per_day;
+	}
+
+	// Enforce non-negative susceptible
+	return ZombieMath::Min(number_of_bites_from_total_zombies_on_susceptible, Flows.Available(Susceptible));
+}
+
+// Integrates the stocks over one substep of SubstepDays with Params.IntegrationMethod and moves the conveyor one slot,
+// or the incubation delay on by the substep.
+// Flows are rates per day, the stocks change by rate * SubstepDays. At 1 day with Euler this is the Stella step.
+template<typename T, typename LookupType, typename FlowsType>
+void IntegrateZombieModel(const FZombieModelParams& Params, const TZombieModelRates<T>& Rates, TZombieModelState<T>& State,
+	const LookupType& graph_lookup, TZombieModelAuxiliaries<T>* OutAuxiliaries, const FlowsType& Flows, float SubstepDays)
+{
+	T& Susceptible = State.Susceptible;
+	T& Bitten = State.Bitten;
+	T& Zombies = State.Zombies;
+	TZombieConveyor<T>& conveyor = State.conveyor;
+	const T h(SubstepDays);
+
+	const T incubation_days(Params.days_to_become_infected_from_bite);
+
+	Bitten = State.IncubatingContent(Params.Incubation);
+
+	// Stages of the incubation delay, copied out for the higher-order integrators, which move them by hand
+	constexpr int32 MaxDelayStages = 3;
+	const int32 NumDelayStages = Params.Incubation == EZombieIncubation::Delay1 ? 1 : Params.Incubation == EZombieIncubation::Delay3 ? 3 : 0;
+	T DelayStages[MaxDelayStages] = { T(0.f), T(0.f), T(0.f) };
+	T DelayStageTime(1.f);
+	if (Params.Incubation == EZombieIncubation::Delay1)
+	{
+		DelayStages[0] = State.incubation_delay1.Stages[0];
+		DelayStageTime = State.incubation_delay1.StageTime(incubation_days, SubstepDays);
+	}
+	else if (Params.Incubation == EZombieIncubation::Delay3)
+	{
+		for (int32 Stage = 0; Stage < 3; ++Stage)
+			DelayStages[Stage] = State.incubation_delay3.Stages[Stage];
+		DelayStageTime = State.incubation_delay3.StageTime(incubation_days, SubstepDays);
+	}
+
+	// People each delay stage lets out over the substep, when a higher-order integrator moved the delay
+	T DelayOutflows[MaxDelayStages] = { T(0.f), T(0.f), T(0.f) };
+
+	// Empties the conveyor cohort arriving this substep. The leaky conveyor loses its leakage at the same time,
+	// people who leave the model without turning.
+	T conveyor_leakage(0.f);
+	auto TakeConveyorOutflow = [&]() -> T
+	{
+		if (Params.Incubation == EZombieIncubation::LeakyConveyor)
+		{
+			TSDLeakyConveyor<T>& leaky_conveyor = State.incubation_leaky_conveyor;
+			leaky_conveyor.SetTransitSteps(TZombieConveyor<T>::TransitStepsFor(Params.days_to_become_infected_from_bite, SubstepDays),
+				TZombieConveyor<T>::LateFractionFor(Params.days_to_become_infected_from_bite, SubstepDays));
+			const T Outflow = leaky_conveyor.TakeOutflow();
+			conveyor_leakage = leaky_conveyor.Leak(T(Params.leakage_fraction * SubstepDays));
+			return Outflow;
+		}
+		conveyor.SetTransitTime(Params.days_to_become_infected_from_bite, SubstepDays);
+		return conveyor.TakeOutflow();
+	};
+
+	T getting_bitten;
+	T raw_outflow_people;
+	if (Params.IntegrationMethod == EZombieIntegrationMethod::Euler)
+	{
+		getting_bitten = ZombieGettingBitten(Rates, Susceptible, Bitten, Zombies, graph_lookup, Flows, OutAuxiliaries);
+
+		// Conveyor mechanics. A delay lets out its last stage over the substep instead.
+		switch (Params.Incubation)
+		{
+		case EZombieIncubation::Delay1:
+			raw_outflow_people = State.incubation_delay1.Outflow(incubation_days, SubstepDays) * h;
+			break;
+		case EZombieIncubation::Delay3:
+			raw_outflow_people = State.incubation_delay3.Outflow(incubation_days, SubstepDays) * h;
+			break;
+		default:
+			raw_outflow_people = TakeConveyorOutflow();
+			break;
+		}
+	}
+	else
+	{
+		// Every stage evaluates the bites, the delay stages' outflows and the zombies' growth again at the stocks
+		// part of the way along the substep, with expected flows so no stage is rounded to whole people.
+		// The conveyor lets a fixed cohort out over the substep, so its drain is the same at every stage, and so is
+		// the leakage of the leaky conveyor, taken from the cohorts in flight at the start of the substep.
+		// Long steps can overshoot, so the intermediate stocks are kept non-negative like the real ones.
+		T ConveyorDrain(0.f);
+		T ConveyorLeakage(0.f);
+		if (NumDelayStages == 0)
+		{
+			ConveyorDrain = TakeConveyorOutflow() / h;
+			ConveyorLeakage = conveyor_leakage / h;
+		}
+
+		struct FSlope
+		{
+			T Bites{ 0.f };
+			T DelayOut[MaxDelayStages]{};
+			T Drain{ 0.f };
+		};
+
+		const FZombieExpectedFlows Expected;
+		auto Evaluate = [&](const T& Along, const FSlope& Slope, TZombieModelAuxiliaries<T>* StageAuxiliaries)
+		{
+			FSlope Next;
+			T StageBitten = ZombieMath::Max(T(0.f), Bitten + Along * (Slope.Bites - ConveyorDrain - ConveyorLeakage));
+			if (NumDelayStages > 0)
+			{
+				StageBitten = T(0.f);
+				for (int32 Stage = 0; Stage < NumDelayStages; ++Stage)
+				{
+					const T& StageIn = Stage == 0 ? Slope.Bites : Slope.DelayOut[Stage - 1];
+					const T Content = ZombieMath::Max(T(0.f), DelayStages[Stage] + Along * (StageIn - Slope.DelayOut[Stage]));
+					Next.DelayOut[Stage] = Content / DelayStageTime;
+					StageBitten += Content;
+				}
+			}
+			Next.Drain = NumDelayStages > 0 ? Next.DelayOut[NumDelayStages - 1] : ConveyorDrain;
+
+			const T StageSusceptible = ZombieMath::Max(T(0.f), Susceptible - Along * Slope.Bites);
+			const T StageZombies = ZombieMath::Max(T(0.f), Zombies + Along * Expected.Conversions(Slope.Drain, Rates.CONVERSION_FROM_PEOPLE_TO_ZOMBIES));
+			Next.Bites = ZombieGettingBitten(Rates, StageSusceptible, StageBitten, StageZombies, graph_lookup, Expected, StageAuxiliaries);
+			return Next;
+		};
+
+		FSlope Mean;
+		auto Accumulate = [&Mean](const FSlope& Slope, float Weight)
+		{
+			Mean.Bites += Slope.Bites * T(Weight);
+			Mean.Drain += Slope.Drain * T(Weight);
+			for (int32 Stage = 0; Stage < MaxDelayStages; ++Stage)
+				Mean.DelayOut[Stage] += Slope.DelayOut[Stage] * T(Weight);
+		};
+
+		const FSlope k1 = Evaluate(T(0.f), FSlope(), OutAuxiliaries);
+		if (Params.IntegrationMethod == EZombieIntegrationMethod::RK2)
+		{
+			const FSlope k2 = Evaluate(h, k1, nullptr);
+			Accumulate(k1, 0.5f);
+			Accumulate(k2, 0.5f);
+		}
+		else
+		{
+			const FSlope k2 = Evaluate(h * T(0.5f), k1, nullptr);
+			const FSlope k3 = Evaluate(h * T(0.5f), k2, nullptr);
+			const FSlope k4 = Evaluate(h, k3, nullptr);
+			Accumulate(k1, 1.f / 6.f);
+			Accumulate(k2, 2.f / 6.f);
+			Accumulate(k3, 2.f / 6.f);
+			Accumulate(k4, 1.f / 6.f);
+		}
+
+		// Rounding to whole people belongs to the Stella step, Euler over a day. The higher-order integrators keep
+		// the expected bites, which is what they converge on as DT shrinks.
+		getting_bitten = ZombieMath::Min(ZombieMath::Max(T(0.f), Mean.Bites), Susceptible);
+
+		// A stage can't let out more than it holds; the first stage's inflow is only added after the capacity check
+		raw_outflow_people = ConveyorDrain * h;
+		T StageIn(0.f);
+		for (int32 Stage = 0; Stage < NumDelayStages; ++Stage)
+		{
+			DelayOutflows[Stage] = ZombieMath::Min(ZombieMath::Max(T(0.f), Mean.DelayOut[Stage] * h), DelayStages[Stage] + StageIn);
+			StageIn = DelayOutflows[Stage];
+			raw_outflow_people = StageIn;
+		}
+	}
+
+	// Convert outflow to zombies
+	T becoming_infected = Flows.Conversions(raw_outflow_people, Rates.CONVERSION_FROM_PEOPLE_TO_ZOMBIES);
+
+	// A step longer than a day can't bite more people than there are
+	T bitten_people = ZombieMath::Min(getting_bitten * h, Susceptible);
+
+	// Capacity check for new inflow. The outflow of a delay has not left it yet.
+	T current_content = NumDelayStages == 0 ? State.IncubatingContent(Params.Incubation) : Bitten - raw_outflow_people;
+	T free_cap = ZombieMath::Max(T(0.f), Rates.Bitten_capacity - current_content);
+	T inflow_people = ZombieMath::Max(T(0.f), ZombieMath::Min(bitten_people, free_cap));
+
+	if (NumDelayStages > 0 && Params.IntegrationMethod != EZombieIntegrationMethod::Euler)
+	{
+		// Move the delay by the stage outflows the integrator settled on
+		T StageIn = inflow_people;
+		for (int32 Stage = 0; Stage < NumDelayStages; ++Stage)
+		{
+			DelayStages[Stage] += StageIn - DelayOutflows[Stage];
+			StageIn = DelayOutflows[Stage];
+		}
+
+		if (Params.Incubation == EZombieIncubation::Delay1)
+			State.incubation_delay1.Stages[0] = DelayStages[0];
+		else
+		{
+			for (int32 Stage = 0; Stage < 3; ++Stage)
+				State.incubation_delay3.Stages[Stage] = DelayStages[Stage];
+		}
+	}
+	else
+	{
+		switch (Params.Incubation)
+		{
+		case EZombieIncubation::Delay1:
+			State.incubation_delay1.Step(inflow_people / h, incubation_days, SubstepDays);
+			break;
+		case EZombieIncubation::Delay3:
+			State.incubation_delay3.Step(inflow_people / h, incubation_days, SubstepDays);
+			break;
+		case EZombieIncubation::LeakyConveyor:
+			State.incubation_leaky_conveyor.AddInflowAndAdvance(inflow_people);
+			break;
+		default:
+			conveyor.AddInflowAndAdvance(inflow_people);
+			break;
+		}
+	}
+
+	// Update stocks
+	Susceptible = ZombieMath::Max(T(0.f), Susceptible - bitten_people);
+	Zombies = ZombieMath::Max(T(0.f), Zombies + becoming_infected);
+	Bitten = State.IncubatingContent(Params.Incubation);
+
+	if (OutAuxiliaries)
+	{
+		OutAuxiliaries->getting_bitten = getting_bitten;
+		OutAuxiliaries->becoming_infected = becoming_infected / h;
+	}
+}
+
+// Win/lose conditions of the stocks a step ended with, checked before the step is added to TimeStepsFinished
+template<typename T>
+FZombieStepOutcome CheckZombieOutcome(const FZombieModelParams& Params, const TZombieModelState<T>& State)
+{
+	FZombieStepOutcome Outcome;
+	Outcome.bLose = ZombieMath::Value(State.Susceptible) <= Params.LoseSusceptibleThreshold;
+	Outcome.bWin = ZombieMath::Value(State.Zombies) <= 0 || State.TimeStepsFinished > Params.WinDay;
+	return Outcome;
+}
+
+// One step of the stock-and-flow model over any number type: float for the game, TZombieDual for sensitivities.
+// A step is a day unless Params.DT is above 1, see FZombieStepSize. Auxiliaries are from the last substep.
+// graph_lookup maps population density / normal density to the effect on bites, as a T.
+template<typename T, typename LookupType, typename FlowsType = FZombieRoundedFlows>
+FZombieStepOutcome StepZombieModel(const FZombieModelParams& Params, const TZombieModelRates<T>& Rates, TZombieModelState<T>& State,
+	const LookupType& graph_lookup, TZombieModelAuxiliaries<T>* OutAuxiliaries = nullptr, const FlowsType& Flows = FlowsType())
+{
+	const FZombieStepSize StepSize(Params.DT);
+	for (int32 Substep = 0; Substep < StepSize.NumSubsteps; ++Substep)
+	{
+		IntegrateZombieModel(Params, Rates, State, graph_lookup, OutAuxiliaries, Flows, StepSize.SubstepDays);
+	}
+
+	//Check if win or lose.
+	const FZombieStepOutcome Outcome = CheckZombieOutcome(Params, State);
+
+	State.TimeStepsFinished += StepSize.Days;
+	return Outcome;
+}
+
+// Immutable copy of the stocks after a step, safe to hand to other systems and threads
+USTRUCT(BlueprintType)
+struct FZombieModelSnapshot
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Simulation")
+	float Susceptible{ 0.f };
+	UPROPERTY(BlueprintReadOnly, Category = "Simulation")
+	float Bitten{ 0.f };
+	UPROPERTY(BlueprintReadOnly, Category = "Simulation")
+	float Zombies{ 0.f };
+	UPROPERTY(BlueprintReadOnly, Category = "Simulation")
+	int32 TimeStepsFinished{ 0 };
+
+	UPROPERTY(BlueprintReadOnly, Category = "Simulation")
+	float population_density{ 0.f };
+	UPROPERTY(BlueprintReadOnly, Category = "Simulation")
+	float number_of_bites_per_zombie_per_day{ 0.f };
+	UPROPERTY(BlueprintReadOnly, Category = "Simulation")
+	float getting_bitten{ 0.f };
+	UPROPERTY(BlueprintReadOnly, Category = "Simulation")
+	float becoming_infected{ 0.f };
+
+	UPROPERTY(BlueprintReadOnly, Category = "Simulation")
+	bool bLose{ false };
+	UPROPERTY(BlueprintReadOnly, Category = "Simulation")
+	bool bWin{ false };
+};
+
+// Double-buffered snapshot with a generation counter. One thread publishes, any thread reads without locking:
+// the writer fills the buffer readers are not using and then bumps the generation, readers retry if the
+// generation moved while they were copying.
+class FZombieSnapshotBuffer
+{
+public:
+	void Publish(const FZombieModelSnapshot& Snapshot)
+	{
+		const uint64 Next = Generation.load(std::memory_order_relaxed) + 1;
+		// Keeps the previous publish ordered before we overwrite the older buffer
+		std::atomic_thread_fence(std::memory_order_release);
+		Buffers[Next & 1] = Snapshot;
+		Generation.store(Next, std::memory_order_release);
+	}
+
+	FZombieModelSnapshot Read() const
+	{
+		for (;;)
+		{
+			const uint64 Before = Generation.load(std::memory_order_acquire);
+			FZombieModelSnapshot Snapshot = Buffers[Before & 1];
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (Generation.load(std::memory_order_relaxed) == Before)
+				return Snapshot;
+		}
+	}
+
+	// Increases every time a snapshot is published
+	uint64 GetGeneration() const { return Generation.load(std::memory_order_acquire); }
+
+private:
+	FZombieModelSnapshot Buffers[2];
+	std::atomic<uint64> Generation{ 0 };
+};
+
+// GRAPH points: population_density_effect_on_zombie_bites
+struct ZOMBIEAPOCALYPSE_API FZombieGraph
+{
+	std::vector<std::pair<float, float>> graphPts;
+
+	// Piecewise linear lookup. Uses the baked table when there is one, otherwise scans graphPts.
+	// Inline, since the model steps and the data-driven engine call it from other files once per step.
+	FORCEINLINE float graph_lookup(float xIn) const
+	{
+		if (!IsBaked())
+			return graph_lookup_scan(xIn);
+
+		const float u = FMath::Clamp((xIn - BakedMinX) * BakedInvStep, 0.f, BakedMaxIndex);
+		const int32 i = static_cast<int32>(u);
+		return BakedValues[i] + BakedSlopes[i] * (u - static_cast<float>(i));
+	}
+
+	// Evaluates Num x values at once, four at a time with SIMD when the table is baked
+	void graph_lookup_batch(const float* xIn, float* yOut, int32 Num) const;
+
+	// Bakes graphPts into a uniform table so a lookup is one index and one lerp.
+	// Evenly spaced points are used as they are, anything else is resampled into Resolution intervals.
+	void Bake(int32 Resolution = 256);
+	bool IsBaked() const { return !BakedValues.empty(); }
+
+	// Bakes again at the same resolution after the points were changed in place. Reuses the table, so it does not allocate.
+	void Rebake()
+	{
+		if (IsBaked())
+			Bake(static_cast<int32>(BakedMaxIndex));
+	}
+
+	// Reads every FPopulationDensityEffect row of the table, in row order
+	void ReadFromDataTable(const UDataTable& Table);
+
+	// Reads a CSV in the PopulationDensityEffect.csv layout (row name, x, y)
+	bool ReadFromCsvFile(const FString& FilePath);
+
+	// The points and the baked table as one flat float array, see UZombieCurveAsset. Reading it back is a
+	// copy per array, nothing is parsed or baked again. ReadCooked returns false for data it cannot use.
+	void WriteCooked(TArray<float>& OutData) const;
+	bool ReadCooked(const TArray<float>& Data);
+
+private:
+	float graph_lookup_scan(float xIn) const;
+
+	// y at BakedMinX + i / BakedInvStep, and the change in y to the next entry (0 for the last one)
+	std::vector<float> BakedValues;
+	std::vector<float> BakedSlopes;
+	float BakedMinX{ 0.f };
+	float BakedInvStep{ 0.f };
+	float BakedMaxIndex{ 0.f };
+};
+
+// Result of stepping a copy of the model ahead of the game
+USTRUCT(BlueprintType)
+struct FZombieForecast
+{
+	GENERATED_BODY()
+
+	// TimeStepsFinished when the forecast was made
+	UPROPERTY(BlueprintReadOnly, Category = "Forecast")
+	int32 StartDay{ 0 };
+
+	// Stocks after each forecast step (a day unless DT is above 1), the first entry is StartDay + 1
+	UPROPERTY(BlueprintReadOnly, Category = "Forecast")
+	TArray<FZombieModelSnapshot> Trajectory;
+
+	// Day (time steps finished) when Lose/Win would first trigger, -1 if not within the forecast
+	UPROPERTY(BlueprintReadOnly, Category = "Forecast")
+	int32 LoseDay{ -1 };
+	UPROPERTY(BlueprintReadOnly, Category = "Forecast")
+	int32 WinDay{ -1 };
+};
+
+// "What if" change applied to a copy of the model before forecasting
+USTRUCT(BlueprintType)
+struct FZombieCounterfactual
+{
+	GENERATED_BODY()
+
+	// Added to the stocks, e.g. -10 Zombies for "the player kills 10 zombies now"
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Forecast")
+	float SusceptibleChange{ 0.f };
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Forecast")
+	float ZombiesChange{ 0.f };
+
+	// Bitten people taken off the conveyor, the ones closest to turning first
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Forecast", meta = (ClampMin = "0"))
+	float BittenRemoved{ 0.f };
+
+	bool operator==(const FZombieCounterfactual& Other) const
+	{
+		return SusceptibleChange == Other.SusceptibleChange && ZombiesChange == Other.ZombiesChange && BittenRemoved == Other.BittenRemoved;
+	}
+};
+
+// Summary of a headless run
+struct FZombieRunResult
+{
+	float FinalSusceptible{ 0.f };
+	float FinalBitten{ 0.f };
+	float FinalZombies{ 0.f };
+	int32 DaysRun{ 0 };
+
+	// Day (time steps finished) when Lose/Win first triggered, -1 if never
+	int32 LoseDay{ -1 };
+	int32 WinDay{ -1 };
+};
+
+// Actor-free stock-and-flow model. Cheap to copy, so sweeps and forecasts
+// simply take a copy of a configured model and step it.
+class ZOMBIEAPOCALYPSE_API FZombieModel
+{
+public:
+	FZombieModelParams Params;
+	FZombieModelState State;
+
+	// Shared between copies, the curve is never modified after it is loaded
+	TSharedPtr<const FZombieGraph> Graph;
+
+	// Advances the model one step, a day unless Params.DT is above 1, and adds the days to TimeStepsFinished
+	FZombieStepOutcome RunSimulationStep(FZombieModelAuxiliaries* OutAuxiliaries = nullptr);
+
+	// Same as RunSimulationStep with the flows drawn from Stream, see FZombieStochasticFlows
+	FZombieStepOutcome RunStochasticStep(FRandomStream& Stream, FZombieModelAuxiliaries* OutAuxiliaries = nullptr);
+
+	// Steps until both Lose and Win have been seen or MaxDays have run.
+	// With bStopAtFirstOutcome the run ends as soon as either one triggers.
+	FZombieRunResult Run(int32 MaxDays, bool bStopAtFirstOutcome = false);
+
+	float conveyor_content() const;
+	float graph_lookup(float xIn) const;
+
+	// Steps DaysAhead days and records every step into OutForecast, reusing its trajectory allocation
+	void Forecast(int32 DaysAhead, FZombieForecast& OutForecast);
+
+	// Applies a counterfactual to the current stocks and conveyor
+	void Apply(const FZombieCounterfactual& Change);
+
+	// Takes bitten people out of a conveyor cohort, e.g. when they die before turning. The incubation
+	// delays have no cohorts, there they come off the people closest to turning.
+	void RemoveBitten(int32 Cohort, float AmountOfPeople);
+
+	// Same constants, curve and state, i.e. stepping either gives the same result
+	bool HasSameInputs(const FZombieModel& Other) const;
+
+	// Current stocks together with the auxiliaries and outcome of the step that produced them
+	FZombieModelSnapshot MakeSnapshot(const FZombieModelAuxiliaries& Auxiliaries, const FZombieStepOutcome& Outcome) const;
+};
@@ -0,0 +1,23 @@
+#include "ZombieParametersAsset.h"
+
+void UZombieParametersAsset::ApplyTo(FZombieModel& Model) const
+{
+    Model.Params = Params;
+    if (TSharedPtr<FZombieGraph> Graph = MakeGraph())
+        Model.Graph = Graph;
+}
+
+TSharedPtr<FZombieGraph> UZombieParametersAsset::MakeGraph() const
+{
+    if (CurvePoints.Num() == 0)
+        return nullptr;
+
+    TSharedPtr<FZombieGraph> Graph = MakeShared<FZombieGraph>();
+    Graph->graphPts.reserve(CurvePoints.Num());
+    for (const FVector2D& Point : CurvePoints)
+        Graph->graphPts.emplace_back(static_cast<float>(Point.X), static_cast<float>(Point.Y));
+
+    if (BakeResolution > 0)
+        Graph->Bake(BakeResolution);
+    return Graph;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "ZombieModel.h"
+#include "ZombieParametersAsset.generated.h"
+
+/**
+ * Constants and lookup curve of the model as one asset, e.g. fitted to recorded play sessions by the
+ * ZombieCalibrate commandlet. Commandlets run with it through -Parameters=<object path>.
+ */
+UCLASS(BlueprintType)
+class ZOMBIEAPOCALYPSE_API UZombieParametersAsset : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Model")
+	FZombieModelParams Params;
+
+	// x (population density) and y of every curve point, in order. Empty keeps the curve of the model it is applied to.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Model")
+	TArray<FVector2D> CurvePoints;
+
+	// Intervals used when the points are not evenly spaced and have to be resampled, 0 keeps the curve unbaked
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Model", meta = (ClampMin = "0"))
+	int32 BakeResolution{ 256 };
+
+	// Mean squared error per recorded day and stock against the recordings it was fitted to
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Calibration")
+	float Error{ 0.f };
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Calibration")
+	TArray<FString> SourceFiles;
+
+	// Replaces the constants of Model, and its curve when the asset has one
+	void ApplyTo(FZombieModel& Model) const;
+
+	// Builds the graph from CurvePoints, nullptr when there are none
+	TSharedPtr<FZombieGraph> MakeGraph() const;
+};
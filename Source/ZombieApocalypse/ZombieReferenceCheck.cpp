@@ -0,0 +1,436 @@
+#include "ZombieReferenceCheck.h"
+#include "ZombieCommandletHelpers.h"
+#include "ZombieSDModel.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformTime.h"
+
+namespace ZombieReferenceCheck
+{
+    using FRow = FZombieReferenceCheck::FRow;
+
+    static const TCHAR* StockNames[] = { TEXT("Susceptible"), TEXT("Bitten"), TEXT("Zombies") };
+
+    static bool LoadReference(const FString& FilePath, TArray<FRow>& OutRows)
+    {
+        TArray<FString> Lines;
+        if (!FFileHelper::LoadFileToStringArray(Lines, *FilePath) || Lines.Num() < 2)
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieReferenceCheck: Could not read reference %s. Put a table of Days, Susceptible, Bitten and Zombies there or pass -Reference=."), *FilePath);
+            return false;
+        }
+
+        const TCHAR* Separator = Lines[0].Contains(TEXT("\t")) ? TEXT("\t") : TEXT(",");
+
+        // Time is the first column, the stocks are found by name
+        TArray<FString> Header;
+        Lines[0].ParseIntoArray(Header, Separator, false);
+        int32 StockColumns[3] = { INDEX_NONE, INDEX_NONE, INDEX_NONE };
+        for (int32 Column = 1; Column < Header.Num(); ++Column)
+        {
+            const FString Name = Header[Column].TrimStartAndEnd().TrimQuotes();
+            for (int32 Stock = 0; Stock < 3; ++Stock)
+            {
+                if (Name.Contains(StockNames[Stock]))
+                    StockColumns[Stock] = Column;
+            }
+        }
+
+        for (int32 Stock = 0; Stock < 3; ++Stock)
+        {
+            if (StockColumns[Stock] == INDEX_NONE)
+            {
+                UE_LOG(LogTemp, Error, TEXT("ZombieReferenceCheck: %s has no %s column"), *FilePath, StockNames[Stock]);
+                return false;
+            }
+        }
+
+        for (int32 Line = 1; Line < Lines.Num(); ++Line)
+        {
+            TArray<FString> Values;
+            Lines[Line].ParseIntoArray(Values, Separator, false);
+            if (Values.Num() < Header.Num())
+                continue;
+
+            FRow Row;
+            Row.Day = FMath::RoundToInt(FCString::Atof(*Values[0].TrimStartAndEnd().TrimQuotes()));
+            Row.Susceptible = FCString::Atof(*Values[StockColumns[0]].TrimStartAndEnd());
+            Row.Bitten = FCString::Atof(*Values[StockColumns[1]].TrimStartAndEnd());
+            Row.Zombies = FCString::Atof(*Values[StockColumns[2]].TrimStartAndEnd());
+            OutRows.Add(Row);
+        }
+
+        OutRows.Sort([](const FRow& A, const FRow& B) { return A.Day < B.Day; });
+        return OutRows.Num() > 0;
+    }
+
+    // Every value the controller publishes after a step, compared bit for bit
+    static bool SameSnapshot(const FZombieModelSnapshot& A, const FZombieModelSnapshot& B)
+    {
+        return A.Susceptible == B.Susceptible && A.Bitten == B.Bitten && A.Zombies == B.Zombies && A.TimeStepsFinished == B.TimeStepsFinished
+            && A.population_density == B.population_density && A.number_of_bites_per_zombie_per_day == B.number_of_bites_per_zombie_per_day
+            && A.getting_bitten == B.getting_bitten && A.becoming_infected == B.becoming_infected && A.bLose == B.bLose && A.bWin == B.bWin;
+    }
+
+    // Fixed scalar work with the op mix of a model step: multiplies, a divide, a floor, a min and a table lookup.
+    // It never changes with the model, so timing the step against it cancels out how fast the machine is.
+    // Returns ns per iteration, best of 5 batches like the step.
+    static double TimeReferenceKernel(int64 Iterations, float& Checksum)
+    {
+        static const float Table[16] = { 0.f, 0.1f, 0.25f, 0.45f, 0.7f, 1.f, 1.3f, 1.6f, 1.85f, 2.05f, 2.2f, 2.3f, 2.38f, 2.44f, 2.48f, 2.5f };
+
+        double BestNsPerIteration = TNumericLimits<double>::Max();
+        for (int32 Batch = 0; Batch < 5; ++Batch)
+        {
+            const double StartTime = FPlatformTime::Seconds();
+            float X = 0.5f;
+            for (int64 Iteration = 0; Iteration < Iterations; ++Iteration)
+            {
+                const float Scaled = X * 15.f;
+                const int32 Index = FMath::Min(FMath::FloorToInt(Scaled), 14);
+                const float Lookup = FMath::Lerp(Table[Index], Table[Index + 1], Scaled - Index);
+                X = FMath::Frac(X * 3.7f + Lookup / (1.f + X) + 0.1f);
+            }
+            Checksum += X;
+            const double Elapsed = FPlatformTime::Seconds() - StartTime;
+            BestNsPerIteration = FMath::Min(BestNsPerIteration, Elapsed * 1.e9 / static_cast<double>(FMath::Max<int64>(Iterations, 1)));
+        }
+        return BestNsPerIteration;
+    }
+
+    // Runs a copy of Model with the given integrator for Days days and records the stocks after every step
+    static void RunWithIntegrator(FZombieModel Model, EZombieIntegrationMethod Method, float DT, int32 Days, TArray<FRow>& OutRows)
+    {
+        Model.Params.IntegrationMethod = Method;
+        Model.Params.DT = DT;
+
+        const int32 LastDay = Model.State.TimeStepsFinished + Days;
+        OutRows.Reset();
+        OutRows.Add({ Model.State.TimeStepsFinished, Model.State.Susceptible, Model.State.Bitten, Model.State.Zombies });
+        while (Model.State.TimeStepsFinished < LastDay)
+        {
+            Model.RunSimulationStep();
+            OutRows.Add({ Model.State.TimeStepsFinished, Model.State.Susceptible, Model.State.Bitten, Model.State.Zombies });
+        }
+    }
+}
+
+bool FZombieReferenceCheck::Load(const FString& InParams)
+{
+    using namespace ZombieReferenceCheck;
+
+    Params = InParams;
+    if (!ZombieCommandlets::LoadBaseModel(Params, BaseModel))
+        return false;
+
+    FString ReferencePath(TEXT("ZombieReference.csv"));
+    FParse::Value(*Params, TEXT("Reference="), ReferencePath);
+    if (FPaths::IsRelative(ReferencePath))
+        ReferencePath = FPaths::ProjectDir() / ReferencePath;
+
+    Reference.Reset();
+    if (!LoadReference(ReferencePath, Reference))
+        return false;
+
+    Days = 180;
+    FParse::Value(*Params, TEXT("Days="), Days);
+    Days = FMath::Max(Days, Reference.Last().Day);
+    return true;
+}
+
+bool FZombieReferenceCheck::CheckTrajectory() const
+{
+    using namespace ZombieReferenceCheck;
+
+    float Tolerance = 0.5f;
+    FParse::Value(*Params, TEXT("Tolerance="), Tolerance);
+
+    bool bTrajectoryPassed = true;
+    float MaxError[3] = { 0.f, 0.f, 0.f };
+    int32 RowIndex = 0;
+
+    FZombieModel Model = BaseModel;
+    for (int32 Day = 0; Day <= Days; ++Day)
+    {
+        // Stocks after Day steps are the reference row for time Day, like a Stella table export
+        for (; RowIndex < Reference.Num() && Reference[RowIndex].Day <= Day; ++RowIndex)
+        {
+            const FRow& Row = Reference[RowIndex];
+            if (Row.Day != Day)
+                continue;
+
+            const float Expected[3] = { Row.Susceptible, Row.Bitten, Row.Zombies };
+            const float Actual[3] = { Model.State.Susceptible, Model.State.Bitten, Model.State.Zombies };
+            for (int32 Stock = 0; Stock < 3; ++Stock)
+            {
+                const float Error = FMath::Abs(Actual[Stock] - Expected[Stock]);
+                MaxError[Stock] = FMath::Max(MaxError[Stock], Error);
+
+                if (Error > Tolerance)
+                {
+                    if (bTrajectoryPassed)
+                    {
+                        UE_LOG(LogTemp, Error, TEXT("ZombieReferenceCheck: Day %d %s is %.3f, the reference has %.3f"),
+                            Day, StockNames[Stock], Actual[Stock], Expected[Stock]);
+                    }
+                    bTrajectoryPassed = false;
+                }
+            }
+        }
+
+        if (Day < Days)
+            Model.RunSimulationStep();
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("ZombieReferenceCheck: %d reference days, max error Susceptible %.3f, Bitten %.3f, Zombies %.3f (tolerance %.3f)"),
+        Reference.Num(), MaxError[0], MaxError[1], MaxError[2], Tolerance);
+
+    return bTrajectoryPassed;
+}
+
+bool FZombieReferenceCheck::CheckEngine() const
+{
+    using namespace ZombieReferenceCheck;
+
+    // The controller can step the zombie model compiled from its description, which has to step exactly like the
+    // hand-written one. The engine integrates with Euler, so only the Stella step of one day with the conveyor is
+    // compiled; the controller steps anything else by hand.
+    if (!FZombieSDStepper::CanStep(BaseModel.Params))
+        return true;
+
+    FSDModel Engine;
+    bool bEnginePassed = ZombieSD::Compile(BaseModel, Engine);
+
+    FSDModel Compiled = Engine;
+    const int32 Slots[3] = { Compiled.FindSlot(StockNames[0]), Compiled.FindSlot(StockNames[1]), Compiled.FindSlot(StockNames[2]) };
+    FZombieModel Model = BaseModel;
+    for (int32 Day = 0; Day < Days && bEnginePassed; ++Day)
+    {
+        Model.RunSimulationStep();
+        Compiled.Step();
+
+        const float Expected[3] = { Model.State.Susceptible, Model.State.Bitten, Model.State.Zombies };
+        for (int32 Stock = 0; Stock < 3; ++Stock)
+        {
+            if (Compiled.GetValue(Slots[Stock]) != Expected[Stock])
+            {
+                UE_LOG(LogTemp, Error, TEXT("ZombieReferenceCheck: Day %d %s is %.3f in the data-driven engine, %.3f in FZombieModel"),
+                    Model.State.TimeStepsFinished, StockNames[Stock], Compiled.GetValue(Slots[Stock]), Expected[Stock]);
+                bEnginePassed = false;
+                break;
+            }
+        }
+    }
+
+    // Again the way the controller steps it, where the snapshot and the conveyor cohorts have to match too
+    Model = BaseModel;
+    FZombieModel Stepped = BaseModel;
+    FZombieSDStepper Stepper;
+    for (int32 Day = 0; Day < Days && bEnginePassed; ++Day)
+    {
+        FZombieModelAuxiliaries ExpectedAuxiliaries;
+        const FZombieStepOutcome ExpectedOutcome = Model.RunSimulationStep(&ExpectedAuxiliaries);
+        FZombieModelAuxiliaries Auxiliaries;
+        const FZombieStepOutcome Outcome = Stepper.Step(Stepped, &Auxiliaries);
+
+        const FZombieModelSnapshot Expected = Model.MakeSnapshot(ExpectedAuxiliaries, ExpectedOutcome);
+        const FZombieModelSnapshot Actual = Stepped.MakeSnapshot(Auxiliaries, Outcome);
+        if (!SameSnapshot(Actual, Expected) || !(Stepped.State.conveyor == Model.State.conveyor))
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieReferenceCheck: Day %d differs between FZombieSDStepper and FZombieModel: Susceptible %.3f/%.3f, Bitten %.3f/%.3f, Zombies %.3f/%.3f, getting_bitten %.3f/%.3f"),
+                Expected.TimeStepsFinished, Actual.Susceptible, Expected.Susceptible, Actual.Bitten, Expected.Bitten,
+                Actual.Zombies, Expected.Zombies, Actual.getting_bitten, Expected.getting_bitten);
+            bEnginePassed = false;
+        }
+    }
+
+    if (bEnginePassed)
+    {
+        UE_LOG(LogTemp, Display, TEXT("ZombieReferenceCheck: Data-driven engine matches FZombieModel over %d days (%d instructions per step)"),
+            Days, Engine.GetTapeLength());
+    }
+
+    return bEnginePassed;
+}
+
+bool FZombieReferenceCheck::CheckIntegrators() const
+{
+    using namespace ZombieReferenceCheck;
+
+    // Every integrator against a fine-DT RK4 run, to see what a coarser or faster setting costs. Euler is only
+    // reported, it is the Stella step and rounds to whole people; RK2 and RK4, which fast-forwarding is meant to
+    // use, may not stray further from the fine run than IntegratorTolerance of the population.
+    float FineDT = 1.f / 64.f;
+    FParse::Value(*Params, TEXT("FineDT="), FineDT);
+
+    float IntegratorTolerance = 0.1f;
+    FParse::Value(*Params, TEXT("IntegratorTolerance="), IntegratorTolerance);
+    const float Population = BaseModel.State.Susceptible + BaseModel.State.Bitten + BaseModel.State.Zombies;
+    bool bIntegratorsPassed = true;
+
+    TArray<FRow> Fine;
+    RunWithIntegrator(BaseModel, EZombieIntegrationMethod::RK4, FineDT, Days, Fine);
+
+    const EZombieIntegrationMethod Methods[] = { EZombieIntegrationMethod::Euler, EZombieIntegrationMethod::RK2, EZombieIntegrationMethod::RK4 };
+    const float StepSizes[] = { 7.f, 2.f, 1.f, 0.5f, 0.25f };
+
+    TArray<FRow> Coarse;
+    for (const EZombieIntegrationMethod Method : Methods)
+    {
+        for (const float DT : StepSizes)
+        {
+            const double StartTime = FPlatformTime::Seconds();
+            RunWithIntegrator(BaseModel, Method, DT, Days, Coarse);
+            const double NsPerDay = (FPlatformTime::Seconds() - StartTime) * 1.e9 / FMath::Max(Days, 1);
+
+            // Fine has a row for every day, Coarse one per step
+            float IntegratorError[3] = { 0.f, 0.f, 0.f };
+            for (const FRow& Row : Coarse)
+            {
+                const int32 FineIndex = Row.Day - Fine[0].Day;
+                if (!Fine.IsValidIndex(FineIndex))
+                    continue;
+
+                IntegratorError[0] = FMath::Max(IntegratorError[0], FMath::Abs(Row.Susceptible - Fine[FineIndex].Susceptible));
+                IntegratorError[1] = FMath::Max(IntegratorError[1], FMath::Abs(Row.Bitten - Fine[FineIndex].Bitten));
+                IntegratorError[2] = FMath::Max(IntegratorError[2], FMath::Abs(Row.Zombies - Fine[FineIndex].Zombies));
+            }
+
+            UE_LOG(LogTemp, Display, TEXT("ZombieReferenceCheck: %s DT %.2f, max difference to RK4 DT %.4f: Susceptible %.3f, Bitten %.3f, Zombies %.3f, %.1f ns per day"),
+                *StaticEnum<EZombieIntegrationMethod>()->GetNameStringByValue(static_cast<int64>(Method)), DT, FineDT,
+                IntegratorError[0], IntegratorError[1], IntegratorError[2], NsPerDay);
+
+            const float MaxIntegratorError = FMath::Max3(IntegratorError[0], IntegratorError[1], IntegratorError[2]);
+            if (Method != EZombieIntegrationMethod::Euler && MaxIntegratorError > IntegratorTolerance * Population)
+            {
+                UE_LOG(LogTemp, Error, TEXT("ZombieReferenceCheck: %s DT %.2f is %.3f people off the fine run, allowed %.3f"),
+                    *StaticEnum<EZombieIntegrationMethod>()->GetNameStringByValue(static_cast<int64>(Method)), DT,
+                    MaxIntegratorError, IntegratorTolerance * Population);
+                bIntegratorsPassed = false;
+            }
+        }
+    }
+
+    return bIntegratorsPassed;
+}
+
+bool FZombieReferenceCheck::CheckTiming() const
+{
+    using namespace ZombieReferenceCheck;
+
+    int32 TimingRuns = 2000;
+    FParse::Value(*Params, TEXT("TimingRuns="), TimingRuns);
+    if (TimingRuns <= 0)
+        return true;
+
+    bool bTimingPassed = true;
+
+    // Best of several batches, so a busy machine does not fail the gate on its own
+    double BestNsPerStep = TNumericLimits<double>::Max();
+    float Checksum = 0.f;
+    for (int32 Batch = 0; Batch < 5; ++Batch)
+    {
+        const double StartTime = FPlatformTime::Seconds();
+        for (int32 Run = 0; Run < TimingRuns; ++Run)
+        {
+            FZombieModel Timed = BaseModel;
+            for (int32 Day = 0; Day < Days; ++Day)
+                Timed.RunSimulationStep();
+            Checksum += Timed.State.Zombies;
+        }
+        const double Elapsed = FPlatformTime::Seconds() - StartTime;
+        BestNsPerStep = FMath::Min(BestNsPerStep, Elapsed * 1.e9 / (static_cast<double>(TimingRuns) * Days));
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("ZombieReferenceCheck: %.1f ns per step (checksum %f)"), BestNsPerStep, Checksum);
+
+    // Same runs the way the controller steps them with bStepCompiledModel. Only gated when asked for, the flag
+    // stays off until this is no slower on the target machine.
+    if (FZombieSDStepper::CanStep(BaseModel.Params))
+    {
+        float MaxEngineSlowdown = 0.f;
+        FParse::Value(*Params, TEXT("MaxEngineSlowdown="), MaxEngineSlowdown);
+
+        double BestEngineNsPerStep = TNumericLimits<double>::Max();
+        Checksum = 0.f;
+        FZombieSDStepper Stepper;
+        for (int32 Batch = 0; Batch < 5; ++Batch)
+        {
+            const double StartTime = FPlatformTime::Seconds();
+            for (int32 Run = 0; Run < TimingRuns; ++Run)
+            {
+                FZombieModel Timed = BaseModel;
+                for (int32 Day = 0; Day < Days; ++Day)
+                    Stepper.Step(Timed);
+                Checksum += Timed.State.Zombies;
+            }
+            const double Elapsed = FPlatformTime::Seconds() - StartTime;
+            BestEngineNsPerStep = FMath::Min(BestEngineNsPerStep, Elapsed * 1.e9 / (static_cast<double>(TimingRuns) * Days));
+        }
+
+        UE_LOG(LogTemp, Display, TEXT("ZombieReferenceCheck: Data-driven engine %.1f ns per step, x%.2f of FZombieModel (checksum %f)"),
+            BestEngineNsPerStep, BestEngineNsPerStep / BestNsPerStep, Checksum);
+
+        if (MaxEngineSlowdown > 0.f && BestEngineNsPerStep > BestNsPerStep * MaxEngineSlowdown)
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieReferenceCheck: Data-driven engine step takes %.1f ns, FZombieModel %.1f ns (allowed x%.2f)"),
+                BestEngineNsPerStep, BestNsPerStep, MaxEngineSlowdown);
+            bTimingPassed = false;
+        }
+    }
+
+    // The step is gated on its time over the reference kernel's, measured in this run, so the gate does not
+    // depend on how fast the machine is. The baseline of that ratio is still kept per machine under Saved,
+    // since compilers and CPUs do not speed both up the same way.
+    const double KernelNsPerIteration = TimeReferenceKernel(static_cast<int64>(TimingRuns) * Days, Checksum);
+    const double StepRatio = BestNsPerStep / FMath::Max(KernelNsPerIteration, UE_DOUBLE_SMALL_NUMBER);
+    UE_LOG(LogTemp, Display, TEXT("ZombieReferenceCheck: Reference kernel %.1f ns per iteration, step x%.3f of it (checksum %f)"),
+        KernelNsPerIteration, StepRatio, Checksum);
+
+    FString BaselinePath = FPaths::ProjectSavedDir() / TEXT("ZombieStepTiming.txt");
+    FParse::Value(*Params, TEXT("Baseline="), BaselinePath);
+    if (FPaths::IsRelative(BaselinePath))
+        BaselinePath = FPaths::ProjectDir() / BaselinePath;
+
+    float MaxSlowdown = 1.25f;
+    FParse::Value(*Params, TEXT("MaxSlowdown="), MaxSlowdown);
+
+    bool bUpdateBaseline = FParse::Param(*Params, TEXT("UpdateBaseline"));
+    FString BaselineText;
+    if (FFileHelper::LoadFileToString(BaselineText, *BaselinePath))
+    {
+        const double BaselineRatio = FCString::Atod(*BaselineText);
+        if (BaselineRatio <= 0.0)
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieReferenceCheck: Baseline %s holds no timing, rewrite it with -UpdateBaseline"), *BaselinePath);
+            bTimingPassed = bUpdateBaseline;
+        }
+        else if (StepRatio > BaselineRatio * MaxSlowdown)
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieReferenceCheck: Step takes x%.3f of the reference kernel, baseline is x%.3f (allowed x%.2f)"),
+                StepRatio, BaselineRatio, MaxSlowdown);
+            bTimingPassed = false;
+        }
+    }
+    else
+    {
+        // First run on this machine: there is nothing to compare against yet, so this run becomes the baseline
+        UE_LOG(LogTemp, Warning, TEXT("ZombieReferenceCheck: No baseline at %s yet, recording this run's timing"), *BaselinePath);
+        bUpdateBaseline = true;
+    }
+
+    if (bUpdateBaseline)
+    {
+        if (!FFileHelper::SaveStringToFile(FString::Printf(TEXT("%.4f"), StepRatio), *BaselinePath))
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieReferenceCheck: Could not write baseline %s"), *BaselinePath);
+            bTimingPassed = false;
+        }
+        else
+        {
+            UE_LOG(LogTemp, Display, TEXT("ZombieReferenceCheck: Wrote baseline %s"), *BaselinePath);
+        }
+    }
+
+    return bTimingPassed;
+}
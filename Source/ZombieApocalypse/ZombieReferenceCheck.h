@@ -0,0 +1,43 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZombieModel.h"
+
+// The checks of the ZombieReferenceCheck commandlet, also run by the ZombieApocalypse.Model.Reference automation
+// tests. Options come from a commandlet parameter string, see UZombieReferenceCheckCommandlet for the switches.
+// Every check logs what it found and returns false when it fails.
+class ZOMBIEAPOCALYPSE_API FZombieReferenceCheck
+{
+public:
+	// Loads the model (ZombieCommandlets::LoadBaseModel) and the reference table
+	bool Load(const FString& InParams);
+
+	// Headless run against the reference table
+	bool CheckTrajectory() const;
+
+	// FSDModel and FZombieSDStepper step the model exactly like FZombieModel. Passes when the settings are not compiled.
+	bool CheckEngine() const;
+
+	// Every integrator and DT against a fine-DT RK4 run, RK2 and RK4 within a tolerance
+	bool CheckIntegrators() const;
+
+	// Step time against this machine's baseline, and the stepper's against the hand-written step
+	bool CheckTiming() const;
+
+	// Stocks at the start of Day
+	struct FRow
+	{
+		int32 Day;
+		float Susceptible;
+		float Bitten;
+		float Zombies;
+	};
+
+private:
+	FString Params;
+	FZombieModel BaseModel;
+	TArray<FRow> Reference;
+
+	// Days every check runs, at least the last reference day
+	int32 Days{ 180 };
+};
@@ -0,0 +1,32 @@
+#include "ZombieReferenceCheckCommandlet.h"
+#include "ZombieReferenceCheck.h"
+
+UZombieReferenceCheckCommandlet::UZombieReferenceCheckCommandlet()
+{
+    IsClient = false;
+    IsEditor = false;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 UZombieReferenceCheckCommandlet::Main(const FString& Params)
+{
+    FZombieReferenceCheck Check;
+    if (!Check.Load(Params))
+        return 1;
+
+    // Every check runs even after one fails, so a single run reports everything that is off
+    const bool bTrajectoryPassed = Check.CheckTrajectory();
+    const bool bEnginePassed = Check.CheckEngine();
+    const bool bIntegratorsPassed = !FParse::Param(*Params, TEXT("Integrators")) || Check.CheckIntegrators();
+    const bool bTimingPassed = Check.CheckTiming();
+
+    if (!bTrajectoryPassed || !bEnginePassed || !bIntegratorsPassed || !bTimingPassed)
+    {
+        UE_LOG(LogTemp, Error, TEXT("ZombieReferenceCheck: FAILED"));
+        return 1;
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("ZombieReferenceCheck: Passed"));
+    return 0;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ZombieReferenceCheckCommandlet.generated.h"
+
+/**
+ * Regression gate for FZombieModel: compares a headless run against a recorded trajectory, checks that the
+ * data-driven engine (FSDModel), and FZombieSDStepper that the controller can step it with, step the zombie model
+ * exactly the same, then times both steps. Returns non-zero when any check fails.
+ *
+ * ZombieReference.csv is days 0 to 180 of the hand-written port the game shipped with, at the default controller
+ * settings. It catches any change to the model's output, but it is not a Stella export, so it says nothing about
+ * how close the port is to Stella. Pass a Stella table export with -Reference= for that.
+ *
+ * The checks live in FZombieReferenceCheck and also run as the ZombieApocalypse.Model.Reference automation tests.
+ *
+ * Example:
+ *   UnrealEditor-Cmd ZombieApocalypse.uproject -run=ZombieReferenceCheck -Reference=ZombieReference.csv
+ *
+ *   -Reference=<file>   Table in the layout of a Stella table export: a time column followed by Susceptible,
+ *                       Bitten and Zombies columns (comma or tab separated, in any order). Relative to the
+ *                       project folder, default ZombieReference.csv there.
+ *   -Tolerance=<float>  Largest allowed absolute difference per stock (default 0.5)
+ *   -Days=<int>         Days to run, at least the last reference day (default 180)
+ *   -TimingRuns=<int>   Full runs used to time the step (default 2000, 0 skips timing)
+ *   -Baseline=<file>    This machine's baseline of the step's time over a fixed reference kernel timed in the
+ *                       same run, relative to the project folder (default Saved/ZombieStepTiming.txt). Not
+ *                       versioned: the first run on a machine records it and passes.
+ *   -MaxSlowdown=<float> Allowed ratio over the baseline (default 1.25)
+ *   -UpdateBaseline     Store this run's timing as the new baseline
+ *   -MaxEngineSlowdown=<float> Fail when the data-driven engine's step takes longer than this ratio of
+ *                       FZombieModel's. Only reported when left out; pass it before turning on
+ *                       ASimulationController::bStepCompiledModel for a target machine.
+ *   -Integrators        Also check every integrator and DT against a fine-DT RK4 run (-FineDT=, default 1/64).
+ *                       Euler is reported; RK2 and RK4 fail beyond -IntegratorTolerance= of the population
+ *                       (default 0.1).
+ * Also accepts -Controller, -Curve and -Table, see ZombieCommandlets::LoadBaseModel.
+ */
+UCLASS()
+class ZOMBIEAPOCALYPSE_API UZombieReferenceCheckCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UZombieReferenceCheckCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,58 @@
+#include "ZombieReferenceCheck.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// The ZombieReferenceCheck commandlet's checks at its defaults, for Automation RunTests ZombieApocalypse.Model.Reference
+// and the Session Frontend. A failing check logs its errors, which the automation framework reports with the test.
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FZombieReferenceTrajectoryTest, "ZombieApocalypse.Model.Reference.Trajectory",
+    EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FZombieReferenceTrajectoryTest::RunTest(const FString& Parameters)
+{
+    FZombieReferenceCheck Check;
+    if (!TestTrue(TEXT("Model and reference load"), Check.Load(Parameters)))
+        return false;
+
+    return TestTrue(TEXT("Run matches the reference"), Check.CheckTrajectory());
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FZombieReferenceEngineTest, "ZombieApocalypse.Model.Reference.Engine",
+    EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FZombieReferenceEngineTest::RunTest(const FString& Parameters)
+{
+    FZombieReferenceCheck Check;
+    if (!TestTrue(TEXT("Model and reference load"), Check.Load(Parameters)))
+        return false;
+
+    return TestTrue(TEXT("Data-driven engine steps like FZombieModel"), Check.CheckEngine());
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FZombieReferenceIntegratorsTest, "ZombieApocalypse.Model.Reference.Integrators",
+    EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FZombieReferenceIntegratorsTest::RunTest(const FString& Parameters)
+{
+    FZombieReferenceCheck Check;
+    if (!TestTrue(TEXT("Model and reference load"), Check.Load(Parameters)))
+        return false;
+
+    return TestTrue(TEXT("Integrators stay close to the fine-DT run"), Check.CheckIntegrators());
+}
+
+// Timing is noisy on a shared machine, so it runs with the performance tests rather than every product test pass
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FZombieReferenceTimingTest, "ZombieApocalypse.Model.Reference.Timing",
+    EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FZombieReferenceTimingTest::RunTest(const FString& Parameters)
+{
+    FZombieReferenceCheck Check;
+    if (!TestTrue(TEXT("Model and reference load"), Check.Load(Parameters)))
+        return false;
+
+    return TestTrue(TEXT("Step is no slower than this machine's baseline"), Check.CheckTiming());
+}
+
+#endif
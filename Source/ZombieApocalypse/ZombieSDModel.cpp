@@ -0,0 +1,156 @@
+#include "ZombieSDModel.h"
+
+FSDModelDescription ZombieSD::MakeDescription(const FZombieModel& Model)
+{
+    const FZombieModelParams& Params = Model.Params;
+    FSDModelDescription Description;
+    Description.DT = FZombieStepSize(Params.DT).SubstepDays;
+
+    Description.Constants = {
+        { TEXT("CONVERSION_FROM_PEOPLE_TO_ZOMBIES"), Params.CONVERSION_FROM_PEOPLE_TO_ZOMBIES },
+        { TEXT("normal_number_of_bites"), Params.normal_number_of_bites },
+        { TEXT("land_area"), Params.land_area },
+        { TEXT("normal_population_density"), Params.normal_population_density } };
+
+    FSDStock Susceptible;
+    Susceptible.Name = TEXT("Susceptible");
+    Susceptible.InitialValue = Model.State.Susceptible;
+
+    FSDStock Bitten;
+    Bitten.Name = TEXT("Bitten");
+    Bitten.InitialValue = Model.conveyor_content();
+    Bitten.Type = ESDStockType::Conveyor;
+    Bitten.TransitTime = Params.days_to_become_infected_from_bite;
+    Bitten.bLimitCapacity = true;
+    Bitten.Capacity = Params.Bitten_capacity;
+
+    FSDStock Zombies;
+    Zombies.Name = TEXT("Zombies");
+    Zombies.InitialValue = Model.State.Zombies;
+
+    Description.Stocks = { Susceptible, Bitten, Zombies };
+
+    Description.Auxiliaries = {
+        { TEXT("non_zombie_population"), TEXT("Bitten + Susceptible") },
+        { TEXT("population_density"), TEXT("non_zombie_population / land_area") },
+        { TEXT("population_density_effect_on_zombie_bites"), Model.Graph ? TEXT("population_density_effect(population_density / normal_population_density)") : TEXT("1") },
+        { TEXT("number_of_bites_per_zombie_per_day"), TEXT("normal_number_of_bites * population_density_effect_on_zombie_bites") },
+        { TEXT("total_bitten_per_day"), TEXT("ROUND(Zombies * number_of_bites_per_zombie_per_day)") },
+        { TEXT("number_of_bites_from_total_zombies_on_susceptible"), TEXT("ROUND(Susceptible / MAX(non_zombie_population, 1) * total_bitten_per_day)") } };
+
+    Description.Flows = {
+        // Enforce non-negative susceptible
+        { TEXT("getting_bitten"), TEXT("Susceptible"), TEXT("Bitten"), TEXT("MIN(number_of_bites_from_total_zombies_on_susceptible, FLOOR(Susceptible))") },
+        { TEXT("conveyor_outflow"), TEXT("Bitten"), FString(), FString() },
+        { TEXT("becoming_infected"), FString(), TEXT("Zombies"), TEXT("conveyor_outflow * CONVERSION_FROM_PEOPLE_TO_ZOMBIES") } };
+
+    if (Model.Graph)
+    {
+        FSDGraph& Graph = Description.Graphs.AddDefaulted_GetRef();
+        Graph.Name = TEXT("population_density_effect");
+        for (const std::pair<float, float>& Point : Model.Graph->graphPts)
+            Graph.Points.Add(FVector2D(Point.first, Point.second));
+    }
+
+    return Description;
+}
+
+bool ZombieSD::Compile(const FZombieModel& Model, FSDModel& OutModel)
+{
+    if (Model.Params.Incubation != EZombieIncubation::Conveyor)
+    {
+        UE_LOG(LogTemp, Error, TEXT("ZombieSD: Only incubation on the conveyor is described, not %s"),
+            *StaticEnum<EZombieIncubation>()->GetNameStringByValue(static_cast<int64>(Model.Params.Incubation)));
+        return false;
+    }
+
+    if (!OutModel.Compile(MakeDescription(Model)))
+        return false;
+
+    // Same table the model looks up, whatever it was baked with
+    if (Model.Graph)
+        OutModel.ReplaceGraph(TEXT("population_density_effect"), *Model.Graph);
+
+    // Cohorts already in flight, with their arrival steps
+    const int32 BittenSlot = OutModel.FindSlot(TEXT("Bitten"));
+    if (Model.State.conveyor.GetTransitSteps() > 0)
+    {
+        *OutModel.GetConveyor(BittenSlot) = Model.State.conveyor;
+        OutModel.GetConveyor(BittenSlot)->SetTransitTime(Model.Params.days_to_become_infected_from_bite, FZombieStepSize(Model.Params.DT).SubstepDays);
+        OutModel.RefreshConveyorValue(BittenSlot);
+    }
+    return true;
+}
+
+bool FZombieSDStepper::CanStep(const FZombieModelParams& Params)
+{
+    const FZombieStepSize StepSize(Params.DT);
+    return Params.Incubation == EZombieIncubation::Conveyor && Params.IntegrationMethod == EZombieIntegrationMethod::Euler
+        && StepSize.Days == 1 && StepSize.NumSubsteps == 1;
+}
+
+bool FZombieSDStepper::UpdateCompiled(const FZombieModel& Model)
+{
+    const bool bUpToDate = bTriedCompile && CompiledParams == Model.Params && CompiledGraph == Model.Graph;
+    if (!bUpToDate)
+    {
+        bTriedCompile = true;
+        CompiledParams = Model.Params;
+        CompiledGraph = Model.Graph;
+        bCompiled = CanStep(Model.Params) && ZombieSD::Compile(Model, Compiled);
+        if (!bCompiled)
+            return false;
+
+        SusceptibleSlot = Compiled.FindSlot(TEXT("Susceptible"));
+        BittenSlot = Compiled.FindSlot(TEXT("Bitten"));
+        ZombiesSlot = Compiled.FindSlot(TEXT("Zombies"));
+        PopulationDensitySlot = Compiled.FindSlot(TEXT("population_density"));
+        DensityEffectSlot = Compiled.FindSlot(TEXT("population_density_effect_on_zombie_bites"));
+        BitesPerZombieSlot = Compiled.FindSlot(TEXT("number_of_bites_per_zombie_per_day"));
+        GettingBittenSlot = Compiled.FindSlot(TEXT("getting_bitten"));
+        BecomingInfectedSlot = Compiled.FindSlot(TEXT("becoming_infected"));
+    }
+    return bCompiled;
+}
+
+FZombieStepOutcome FZombieSDStepper::Step(FZombieModel& Model, FZombieModelAuxiliaries* OutAuxiliaries)
+{
+    if (!UpdateCompiled(Model))
+        return Model.RunSimulationStep(OutAuxiliaries);
+
+    // Compiled steps Model's own conveyor, sized first like the hand-written step does for a model that has
+    // not stepped yet
+    FZombieModelState& State = Model.State;
+    State.conveyor.SetTransitTime(Model.Params.days_to_become_infected_from_bite);
+    Compiled.LendConveyor(BittenSlot, &State.conveyor);
+
+    // Gameplay may have changed the stocks or taken people off the conveyor since the last step. Only a
+    // changed value is written: the values the last step left stay put instead of making a round trip
+    // through Model on the way to the next step.
+    if (Compiled.GetValue(SusceptibleSlot) != State.Susceptible)
+        Compiled.SetValue(SusceptibleSlot, State.Susceptible);
+    if (Compiled.GetValue(ZombiesSlot) != State.Zombies)
+        Compiled.SetValue(ZombiesSlot, State.Zombies);
+    if (Compiled.GetValue(BittenSlot) != State.conveyor.Content())
+        Compiled.RefreshConveyorValue(BittenSlot);
+
+    Compiled.Step();
+    Compiled.LendConveyor(BittenSlot, nullptr);
+
+    State.Susceptible = Compiled.GetValue(SusceptibleSlot);
+    State.Zombies = Compiled.GetValue(ZombiesSlot);
+    State.Bitten = State.conveyor.Content();
+
+    if (OutAuxiliaries)
+    {
+        OutAuxiliaries->population_density = Compiled.GetValue(PopulationDensitySlot);
+        OutAuxiliaries->population_density_effect_on_zombie_bites = Compiled.GetValue(DensityEffectSlot);
+        OutAuxiliaries->number_of_bites_per_zombie_per_day = Compiled.GetValue(BitesPerZombieSlot);
+        OutAuxiliaries->getting_bitten = Compiled.GetValue(GettingBittenSlot);
+        OutAuxiliaries->becoming_infected = Compiled.GetValue(BecomingInfectedSlot);
+    }
+
+    const FZombieStepOutcome Outcome = CheckZombieOutcome(Model.Params, State);
+    State.TimeStepsFinished++;
+    return Outcome;
+}
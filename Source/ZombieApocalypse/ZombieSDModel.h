@@ -0,0 +1,50 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SDModel.h"
+
+// The Stella zombie model as an instance of the data-driven engine
+namespace ZombieSD
+{
+	// Constants, stocks, flows and curve of Model as a description. Bitten is a conveyor whose outflow
+	// turns into Zombies. The engine integrates with Euler, so DT is the substep of Model.Params.DT.
+	ZOMBIEAPOCALYPSE_API FSDModelDescription MakeDescription(const FZombieModel& Model);
+
+	// Compiles Model and copies its curve and conveyor cohorts, so stepping OutModel continues Model exactly.
+	// Fails for the incubation delays, the description always uses the conveyor.
+	ZOMBIEAPOCALYPSE_API bool Compile(const FZombieModel& Model, FSDModel& OutModel);
+}
+
+// Steps an FZombieModel on its compiled description instead of the hand-written step, with the same result.
+// The FZombieModel stays the one to read and change between steps; its stocks are copied in before a step and
+// back out after it, its conveyor is stepped in place, and the description is compiled again when its constants
+// or curve change.
+class ZOMBIEAPOCALYPSE_API FZombieSDStepper
+{
+public:
+	// Only the Stella step is described: the conveyor, Euler and one day per step
+	static bool CanStep(const FZombieModelParams& Params);
+
+	// Same as Model.RunSimulationStep. Steps Model itself if it cannot be compiled.
+	FZombieStepOutcome Step(FZombieModel& Model, FZombieModelAuxiliaries* OutAuxiliaries = nullptr);
+
+private:
+	bool UpdateCompiled(const FZombieModel& Model);
+
+	FSDModel Compiled;
+	bool bCompiled{ false };
+
+	// What Compiled was made from, or failed to be made from when bCompiled is false
+	bool bTriedCompile{ false };
+	FZombieModelParams CompiledParams;
+	TSharedPtr<const FZombieGraph> CompiledGraph;
+
+	int32 SusceptibleSlot{ INDEX_NONE };
+	int32 BittenSlot{ INDEX_NONE };
+	int32 ZombiesSlot{ INDEX_NONE };
+	int32 PopulationDensitySlot{ INDEX_NONE };
+	int32 DensityEffectSlot{ INDEX_NONE };
+	int32 BitesPerZombieSlot{ INDEX_NONE };
+	int32 GettingBittenSlot{ INDEX_NONE };
+	int32 BecomingInfectedSlot{ INDEX_NONE };
+};
@@ -0,0 +1,129 @@
+#include "ZombieSensitivity.h"
+
+namespace ZombieSensitivity
+{
+    using FDual = TZombieDual<PartialsPerPass>;
+
+    // Inputs before the graph points, in column order
+    enum EModelInput : int32
+    {
+        normal_number_of_bites,
+        Bitten_capacity,
+        land_area,
+        normal_population_density,
+        CONVERSION_FROM_PEOPLE_TO_ZOMBIES,
+        InitialSusceptible,
+        InitialZombies,
+        NumModelInputs
+    };
+
+    static const TCHAR* ModelInputNames[NumModelInputs] =
+    {
+        TEXT("normal_number_of_bites"),
+        TEXT("Bitten_capacity"),
+        TEXT("land_area"),
+        TEXT("normal_population_density"),
+        TEXT("CONVERSION_FROM_PEOPLE_TO_ZOMBIES"),
+        TEXT("Susceptible"),
+        TEXT("Zombies"),
+    };
+
+    // Same piecewise linear lookup as FZombieGraph::graph_lookup_scan, with the y values as duals
+    static FDual LookupGraph(const std::vector<std::pair<float, float>>& graphPts, const std::vector<FDual>& graphYs, const FDual& xIn)
+    {
+        if (graphPts.empty()) return FDual(1.f);
+
+        if (xIn.Value <= graphPts.front().first)
+            return graphYs.front();
+        if (xIn.Value >= graphPts.back().first)
+            return graphYs.back();
+
+        for (size_t i = 1; i < graphPts.size(); ++i)
+        {
+            if (xIn.Value <= graphPts[i].first)
+            {
+                float x0 = graphPts[i-1].first, x1 = graphPts[i].first;
+                FDual t = (xIn - x0) / (x1 - x0);
+                return graphYs[i-1] + t*(graphYs[i] - graphYs[i-1]);
+            }
+        }
+        return graphYs.back();
+    }
+}
+
+FZombieSensitivityResult ZombieSensitivity::Run(const FZombieModel& Model, int32 Days)
+{
+    FZombieSensitivityResult Result;
+
+    static const std::vector<std::pair<float, float>> NoPoints;
+    const std::vector<std::pair<float, float>>& graphPts = Model.Graph ? Model.Graph->graphPts : NoPoints;
+
+    for (const TCHAR* Name : ModelInputNames)
+        Result.InputNames.Add(Name);
+    for (size_t i = 0; i < graphPts.size(); ++i)
+        Result.InputNames.Add(FString::Printf(TEXT("graph_y[%d]"), static_cast<int32>(i)));
+
+    const int32 NumInputs = Result.InputNames.Num();
+    Result.NumDays = FMath::Max(Days, 0);
+    Result.Susceptible.SetNumZeroed(Result.NumDays);
+    Result.Bitten.SetNumZeroed(Result.NumDays);
+    Result.Zombies.SetNumZeroed(Result.NumDays);
+    Result.dSusceptible.SetNumZeroed(Result.NumDays * NumInputs);
+    Result.dBitten.SetNumZeroed(Result.NumDays * NumInputs);
+    Result.dZombies.SetNumZeroed(Result.NumDays * NumInputs);
+
+    // Each pass seeds the next PartialsPerPass inputs; the values are the same in every pass
+    for (int32 FirstInput = 0; FirstInput < NumInputs; FirstInput += PartialsPerPass)
+    {
+        const FZombieModelParams& Params = Model.Params;
+
+        TZombieModelRates<FDual> Rates(Params);
+        Rates.normal_number_of_bites = FDual::Seed(Params.normal_number_of_bites, normal_number_of_bites - FirstInput);
+        Rates.Bitten_capacity = FDual::Seed(Params.Bitten_capacity, Bitten_capacity - FirstInput);
+        Rates.land_area = FDual::Seed(Params.land_area, land_area - FirstInput);
+        Rates.normal_population_density = FDual::Seed(Params.normal_population_density, normal_population_density - FirstInput);
+        Rates.CONVERSION_FROM_PEOPLE_TO_ZOMBIES = FDual::Seed(Params.CONVERSION_FROM_PEOPLE_TO_ZOMBIES, CONVERSION_FROM_PEOPLE_TO_ZOMBIES - FirstInput);
+
+        TZombieModelState<FDual> State;
+        State.Susceptible = FDual::Seed(Model.State.Susceptible, InitialSusceptible - FirstInput);
+        State.Bitten = Model.State.Bitten;
+        State.Zombies = FDual::Seed(Model.State.Zombies, InitialZombies - FirstInput);
+        State.TimeStepsFinished = Model.State.TimeStepsFinished;
+        State.conveyor = TZombieConveyor<FDual>(Model.State.conveyor);
+        for (int32 Stage = 0; Stage < UE_ARRAY_COUNT(State.incubation_delay1.Stages); ++Stage)
+            State.incubation_delay1.Stages[Stage] = Model.State.incubation_delay1.Stages[Stage];
+        for (int32 Stage = 0; Stage < UE_ARRAY_COUNT(State.incubation_delay3.Stages); ++Stage)
+            State.incubation_delay3.Stages[Stage] = Model.State.incubation_delay3.Stages[Stage];
+        State.incubation_leaky_conveyor = TSDLeakyConveyor<FDual>(Model.State.incubation_leaky_conveyor);
+
+        std::vector<FDual> graphYs;
+        graphYs.reserve(graphPts.size());
+        for (size_t i = 0; i < graphPts.size(); ++i)
+            graphYs.push_back(FDual::Seed(graphPts[i].second, NumModelInputs + static_cast<int32>(i) - FirstInput));
+
+        auto Lookup = [&graphPts, &graphYs](const FDual& xIn) { return LookupGraph(graphPts, graphYs, xIn); };
+
+        const int32 NumPartials = FMath::Min(PartialsPerPass, NumInputs - FirstInput);
+        for (int32 Day = 0; Day < Result.NumDays; ++Day)
+        {
+            StepZombieModel(Params, Rates, State, Lookup);
+
+            if (FirstInput == 0)
+            {
+                Result.Susceptible[Day] = State.Susceptible.Value;
+                Result.Bitten[Day] = State.Bitten.Value;
+                Result.Zombies[Day] = State.Zombies.Value;
+            }
+
+            const int32 Row = Day * NumInputs + FirstInput;
+            for (int32 Partial = 0; Partial < NumPartials; ++Partial)
+            {
+                Result.dSusceptible[Row + Partial] = State.Susceptible.Partials[Partial];
+                Result.dBitten[Row + Partial] = State.Bitten.Partials[Partial];
+                Result.dZombies[Row + Partial] = State.Zombies.Partials[Partial];
+            }
+        }
+    }
+
+    return Result;
+}
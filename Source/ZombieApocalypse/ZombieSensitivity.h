@@ -0,0 +1,41 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZombieModel.h"
+
+// Trajectory of a model together with its derivatives with respect to the model inputs
+struct FZombieSensitivityResult
+{
+	// What each derivative column is taken with respect to, e.g. "normal_number_of_bites" or "graph_y[3]"
+	TArray<FString> InputNames;
+
+	int32 NumDays{ 0 };
+
+	// Stocks after each day
+	TArray<float> Susceptible;
+	TArray<float> Bitten;
+	TArray<float> Zombies;
+
+	// d stock / d input after each day, at [Day * InputNames.Num() + Input]
+	TArray<float> dSusceptible;
+	TArray<float> dBitten;
+	TArray<float> dZombies;
+
+	float GetZombiesDerivative(int32 Day, int32 Input) const { return dZombies[Day * InputNames.Num() + Input]; }
+};
+
+namespace ZombieSensitivity
+{
+	// Derivatives carried per pass. More inputs than this take extra passes over the same days.
+	static constexpr int32 PartialsPerPass = 16;
+
+	/**
+	 * Steps a copy of Model for Days days over dual numbers and returns the trajectory with the
+	 * derivatives with respect to the continuous constants, the initial Susceptible and Zombies,
+	 * and the y value of every graph point.
+	 *
+	 * The graph is evaluated from its points (not the baked table) so each y has an exact derivative.
+	 * Rounded bite counts pass their derivative straight through, see ZombieMath::RoundToFloat.
+	 */
+	ZOMBIEAPOCALYPSE_API FZombieSensitivityResult Run(const FZombieModel& Model, int32 Days);
+}
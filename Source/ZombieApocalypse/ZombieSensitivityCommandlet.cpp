@@ -0,0 +1,75 @@
+#include "ZombieSensitivityCommandlet.h"
+#include "ZombieCommandletHelpers.h"
+#include "ZombieSensitivity.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformTime.h"
+
+UZombieSensitivityCommandlet::UZombieSensitivityCommandlet()
+{
+    IsClient = false;
+    IsEditor = false;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 UZombieSensitivityCommandlet::Main(const FString& Params)
+{
+    FZombieModel BaseModel;
+    if (!ZombieCommandlets::LoadBaseModel(Params, BaseModel))
+        return 1;
+
+    int32 Days = 180;
+    FParse::Value(*Params, TEXT("Days="), Days);
+
+    const double StartTime = FPlatformTime::Seconds();
+    const FZombieSensitivityResult Result = ZombieSensitivity::Run(BaseModel, Days);
+    const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+    const int32 NumInputs = Result.InputNames.Num();
+
+    // One row per day: the stocks, then d<stock>/d<input> for every input
+    FString Csv(TEXT("---,Day,Susceptible,Bitten,Zombies"));
+    for (const TCHAR* Stock : { TEXT("Susceptible"), TEXT("Bitten"), TEXT("Zombies") })
+    {
+        for (const FString& Input : Result.InputNames)
+            Csv += FString::Printf(TEXT(",d%s/d%s"), Stock, *Input);
+    }
+    Csv += TEXT("\n");
+
+    for (int32 Day = 0; Day < Result.NumDays; ++Day)
+    {
+        Csv += FString::Printf(TEXT("%d, %d, %.3f, %.3f, %.3f"), Day + 1, BaseModel.State.TimeStepsFinished + Day + 1,
+            Result.Susceptible[Day], Result.Bitten[Day], Result.Zombies[Day]);
+        for (const TArray<float>* Derivatives : { &Result.dSusceptible, &Result.dBitten, &Result.dZombies })
+        {
+            for (int32 Input = 0; Input < NumInputs; ++Input)
+                Csv += FString::Printf(TEXT(", %.6g"), (*Derivatives)[Day * NumInputs + Input]);
+        }
+        Csv += TEXT("\n");
+    }
+
+    FString OutPath = FPaths::ProjectSavedDir() / TEXT("ZombieSensitivity.csv");
+    FParse::Value(*Params, TEXT("Out="), OutPath);
+
+    if (!FFileHelper::SaveStringToFile(Csv, *OutPath))
+    {
+        UE_LOG(LogTemp, Error, TEXT("ZombieSensitivity: Could not write %s"), *OutPath);
+        return 1;
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("ZombieSensitivity: %d days x %d inputs in %.2f ms, wrote %s"),
+        Result.NumDays, NumInputs, Elapsed * 1000.0, *OutPath);
+
+    if (Result.NumDays > 0)
+    {
+        const int32 LastDay = Result.NumDays - 1;
+        for (int32 Input = 0; Input < NumInputs; ++Input)
+        {
+            UE_LOG(LogTemp, Display, TEXT("ZombieSensitivity: dZombies/d%s on the last day = %g"),
+                *Result.InputNames[Input], Result.GetZombiesDerivative(LastDay, Input));
+        }
+    }
+
+    return 0;
+}
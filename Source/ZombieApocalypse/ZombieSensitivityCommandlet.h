@@ -0,0 +1,25 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ZombieSensitivityCommandlet.generated.h"
+
+/**
+ * Writes the trajectory of the model and the derivative of every stock with respect to every input
+ * (the continuous constants, the initial stocks and the graph points), computed in one dual-number pass.
+ *
+ * Example:
+ *   UnrealEditor-Cmd ZombieApocalypse.uproject -run=ZombieSensitivity -Days=180 -Out=Saved/ZombieSensitivity.csv
+ *
+ * Takes the same -Controller, -Curve and -Table options as ZombieSweep.
+ */
+UCLASS()
+class ZOMBIEAPOCALYPSE_API UZombieSensitivityCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UZombieSensitivityCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,176 @@
+#include "ZombieSweepCommandlet.h"
+#include "ZombieCommandletHelpers.h"
+#include "ZombieBatch.h"
+#include "Async/ParallelFor.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformTime.h"
+
+namespace ZombieSweep
+{
+    // One swept parameter and the values it takes
+    struct FAxis
+    {
+        const TCHAR* Name;
+        void (*Apply)(FZombieModel& Model, float Value);
+        TArray<float> Values;
+    };
+
+    // Parses "a,b,c" or "min:max:step" into a list of values
+    static bool ParseValues(const FString& Text, TArray<float>& OutValues)
+    {
+        TArray<FString> Range;
+        if (Text.ParseIntoArray(Range, TEXT(":")) == 3)
+        {
+            const float Min = FCString::Atof(*Range[0]);
+            const float Max = FCString::Atof(*Range[1]);
+            const float Step = FCString::Atof(*Range[2]);
+            if (Step <= 0.f || Max < Min)
+                return false;
+
+            const int32 Count = FMath::FloorToInt((Max - Min) / Step + 1.e-4f) + 1;
+            for (int32 i{0}; i < Count; i++)
+                OutValues.Add(Min + i * Step);
+            return true;
+        }
+
+        TArray<FString> List;
+        Text.ParseIntoArray(List, TEXT(","));
+        for (const FString& Item : List)
+            OutValues.Add(FCString::Atof(*Item));
+        return OutValues.Num() > 0;
+    }
+}
+
+UZombieSweepCommandlet::UZombieSweepCommandlet()
+{
+    IsClient = false;
+    IsEditor = false;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 UZombieSweepCommandlet::Main(const FString& Params)
+{
+    using namespace ZombieSweep;
+
+    FZombieModel BaseModel;
+    if (!ZombieCommandlets::LoadBaseModel(Params, BaseModel))
+        return 1;
+
+    TArray<FAxis> Axes;
+    Axes.Add({ TEXT("normal_number_of_bites"), [](FZombieModel& M, float V) { M.Params.normal_number_of_bites = V; } });
+    Axes.Add({ TEXT("Bitten_capacity"), [](FZombieModel& M, float V) { M.Params.Bitten_capacity = V; } });
+    Axes.Add({ TEXT("days_to_become_infected_from_bite"), [](FZombieModel& M, float V) { M.Params.days_to_become_infected_from_bite = V; } });
+    Axes.Add({ TEXT("land_area"), [](FZombieModel& M, float V) { M.Params.land_area = V; } });
+    Axes.Add({ TEXT("normal_population_density"), [](FZombieModel& M, float V) { M.Params.normal_population_density = V; } });
+    Axes.Add({ TEXT("CONVERSION_FROM_PEOPLE_TO_ZOMBIES"), [](FZombieModel& M, float V) { M.Params.CONVERSION_FROM_PEOPLE_TO_ZOMBIES = V; } });
+    Axes.Add({ TEXT("Susceptible"), [](FZombieModel& M, float V) { M.State.Susceptible = V; } });
+    Axes.Add({ TEXT("Zombies"), [](FZombieModel& M, float V) { M.State.Zombies = V; } });
+
+    // Axes not given on the command line are dropped and keep their default
+    int64 NumScenarios = 1;
+    for (int32 i = Axes.Num() - 1; i >= 0; --i)
+    {
+        FString ValueText;
+        if (!FParse::Value(*Params, *FString::Printf(TEXT("%s="), Axes[i].Name), ValueText, false))
+        {
+            Axes.RemoveAt(i);
+            continue;
+        }
+
+        if (!ParseValues(ValueText, Axes[i].Values))
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieSweep: Could not parse values '%s' for %s"), *ValueText, Axes[i].Name);
+            return 1;
+        }
+        NumScenarios *= Axes[i].Values.Num();
+    }
+
+    if (NumScenarios > MAX_int32)
+    {
+        UE_LOG(LogTemp, Error, TEXT("ZombieSweep: %lld scenarios is too many for one sweep"), NumScenarios);
+        return 1;
+    }
+
+    int32 MaxDays = 365;
+    FParse::Value(*Params, TEXT("Days="), MaxDays);
+    const bool bStopAtFirstOutcome = FParse::Param(*Params, TEXT("StopAtFirstOutcome"));
+
+    UE_LOG(LogTemp, Display, TEXT("ZombieSweep: Running %lld scenarios for up to %d days"), NumScenarios, MaxDays);
+    const double StartTime = FPlatformTime::Seconds();
+
+    TArray<FZombieRunResult> Results;
+    Results.SetNum(static_cast<int32>(NumScenarios));
+
+    // Scenarios are stepped in SIMD batches of lanes, one batch per task. Other integrators step one scenario per lane.
+    const int32 LanesPerBatch = FZombieModelBatch::SupportsParams(BaseModel.Params) ? 64 : 1;
+    const int32 NumBatches = (Results.Num() + LanesPerBatch - 1) / LanesPerBatch;
+
+    ParallelFor(NumBatches, [&](int32 BatchIndex)
+    {
+        const int32 FirstScenario = BatchIndex * LanesPerBatch;
+        const int32 NumLanes = FMath::Min(LanesPerBatch, Results.Num() - FirstScenario);
+
+        TArray<FZombieModel> Scenarios;
+        Scenarios.Reserve(NumLanes);
+        for (int32 ScenarioIndex = FirstScenario; ScenarioIndex < FirstScenario + NumLanes; ++ScenarioIndex)
+        {
+            FZombieModel& Scenario = Scenarios.Add_GetRef(BaseModel);
+
+            // Scenario index as a mixed-radix number over the axes
+            int32 Remainder = ScenarioIndex;
+            for (const FAxis& Axis : Axes)
+            {
+                Axis.Apply(Scenario, Axis.Values[Remainder % Axis.Values.Num()]);
+                Remainder /= Axis.Values.Num();
+            }
+        }
+
+        if (LanesPerBatch == 1)
+        {
+            Results[FirstScenario] = Scenarios[0].Run(MaxDays, bStopAtFirstOutcome);
+            return;
+        }
+
+        FZombieModelBatch Batch;
+        Batch.Initialize(Scenarios.GetData(), NumLanes);
+        Batch.Run(MaxDays, bStopAtFirstOutcome, &Results[FirstScenario]);
+    });
+
+    UE_LOG(LogTemp, Display, TEXT("ZombieSweep: Finished in %.3f seconds"), FPlatformTime::Seconds() - StartTime);
+
+    // Same layout as PopulationDensityEffect.csv so the result can be imported as a DataTable
+    FString Csv(TEXT("---"));
+    for (const FAxis& Axis : Axes)
+        Csv += FString::Printf(TEXT(",%s"), Axis.Name);
+    Csv += TEXT(",FinalSusceptible,FinalBitten,FinalZombies,DaysRun,LoseDay,WinDay\n");
+
+    for (int32 ScenarioIndex{0}; ScenarioIndex < Results.Num(); ScenarioIndex++)
+    {
+        const FZombieRunResult& Result = Results[ScenarioIndex];
+        Csv += FString::Printf(TEXT("%d"), ScenarioIndex + 1);
+
+        int32 Remainder = ScenarioIndex;
+        for (const FAxis& Axis : Axes)
+        {
+            Csv += FString::Printf(TEXT(", %.3f"), Axis.Values[Remainder % Axis.Values.Num()]);
+            Remainder /= Axis.Values.Num();
+        }
+
+        Csv += FString::Printf(TEXT(", %.3f, %.3f, %.3f, %d, %d, %d\n"),
+            Result.FinalSusceptible, Result.FinalBitten, Result.FinalZombies, Result.DaysRun, Result.LoseDay, Result.WinDay);
+    }
+
+    FString OutPath = FPaths::ProjectSavedDir() / TEXT("ZombieSweep.csv");
+    FParse::Value(*Params, TEXT("Out="), OutPath);
+
+    if (!FFileHelper::SaveStringToFile(Csv, *OutPath))
+    {
+        UE_LOG(LogTemp, Error, TEXT("ZombieSweep: Could not write %s"), *OutPath);
+        return 1;
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("ZombieSweep: Wrote %d rows to %s"), Results.Num(), *OutPath);
+    return 0;
+}
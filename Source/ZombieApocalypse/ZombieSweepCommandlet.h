@@ -0,0 +1,26 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ZombieSweepCommandlet.generated.h"
+
+/**
+ * Runs a grid of FZombieModel scenarios headless and writes one CSV row per scenario.
+ *
+ * Example:
+ *   UnrealEditor-Cmd ZombieApocalypse.uproject -run=ZombieSweep
+ *       -normal_number_of_bites=0.5:2:0.25 -Bitten_capacity=50,100,200 -Out=Saved/ZombieSweep.csv
+ *
+ * Each swept value is either a comma list (a,b,c) or an inclusive range (min:max:step).
+ * Anything not swept keeps the value from the SimulationController defaults (-Controller=<class path>).
+ */
+UCLASS()
+class ZOMBIEAPOCALYPSE_API UZombieSweepCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UZombieSweepCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
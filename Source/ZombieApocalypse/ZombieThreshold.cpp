@@ -0,0 +1,133 @@
+#include "ZombieThreshold.h"
+
+float ZombieThreshold::GetParameter(const FZombieModel& Model, EZombieParameter Parameter)
+{
+    switch (Parameter)
+    {
+    case EZombieParameter::normal_number_of_bites:            return Model.Params.normal_number_of_bites;
+    case EZombieParameter::Bitten_capacity:                   return Model.Params.Bitten_capacity;
+    case EZombieParameter::days_to_become_infected_from_bite: return Model.Params.days_to_become_infected_from_bite;
+    case EZombieParameter::land_area:                         return Model.Params.land_area;
+    case EZombieParameter::normal_population_density:         return Model.Params.normal_population_density;
+    case EZombieParameter::CONVERSION_FROM_PEOPLE_TO_ZOMBIES: return Model.Params.CONVERSION_FROM_PEOPLE_TO_ZOMBIES;
+    case EZombieParameter::Susceptible:                       return Model.State.Susceptible;
+    case EZombieParameter::Zombies:                           return Model.State.Zombies;
+    }
+    return 0.f;
+}
+
+void ZombieThreshold::SetParameter(FZombieModel& Model, EZombieParameter Parameter, float Value)
+{
+    switch (Parameter)
+    {
+    case EZombieParameter::normal_number_of_bites:            Model.Params.normal_number_of_bites = Value; break;
+    case EZombieParameter::Bitten_capacity:                   Model.Params.Bitten_capacity = Value; break;
+    case EZombieParameter::days_to_become_infected_from_bite: Model.Params.days_to_become_infected_from_bite = Value; break;
+    case EZombieParameter::land_area:                         Model.Params.land_area = Value; break;
+    case EZombieParameter::normal_population_density:         Model.Params.normal_population_density = Value; break;
+    case EZombieParameter::CONVERSION_FROM_PEOPLE_TO_ZOMBIES: Model.Params.CONVERSION_FROM_PEOPLE_TO_ZOMBIES = Value; break;
+    case EZombieParameter::Susceptible:                       Model.State.Susceptible = Value; break;
+    case EZombieParameter::Zombies:                           Model.State.Zombies = Value; break;
+    }
+}
+
+float ZombieThreshold::LoseMargin(const FZombieModel& Model, EZombieParameter Parameter, float Value, int32 Days, int32& OutLoseDay)
+{
+    FZombieModel Run = Model;
+    SetParameter(Run, Parameter, Value);
+
+    OutLoseDay = -1;
+    float MinSusceptible = Run.State.Susceptible;
+    const int32 EndDay = Run.State.TimeStepsFinished + Days;
+    while (Run.State.TimeStepsFinished < EndDay)
+    {
+        const FZombieStepOutcome Outcome = Run.RunSimulationStep();
+        MinSusceptible = FMath::Min(MinSusceptible, Run.State.Susceptible);
+
+        if (Outcome.bLose)
+        {
+            OutLoseDay = Run.State.TimeStepsFinished;
+            break;
+        }
+        if (Outcome.bWin)
+            break;
+    }
+
+    return MinSusceptible - Run.Params.LoseSusceptibleThreshold;
+}
+
+FZombieThresholdResult ZombieThreshold::FindLoseThreshold(const FZombieModel& Model, const FZombieThresholdSettings& Settings)
+{
+    FZombieThresholdResult Result;
+
+    int32 MinLoseDay = -1;
+    int32 MaxLoseDay = -1;
+    const float MinMargin = LoseMargin(Model, Settings.Parameter, Settings.Min, Settings.Days, MinLoseDay);
+    const float MaxMargin = LoseMargin(Model, Settings.Parameter, Settings.Max, Settings.Days, MaxLoseDay);
+    Result.NumRuns = 2;
+
+    const bool bMinLoses = MinMargin <= 0.f;
+    if (bMinLoses == (MaxMargin <= 0.f))
+    {
+        Result.LoseDay = bMinLoses ? MinLoseDay : -1;
+        return Result;
+    }
+
+    // Lose has margin <= 0 and Survive > 0, so the secant point always falls between them
+    float Lose = bMinLoses ? Settings.Min : Settings.Max;
+    float LoseValue = bMinLoses ? MinMargin : MaxMargin;
+    float Survive = bMinLoses ? Settings.Max : Settings.Min;
+    float SurviveValue = bMinLoses ? MaxMargin : MinMargin;
+    Result.LoseDay = bMinLoses ? MinLoseDay : MaxLoseDay;
+
+    // Which end the last step moved, to halve the other end's margin when one end keeps moving (Illinois)
+    int32 LastMoved = 0;
+
+    // The stocks are rounded, so the margin is a staircase with a jump where the outcome flips and the
+    // secant can crawl along a step. Any step that does not at least halve the bracket is followed by a
+    // bisection, so the search is never slower than bisection by more than a factor of two.
+    bool bBisect = false;
+
+    for (int32 Iteration = 0; Iteration < Settings.MaxIterations && FMath::Abs(Survive - Lose) > Settings.Tolerance; ++Iteration)
+    {
+        const float Width = FMath::Abs(Survive - Lose);
+        float Value = Lose + 0.5f * (Survive - Lose);
+        if (!bBisect)
+        {
+            // A run that lands exactly on the lose threshold puts the secant on the end itself
+            const float Secant = Lose - LoseValue / (SurviveValue - LoseValue) * (Survive - Lose);
+            if (FMath::Min(Lose, Survive) < Secant && Secant < FMath::Max(Lose, Survive))
+                Value = Secant;
+        }
+
+        int32 LoseDay = -1;
+        const float Margin = LoseMargin(Model, Settings.Parameter, Value, Settings.Days, LoseDay);
+        Result.NumRuns++;
+
+        if (Margin <= 0.f)
+        {
+            Lose = Value;
+            LoseValue = Margin;
+            Result.LoseDay = LoseDay;
+            if (LastMoved < 0)
+                SurviveValue *= 0.5f;
+            LastMoved = -1;
+        }
+        else
+        {
+            Survive = Value;
+            SurviveValue = Margin;
+            if (LastMoved > 0)
+                LoseValue *= 0.5f;
+            LastMoved = 1;
+        }
+
+        bBisect = !bBisect && FMath::Abs(Survive - Lose) > 0.5f * Width;
+    }
+
+    Result.bFound = true;
+    Result.LosingValue = Lose;
+    Result.SurvivingValue = Survive;
+    Result.Threshold = 0.5f * (Lose + Survive);
+    return Result;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ZombieModel.h"
+#include "ZombieThreshold.generated.h"
+
+// Model input a threshold search varies. Names follow FZombieModelParams; Susceptible and Zombies are the initial stocks.
+UENUM(BlueprintType)
+enum class EZombieParameter : uint8
+{
+	normal_number_of_bites,
+	Bitten_capacity,
+	days_to_become_infected_from_bite,
+	land_area,
+	normal_population_density,
+	CONVERSION_FROM_PEOPLE_TO_ZOMBIES,
+	Susceptible,
+	Zombies
+};
+
+struct FZombieThresholdSettings
+{
+	EZombieParameter Parameter{ EZombieParameter::Zombies };
+
+	// Values to search between, the game has to lose at one end and not at the other
+	float Min{ 0.f };
+	float Max{ 1.f };
+
+	// Days a run may take to lose. "Which value loses by day 60" is a search with Days = 60.
+	int32 Days{ 180 };
+
+	// Search stops once the losing and the surviving value are this close
+	float Tolerance{ 1.e-3f };
+	int32 MaxIterations{ 64 };
+};
+
+USTRUCT(BlueprintType)
+struct FZombieThresholdResult
+{
+	GENERATED_BODY()
+
+	// False when both ends of the range lose or both survive, Threshold is then meaningless
+	UPROPERTY(BlueprintReadOnly, Category = "Threshold")
+	bool bFound{ false };
+
+	// Value where the outcome flips, between LosingValue and SurvivingValue
+	UPROPERTY(BlueprintReadOnly, Category = "Threshold")
+	float Threshold{ 0.f };
+
+	// Closest values found on either side
+	UPROPERTY(BlueprintReadOnly, Category = "Threshold")
+	float LosingValue{ 0.f };
+	UPROPERTY(BlueprintReadOnly, Category = "Threshold")
+	float SurvivingValue{ 0.f };
+
+	// Day Lose triggers at LosingValue
+	UPROPERTY(BlueprintReadOnly, Category = "Threshold")
+	int32 LoseDay{ -1 };
+
+	// Model runs the search took, the two ends included
+	UPROPERTY(BlueprintReadOnly, Category = "Threshold")
+	int32 NumRuns{ 0 };
+};
+
+namespace ZombieThreshold
+{
+	ZOMBIEAPOCALYPSE_API float GetParameter(const FZombieModel& Model, EZombieParameter Parameter);
+	ZOMBIEAPOCALYPSE_API void SetParameter(FZombieModel& Model, EZombieParameter Parameter, float Value);
+
+	/**
+	 * Runs a copy of Model with Parameter at Value for up to Days days, ending at the first Lose or Win like
+	 * the game does. Returns how far Susceptible stayed above LoseSusceptibleThreshold, 0 or less when the
+	 * run lost, and the day it lost in OutLoseDay (-1 if it did not).
+	 */
+	ZOMBIEAPOCALYPSE_API float LoseMargin(const FZombieModel& Model, EZombieParameter Parameter, float Value, int32 Days, int32& OutLoseDay);
+
+	/**
+	 * Finds the value of a parameter at which Model starts losing within Settings.Days, e.g. the initial
+	 * Zombies that make Susceptible reach the lose threshold before day 180. Assumes a single crossing in
+	 * the range. Searches the margin of LoseMargin with the Illinois variant of regula falsi, which keeps a
+	 * bracket like bisection but converges like the secant method where the margin is smooth, and bisects
+	 * where it is not.
+	 */
+	ZOMBIEAPOCALYPSE_API FZombieThresholdResult FindLoseThreshold(const FZombieModel& Model, const FZombieThresholdSettings& Settings);
+}
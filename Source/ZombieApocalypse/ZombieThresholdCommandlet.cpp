@@ -0,0 +1,61 @@
+#include "ZombieThresholdCommandlet.h"
+#include "ZombieCommandletHelpers.h"
+#include "ZombieThreshold.h"
+#include "HAL/PlatformTime.h"
+
+UZombieThresholdCommandlet::UZombieThresholdCommandlet()
+{
+    IsClient = false;
+    IsEditor = false;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 UZombieThresholdCommandlet::Main(const FString& Params)
+{
+    FZombieModel BaseModel;
+    if (!ZombieCommandlets::LoadBaseModel(Params, BaseModel))
+        return 1;
+
+    FString ParameterName(TEXT("Zombies"));
+    FParse::Value(*Params, TEXT("Parameter="), ParameterName);
+
+    const int64 ParameterValue = StaticEnum<EZombieParameter>()->GetValueByNameString(ParameterName);
+    if (ParameterValue == INDEX_NONE)
+    {
+        UE_LOG(LogTemp, Error, TEXT("ZombieThreshold: Unknown parameter %s"), *ParameterName);
+        return 1;
+    }
+
+    FZombieThresholdSettings Settings;
+    Settings.Parameter = static_cast<EZombieParameter>(ParameterValue);
+    Settings.Min = ZombieThreshold::GetParameter(BaseModel, Settings.Parameter);
+    Settings.Max = Settings.Min;
+    FParse::Value(*Params, TEXT("Min="), Settings.Min);
+    FParse::Value(*Params, TEXT("Max="), Settings.Max);
+    FParse::Value(*Params, TEXT("Days="), Settings.Days);
+    FParse::Value(*Params, TEXT("Tolerance="), Settings.Tolerance);
+
+    if (Settings.Max <= Settings.Min || Settings.Days <= 0 || Settings.Tolerance <= 0.f)
+    {
+        UE_LOG(LogTemp, Error, TEXT("ZombieThreshold: Needs -Min below -Max, and -Days and -Tolerance above 0"));
+        return 1;
+    }
+
+    const double StartTime = FPlatformTime::Seconds();
+    const FZombieThresholdResult Result = ZombieThreshold::FindLoseThreshold(BaseModel, Settings);
+    const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+    if (!Result.bFound)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ZombieThreshold: %s %s within %d days at both %g and %g (%.2f ms)"),
+            *ParameterName, Result.LoseDay >= 0 ? TEXT("loses") : TEXT("survives"), Settings.Days,
+            Settings.Min, Settings.Max, Elapsed * 1000.0);
+        return 0;
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("ZombieThreshold: %s = %g, loses on day %d at %g and survives %d days at %g"),
+        *ParameterName, Result.Threshold, Result.LoseDay, Result.LosingValue, Settings.Days, Result.SurvivingValue);
+    UE_LOG(LogTemp, Display, TEXT("ZombieThreshold: %d runs in %.2f ms"), Result.NumRuns, Elapsed * 1000.0);
+    return 0;
+}
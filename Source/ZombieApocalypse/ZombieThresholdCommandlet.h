@@ -0,0 +1,25 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ZombieThresholdCommandlet.generated.h"
+
+/**
+ * Finds the value of one parameter at which the game starts losing, for balancing scripts.
+ *
+ * Example:
+ *   UnrealEditor-Cmd ZombieApocalypse.uproject -run=ZombieThreshold -Parameter=Zombies -Min=1 -Max=500 -Days=60
+ *
+ * -Parameter takes the names of the ZombieSweep axes, -Tolerance=<value> sets how close the search gets (default 0.001).
+ * Takes the same -Controller, -Curve and -Table options as ZombieSweep.
+ */
+UCLASS()
+class ZOMBIEAPOCALYPSE_API UZombieThresholdCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UZombieThresholdCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,15 @@
+// Copyright University of Inland Norway
+
+using UnrealBuildTool;
+
+// Editor-only tools for the game module: asset bakes that need editor and plugin modules the game never loads
+public class ZombieApocalypseEditor : ModuleRules
+{
+	public ZombieApocalypseEditor(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine" });
+		PrivateDependencyModuleNames.AddRange(new string[] { "ZombieApocalypse", "UnrealEd", "MaterialEditor", "AnimToTexture" });
+	}
+}
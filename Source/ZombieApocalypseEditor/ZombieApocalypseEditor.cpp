@@ -0,0 +1,6 @@
+// Copyright University of Inland Norway
+
+#include "ZombieApocalypseEditor.h"
+#include "Modules/ModuleManager.h"
+
+IMPLEMENT_MODULE(FDefaultModuleImpl, ZombieApocalypseEditor);
@@ -0,0 +1,5 @@
+// Copyright University of Inland Norway
+
+#pragma once
+
+#include "CoreMinimal.h"
@@ -0,0 +1,322 @@
+#include "ZombieCrowdBakeCommandlet.h"
+#include "ZombieCrowdVisualsAsset.h"
+#include "AnimToTextureBPLibrary.h"
+#include "AnimToTextureDataAsset.h"
+#include "Animation/AnimSequence.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/Texture2D.h"
+#include "MaterialEditingLibrary.h"
+#include "Materials/Material.h"
+#include "Materials/MaterialInstanceConstant.h"
+#include "Materials/MaterialExpressionCustom.h"
+#include "Materials/MaterialExpressionPerInstanceCustomData.h"
+#include "Materials/MaterialExpressionScalarParameter.h"
+#include "Materials/MaterialExpressionTextureCoordinate.h"
+#include "Materials/MaterialExpressionTextureObjectParameter.h"
+#include "Materials/MaterialExpressionTime.h"
+#include "Materials/MaterialExpressionTransform.h"
+#include "Materials/MaterialExpressionVectorParameter.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+namespace ZombieCrowdBake
+{
+    // UV channel AnimToTexture writes the texel of every vertex into, the material reads the same one
+    static constexpr int32 VertexUVChannel = 1;
+
+    // What one EPopulationType is baked from. Bitten agents never walk, so they only get the idle cycle.
+    struct FRecipe
+    {
+        EPopulationType Type;
+        const TCHAR* Name;
+        const TCHAR* SkeletalMesh;
+        const TCHAR* Idle;
+        const TCHAR* Walk;
+        FLinearColor Tint;
+    };
+
+    static const FRecipe Recipes[] =
+    {
+        { EPopulationType::Susceptible, TEXT("Susceptible"), TEXT("/Game/Characters/Girl/Girl.Girl"),
+            TEXT("/Game/Animations/Girls/Idle.Idle"), TEXT("/Game/Animations/Girls/SwaggerWalk.SwaggerWalk"), FLinearColor(0.8f, 0.8f, 0.8f) },
+        { EPopulationType::Bitten, TEXT("Bitten"), TEXT("/Game/Characters/Girl2/Girl2.Girl2"),
+            TEXT("/Game/Animations/Girls/WrithingInPain.WrithingInPain"), nullptr, FLinearColor(0.8f, 0.6f, 0.3f) },
+        { EPopulationType::Zombie, TEXT("Zombie"), TEXT("/Game/Characters/Zombie/Zombie.Zombie"),
+            TEXT("/Game/Animations/Zombie/ZombieIdle1.ZombieIdle1"), TEXT("/Game/Animations/Zombie/ZombieWalking.ZombieWalking"), FLinearColor(0.4f, 0.7f, 0.4f) },
+    };
+
+    // Offset of the vertex in the frame the instance is at, following the formula in UZombieCrowdVisualsAsset.
+    // AnimToTexture stores every frame as RowsPerFrame rows of offsets normalized to the bounds of the bake.
+    static const TCHAR* VertexAnimationCode = TEXT(
+        "float Cycle = frac(Time * FramesPerSecond / max(NumFrames, 1) + Phase);\n"
+        "float Frame = StartFrame + min(floor(Cycle * NumFrames), NumFrames - 1);\n"
+        "float2 FrameUV = UV + float2(0, Frame * RowsPerFrame / TextureHeight);\n"
+        "float3 Offset = Texture2DSampleLevel(PositionTexture, PositionTextureSampler, FrameUV, 0).rgb;\n"
+        "return MinBBox.rgb + Offset * SizeBBox.rgb;\n");
+
+    // Finds the asset of an earlier bake or creates it, so references to it survive a rebake
+    template <typename T>
+    static T* FindOrCreateAsset(const FString& Folder, const FString& Name)
+    {
+        UPackage* Package = CreatePackage(*(Folder / Name));
+        Package->FullyLoad();
+
+        T* Asset = FindObject<T>(Package, *Name);
+        if (!Asset)
+            Asset = NewObject<T>(Package, FName(*Name), RF_Public | RF_Standalone);
+        return Asset;
+    }
+
+    static bool SaveAsset(UObject* Asset)
+    {
+        UPackage* Package = Asset->GetPackage();
+        Package->MarkPackageDirty();
+
+        const FString FileName = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+        FSavePackageArgs SaveArgs;
+        SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+        if (!UPackage::SavePackage(Package, Asset, *FileName, SaveArgs))
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieCrowdBake: Could not save %s"), *FileName);
+            return false;
+        }
+
+        UE_LOG(LogTemp, Display, TEXT("ZombieCrowdBake: Saved %s"), *Package->GetName());
+        return true;
+    }
+
+    template <typename T>
+    static T* AddExpression(UMaterial* Material, int32 X, int32 Y)
+    {
+        return Cast<T>(UMaterialEditingLibrary::CreateMaterialExpression(Material, T::StaticClass(), X, Y));
+    }
+
+    static UMaterialExpressionScalarParameter* AddScalarParameter(UMaterial* Material, const TCHAR* Name, float DefaultValue, int32 Y)
+    {
+        UMaterialExpressionScalarParameter* Parameter = AddExpression<UMaterialExpressionScalarParameter>(Material, -600, Y);
+        Parameter->ParameterName = Name;
+        Parameter->DefaultValue = DefaultValue;
+        return Parameter;
+    }
+
+    static UMaterialExpressionVectorParameter* AddVectorParameter(UMaterial* Material, const TCHAR* Name, const FLinearColor& DefaultValue, int32 Y)
+    {
+        UMaterialExpressionVectorParameter* Parameter = AddExpression<UMaterialExpressionVectorParameter>(Material, -600, Y);
+        Parameter->ParameterName = Name;
+        Parameter->DefaultValue = DefaultValue;
+        return Parameter;
+    }
+
+    // M_ZombieCrowd: tinted surface, world position offset from the position texture at the instance's frame.
+    // Normals stay those of the rest pose, which is enough at crowd distance.
+    static UMaterial* BuildMaterial(const FString& Folder)
+    {
+        UMaterial* Material = FindOrCreateAsset<UMaterial>(Folder, TEXT("M_ZombieCrowd"));
+        UMaterialEditingLibrary::DeleteAllMaterialExpressions(Material);
+
+        bool bNeedsRecompile = false;
+        Material->SetMaterialUsage(bNeedsRecompile, MATUSAGE_InstancedStaticMeshes);
+
+        UMaterialExpressionCustom* Custom = AddExpression<UMaterialExpressionCustom>(Material, -250, 0);
+        Custom->Description = TEXT("ZombieCrowdVertexAnimation");
+        Custom->Code = VertexAnimationCode;
+        Custom->OutputType = CMOT_Float3;
+        Custom->Inputs.Reset();
+
+        const TCHAR* InputNames[] = { TEXT("UV"), TEXT("StartFrame"), TEXT("NumFrames"), TEXT("FramesPerSecond"), TEXT("Phase"), TEXT("Time"),
+            TEXT("RowsPerFrame"), TEXT("TextureHeight"), TEXT("MinBBox"), TEXT("SizeBBox"), TEXT("PositionTexture") };
+        for (const TCHAR* InputName : InputNames)
+        {
+            FCustomInput& Input = Custom->Inputs.AddDefaulted_GetRef();
+            Input.InputName = InputName;
+        }
+
+        UMaterialExpressionTextureCoordinate* VertexUV = AddExpression<UMaterialExpressionTextureCoordinate>(Material, -600, -200);
+        VertexUV->CoordinateIndex = VertexUVChannel;
+        UMaterialEditingLibrary::ConnectMaterialExpressions(VertexUV, FString(), Custom, TEXT("UV"));
+
+        // Custom data 0 to 3 as written by UZombieCrowdVisualsAsset::WriteCustomData
+        const TCHAR* CustomDataInputs[] = { TEXT("StartFrame"), TEXT("NumFrames"), TEXT("FramesPerSecond"), TEXT("Phase") };
+        for (int32 Index = 0; Index < UE_ARRAY_COUNT(CustomDataInputs); ++Index)
+        {
+            UMaterialExpressionPerInstanceCustomData* CustomData = AddExpression<UMaterialExpressionPerInstanceCustomData>(Material, -600, -100 + Index * 60);
+            CustomData->DataIndex = Index;
+            UMaterialEditingLibrary::ConnectMaterialExpressions(CustomData, FString(), Custom, CustomDataInputs[Index]);
+        }
+
+        UMaterialExpressionTime* Time = AddExpression<UMaterialExpressionTime>(Material, -600, 150);
+        UMaterialEditingLibrary::ConnectMaterialExpressions(Time, FString(), Custom, TEXT("Time"));
+
+        UMaterialEditingLibrary::ConnectMaterialExpressions(AddScalarParameter(Material, TEXT("RowsPerFrame"), 1.f, 220), FString(), Custom, TEXT("RowsPerFrame"));
+        UMaterialEditingLibrary::ConnectMaterialExpressions(AddScalarParameter(Material, TEXT("TextureHeight"), 1.f, 290), FString(), Custom, TEXT("TextureHeight"));
+        UMaterialEditingLibrary::ConnectMaterialExpressions(AddVectorParameter(Material, TEXT("MinBBox"), FLinearColor::Black, 360), FString(), Custom, TEXT("MinBBox"));
+        UMaterialEditingLibrary::ConnectMaterialExpressions(AddVectorParameter(Material, TEXT("SizeBBox"), FLinearColor::Black, 500), FString(), Custom, TEXT("SizeBBox"));
+
+        // Offsets are float data, sampled without sRGB
+        UMaterialExpressionTextureObjectParameter* PositionTexture = AddExpression<UMaterialExpressionTextureObjectParameter>(Material, -600, 640);
+        PositionTexture->ParameterName = TEXT("PositionTexture");
+        PositionTexture->Texture = LoadObject<UTexture2D>(nullptr, TEXT("/Engine/EngineResources/Black.Black"));
+        PositionTexture->SamplerType = SAMPLERTYPE_LinearColor;
+        UMaterialEditingLibrary::ConnectMaterialExpressions(PositionTexture, FString(), Custom, TEXT("PositionTexture"));
+
+        // The bake is in the mesh's space, world position offset is in world space
+        UMaterialExpressionTransform* ToWorld = AddExpression<UMaterialExpressionTransform>(Material, 0, 0);
+        ToWorld->TransformSourceType = TRANSFORMSOURCE_Local;
+        ToWorld->TransformType = TRANSFORM_World;
+        UMaterialEditingLibrary::ConnectMaterialExpressions(Custom, FString(), ToWorld, FString());
+        UMaterialEditingLibrary::ConnectMaterialProperty(ToWorld, FString(), MP_WorldPositionOffset);
+
+        UMaterialEditingLibrary::ConnectMaterialProperty(AddVectorParameter(Material, TEXT("Tint"), FLinearColor::White, -300), FString(), MP_BaseColor);
+
+        UMaterialEditingLibrary::RecompileMaterial(Material);
+        return SaveAsset(Material) ? Material : nullptr;
+    }
+
+    static bool AddAnimation(UAnimToTextureDataAsset* DataAsset, const TCHAR* Path)
+    {
+        UAnimSequence* Sequence = LoadObject<UAnimSequence>(nullptr, Path);
+        if (!Sequence)
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieCrowdBake: Could not load animation %s"), Path);
+            return false;
+        }
+
+        FAnimToTextureAnimSequenceInfo& Info = DataAsset->AnimSequences.AddDefaulted_GetRef();
+        Info.bEnabled = true;
+        Info.AnimSequence = Sequence;
+        return true;
+    }
+
+    static FZombieCrowdAnimation MakeAnimation(const FAnimToTextureAnimInfo& Info, float SampleRate)
+    {
+        FZombieCrowdAnimation Animation;
+        Animation.StartFrame = Info.StartFrame;
+        Animation.NumFrames = FMath::Max(Info.EndFrame - Info.StartFrame + 1, 1);
+        Animation.FramesPerSecond = SampleRate;
+        return Animation;
+    }
+
+    static bool Bake(const FRecipe& Recipe, const FString& Folder, float SampleRate, bool bReconvert, UMaterial* Material, FZombieCrowdTypeVisuals& OutVisuals)
+    {
+        USkeletalMesh* SkeletalMesh = LoadObject<USkeletalMesh>(nullptr, Recipe.SkeletalMesh);
+        if (!SkeletalMesh)
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieCrowdBake: Could not load skeletal mesh %s"), Recipe.SkeletalMesh);
+            return false;
+        }
+
+        // The conversion is slow and resets the mesh's UVs and materials, so an earlier one is reused
+        const FString MeshName = FString::Printf(TEXT("SM_Crowd_%s"), Recipe.Name);
+        UStaticMesh* StaticMesh = bReconvert ? nullptr : LoadObject<UStaticMesh>(nullptr, *(Folder / MeshName + TEXT(".") + MeshName), nullptr, LOAD_NoWarn | LOAD_Quiet);
+        if (!StaticMesh)
+            StaticMesh = UAnimToTextureBPLibrary::ConvertSkeletalMeshToStaticMesh(SkeletalMesh, Folder / MeshName);
+        if (!StaticMesh)
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieCrowdBake: Could not convert %s to a static mesh"), Recipe.SkeletalMesh);
+            return false;
+        }
+
+        UAnimToTextureDataAsset* DataAsset = FindOrCreateAsset<UAnimToTextureDataAsset>(Folder, FString::Printf(TEXT("ATT_Crowd_%s"), Recipe.Name));
+        DataAsset->SkeletalMesh = SkeletalMesh;
+        DataAsset->StaticMesh = StaticMesh;
+        DataAsset->Mode = EAnimToTextureMode::Vertex;
+        DataAsset->UVChannel = VertexUVChannel;
+        DataAsset->SampleRate = SampleRate;
+        DataAsset->VertexPositionTexture = FindOrCreateAsset<UTexture2D>(Folder, FString::Printf(TEXT("T_Crowd_%s_Position"), Recipe.Name));
+        DataAsset->VertexNormalTexture = FindOrCreateAsset<UTexture2D>(Folder, FString::Printf(TEXT("T_Crowd_%s_Normal"), Recipe.Name));
+
+        DataAsset->AnimSequences.Reset();
+        if (!AddAnimation(DataAsset, Recipe.Idle) || (Recipe.Walk && !AddAnimation(DataAsset, Recipe.Walk)))
+            return false;
+
+        if (!UAnimToTextureBPLibrary::AnimationToTexture(DataAsset) || DataAsset->Animations.Num() != DataAsset->AnimSequences.Num())
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieCrowdBake: AnimToTexture failed for %s"), Recipe.Name);
+            return false;
+        }
+
+        UTexture2D* PositionTexture = DataAsset->VertexPositionTexture.LoadSynchronous();
+        UMaterialInstanceConstant* Instance = FindOrCreateAsset<UMaterialInstanceConstant>(Folder, FString::Printf(TEXT("MI_Crowd_%s"), Recipe.Name));
+        UMaterialEditingLibrary::SetMaterialInstanceParent(Instance, Material);
+        UMaterialEditingLibrary::SetMaterialInstanceScalarParameterValue(Instance, TEXT("RowsPerFrame"), DataAsset->VertexRowsPerFrame);
+        UMaterialEditingLibrary::SetMaterialInstanceScalarParameterValue(Instance, TEXT("TextureHeight"), static_cast<float>(PositionTexture->Source.GetSizeY()));
+        UMaterialEditingLibrary::SetMaterialInstanceVectorParameterValue(Instance, TEXT("MinBBox"), FLinearColor(FVector(DataAsset->VertexMinBBox)));
+        UMaterialEditingLibrary::SetMaterialInstanceVectorParameterValue(Instance, TEXT("SizeBBox"), FLinearColor(FVector(DataAsset->VertexSizeBBox)));
+        UMaterialEditingLibrary::SetMaterialInstanceTextureParameterValue(Instance, TEXT("PositionTexture"), PositionTexture);
+        UMaterialEditingLibrary::SetMaterialInstanceVectorParameterValue(Instance, TEXT("Tint"), Recipe.Tint);
+        UMaterialEditingLibrary::UpdateMaterialInstance(Instance);
+
+        for (int32 Slot = 0; Slot < StaticMesh->GetStaticMaterials().Num(); ++Slot)
+        {
+            StaticMesh->SetMaterial(Slot, Instance);
+        }
+
+        OutVisuals.Mesh = StaticMesh;
+        OutVisuals.Idle = MakeAnimation(DataAsset->Animations[0], SampleRate);
+        OutVisuals.Walk = Recipe.Walk ? MakeAnimation(DataAsset->Animations[1], SampleRate) : OutVisuals.Idle;
+
+        UE_LOG(LogTemp, Display, TEXT("ZombieCrowdBake: %s idle frames %d-%d, walk frames %d-%d, %d rows per frame"), Recipe.Name,
+            OutVisuals.Idle.StartFrame, OutVisuals.Idle.StartFrame + OutVisuals.Idle.NumFrames - 1,
+            OutVisuals.Walk.StartFrame, OutVisuals.Walk.StartFrame + OutVisuals.Walk.NumFrames - 1, DataAsset->VertexRowsPerFrame);
+
+        return SaveAsset(DataAsset) && SaveAsset(PositionTexture) && SaveAsset(DataAsset->VertexNormalTexture.LoadSynchronous())
+            && SaveAsset(Instance) && SaveAsset(StaticMesh);
+    }
+}
+
+UZombieCrowdBakeCommandlet::UZombieCrowdBakeCommandlet()
+{
+    IsClient = false;
+    IsEditor = true;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 UZombieCrowdBakeCommandlet::Main(const FString& Params)
+{
+    using namespace ZombieCrowdBake;
+
+    FString Folder(TEXT("/Game/Crowd"));
+    FParse::Value(*Params, TEXT("Out="), Folder);
+
+    FText Reason;
+    if (!FPackageName::IsValidLongPackageName(Folder / TEXT("DA_ZombieCrowdVisuals"), false, &Reason))
+    {
+        UE_LOG(LogTemp, Error, TEXT("ZombieCrowdBake: %s is not a content folder: %s"), *Folder, *Reason.ToString());
+        return 1;
+    }
+
+    float SampleRate = 30.f;
+    FParse::Value(*Params, TEXT("SampleRate="), SampleRate);
+    const bool bReconvert = FParse::Param(*Params, TEXT("Reconvert"));
+
+    UMaterial* Material = BuildMaterial(Folder);
+    if (!Material)
+        return 1;
+
+    UZombieCrowdVisualsAsset* Visuals = FindOrCreateAsset<UZombieCrowdVisualsAsset>(Folder, TEXT("DA_ZombieCrowdVisuals"));
+    for (const FRecipe& Recipe : Recipes)
+    {
+        FZombieCrowdTypeVisuals TypeVisuals;
+        if (!Bake(Recipe, Folder, SampleRate, bReconvert, Material, TypeVisuals))
+        {
+            UE_LOG(LogTemp, Error, TEXT("ZombieCrowdBake: FAILED"));
+            return 1;
+        }
+
+        switch (Recipe.Type)
+        {
+        case EPopulationType::Susceptible: Visuals->Susceptible = TypeVisuals; break;
+        case EPopulationType::Bitten: Visuals->Bitten = TypeVisuals; break;
+        case EPopulationType::Zombie: Visuals->Zombie = TypeVisuals; break;
+        }
+    }
+
+    if (!SaveAsset(Visuals))
+        return 1;
+
+    UE_LOG(LogTemp, Display, TEXT("ZombieCrowdBake: Done, set %s as the Visuals of the crowd spawner"), *Visuals->GetPathName());
+    return 0;
+}
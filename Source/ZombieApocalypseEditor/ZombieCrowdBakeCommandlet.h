@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ZombieCrowdBakeCommandlet.generated.h"
+
+/**
+ * Bakes the crowd's vertex animation with the AnimToTexture plugin and fills in a UZombieCrowdVisualsAsset.
+ * For Girl (susceptible), Girl2 (bitten) and Zombie it converts the skeletal mesh to a static mesh, bakes the
+ * idle and walk cycles into a position texture, and gives the mesh a material instance of M_ZombieCrowd, the
+ * material that plays the cycle from the instance's custom data (see UZombieCrowdVisualsAsset). The material
+ * is built here as well, so every asset the crowd needs comes out of this one step.
+ *
+ * Example:
+ *   UnrealEditor-Cmd ZombieApocalypse.uproject -run=ZombieCrowdBake -Out=/Game/Crowd
+ *
+ *   -Out=<path>          Folder the assets are written to (default /Game/Crowd)
+ *   -SampleRate=<float>  Frames baked per second of animation (default 30)
+ *   -Reconvert           Convert the skeletal meshes again even if the static meshes already exist
+ * Assets of an earlier bake are updated in place, so references to them stay valid.
+ */
+UCLASS()
+class ZOMBIEAPOCALYPSEEDITOR_API UZombieCrowdBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UZombieCrowdBakeCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};